@@ -1,7 +1,9 @@
 #pragma once
 #include "include/cef_app.h"
+#include "include/cef_browser_process_handler.h"
 #include "include/cef_render_process_handler.h"
 #include "include/wrapper/cef_message_router.h"
+#include "internal/binaryipc.hpp"
 
 // Render process handler for message router
 class SimpleRenderProcessHandler : public CefRenderProcessHandler {
@@ -24,18 +26,27 @@ public:
 
 private:
     CefRefPtr<CefMessageRouterRendererSide> message_router_;
+    SimpleIPC::BinaryIPCRenderer binary_ipc_;
     IMPLEMENT_REFCOUNTING(SimpleRenderProcessHandler);
 };
 
-class SimpleApp : public CefApp {
+class SimpleApp : public CefApp,
+                  public CefBrowserProcessHandler {
 public:
     SimpleApp();
     
     // CefApp methods
+    CefRefPtr<CefBrowserProcessHandler> GetBrowserProcessHandler() override {
+        return this;
+    }
+    
     CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() override {
         return render_process_handler_;
     }
     
+    // CefBrowserProcessHandler methods (external message pump)
+    void OnScheduleMessagePumpWork(int64_t delay_ms) override;
+    
     // Override to add command line switches for Window Controls Overlay
     void OnBeforeCommandLineProcessing(const CefString& process_type,
                                      CefRefPtr<CefCommandLine> command_line) override;
@@ -0,0 +1,143 @@
+#include "background_policy.hpp"
+#include "logger.hpp"
+#include "internal/commandregistry.hpp"
+#include "include/cef_task.h"
+#include "include/cef_values.h"
+#include "include/views/cef_browser_view.h"
+#include "include/views/cef_window.h"
+#include "include/wrapper/cef_helpers.h"
+#include <chrono>
+
+// How often hidden windows are checked against the freeze delay
+static const int kCheckIntervalMs = 5000;
+
+static int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class BackgroundCheckTask : public CefTask {
+public:
+    void Execute() override {
+        BackgroundPolicy::GetInstance().Update();
+        CefPostDelayedTask(TID_UI, new BackgroundCheckTask(), kCheckIntervalMs);
+    }
+
+private:
+    IMPLEMENT_REFCOUNTING(BackgroundCheckTask);
+};
+
+namespace {
+    // ipc_call:set_background_mode:<throttle|keep-running> for the requesting window
+    bool HandleSetBackgroundMode(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (request.argument != "throttle" && request.argument != "keep-running") {
+            result = "Expected throttle or keep-running";
+            return false;
+        }
+        if (!request.browser) {
+            result = "No browser";
+            return false;
+        }
+        BackgroundPolicy::GetInstance().SetKeepRunning(request.browser, request.argument == "keep-running");
+        return true;
+    }
+}
+
+BackgroundPolicy::BackgroundPolicy()
+    : freeze_delay_ms_(0), started_(false) {
+}
+
+BackgroundPolicy::~BackgroundPolicy() {
+}
+
+BackgroundPolicy& BackgroundPolicy::GetInstance() {
+    static BackgroundPolicy instance;
+    return instance;
+}
+
+void BackgroundPolicy::Configure(int freeze_delay_ms) {
+    freeze_delay_ms_ = freeze_delay_ms;
+    Logger::LogMessage("BackgroundPolicy: Freezing hidden windows after " + std::to_string(freeze_delay_ms) + " ms" +
+                       (freeze_delay_ms > 0 ? "" : " (disabled)"));
+}
+
+void BackgroundPolicy::Start() {
+    if (started_ || freeze_delay_ms_ <= 0) {
+        return;
+    }
+    started_ = true;
+    CefPostDelayedTask(TID_UI, new BackgroundCheckTask(), kCheckIntervalMs);
+}
+
+void BackgroundPolicy::AddBrowser(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+    BrowserState state = { browser, false, false, 0 };
+    browsers_[browser->GetIdentifier()] = state;
+}
+
+void BackgroundPolicy::RemoveBrowser(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+    browsers_.erase(browser->GetIdentifier());
+}
+
+void BackgroundPolicy::OnWindowStateChanged() {
+    Update();
+}
+
+void BackgroundPolicy::SetKeepRunning(CefRefPtr<CefBrowser> browser, bool keep_running) {
+    CEF_REQUIRE_UI_THREAD();
+    auto it = browsers_.find(browser->GetIdentifier());
+    if (it == browsers_.end()) {
+        return;
+    }
+    it->second.keep_running = keep_running;
+    Logger::LogMessage("BackgroundPolicy: Browser " + std::to_string(browser->GetIdentifier()) +
+                       (keep_running ? " keeps running in the background" : " is throttled in the background"));
+    Update();
+}
+
+bool BackgroundPolicy::IsHidden(CefRefPtr<CefBrowser> browser) {
+    CefRefPtr<CefBrowserView> browser_view = CefBrowserView::GetForBrowser(browser);
+    CefRefPtr<CefWindow> window = browser_view ? browser_view->GetWindow() : nullptr;
+    return !window || !window->IsVisible() || window->IsMinimized();
+}
+
+void BackgroundPolicy::Update() {
+    if (freeze_delay_ms_ <= 0) {
+        return;
+    }
+
+    int64_t now = NowMs();
+    for (auto& entry : browsers_) {
+        BrowserState& state = entry.second;
+        if (!IsHidden(state.browser)) {
+            state.hidden_since_ms = 0;
+            SetFrozen(state, false);
+            continue;
+        }
+        if (state.hidden_since_ms == 0) {
+            state.hidden_since_ms = now;
+        }
+        bool idle = now - state.hidden_since_ms >= freeze_delay_ms_;
+        SetFrozen(state, idle && !state.keep_running);
+    }
+}
+
+// Page lifecycle freezing, as Chromium does for long-hidden tabs: task queues
+// stop until the page is made active again, and IPC replies wait until then
+void BackgroundPolicy::SetFrozen(BrowserState& state, bool frozen) {
+    if (state.frozen == frozen) {
+        return;
+    }
+    state.frozen = frozen;
+
+    CefRefPtr<CefDictionaryValue> params = CefDictionaryValue::Create();
+    params->SetString("state", frozen ? "frozen" : "active");
+    state.browser->GetHost()->ExecuteDevToolsMethod(0, "Page.setWebLifecycleState", params);
+    Logger::LogVerbose("BackgroundPolicy: Browser " + std::to_string(state.browser->GetIdentifier()) +
+                       (frozen ? " frozen" : " resumed"));
+}
+
+void BackgroundPolicy::RegisterCommands() {
+    SimpleIPC::CommandRegistry::GetInstance().Register("set_background_mode", HandleSetBackgroundMode);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "include/cef_browser.h"
+#include <map>
+
+// Background policy for IDE windows.
+//
+// Chromium itself throttles the timers of hidden, minimised and occluded
+// windows (1 Hz, then once a minute after 5 minutes) and lowers the priority
+// of renderers that only host hidden pages. On top of that, a window that
+// stays minimised or hidden for longer than the freeze delay is frozen (no
+// timers, tasks or animations) until it is shown again.
+//
+// A window running a build or another long task can opt out with
+// nativeAPI.call('set_background_mode', 'keep-running'); it is then never
+// frozen. Chromium's own timer throttling cannot be lifted per page, so such
+// pages should drive their background work from IPC events or a worker,
+// neither of which is throttled.
+class BackgroundPolicy {
+public:
+    // Singleton access
+    static BackgroundPolicy& GetInstance();
+
+    // Freeze windows hidden for |freeze_delay_ms|; 0 disables freezing
+    void Configure(int freeze_delay_ms);
+
+    // UI thread: start periodic checks
+    void Start();
+
+    // UI thread, from SimpleClient
+    void AddBrowser(CefRefPtr<CefBrowser> browser);
+    void RemoveBrowser(CefRefPtr<CefBrowser> browser);
+
+    // UI thread, from the window delegates: re-evaluate immediately so a
+    // restored window is unfrozen before its first frame
+    void OnWindowStateChanged();
+
+    // Register the set_background_mode query with the CommandRegistry
+    static void RegisterCommands();
+
+    void SetKeepRunning(CefRefPtr<CefBrowser> browser, bool keep_running);
+
+private:
+    struct BrowserState {
+        CefRefPtr<CefBrowser> browser;
+        bool keep_running;
+        bool frozen;
+        int64_t hidden_since_ms;    // 0 while visible
+    };
+
+    BackgroundPolicy();
+    ~BackgroundPolicy();
+    BackgroundPolicy(const BackgroundPolicy&);
+    BackgroundPolicy& operator=(const BackgroundPolicy&);
+
+    void Update();
+    void SetFrozen(BrowserState& state, bool frozen);
+    static bool IsHidden(CefRefPtr<CefBrowser> browser);
+
+    friend class BackgroundCheckTask;
+
+    std::map<int, BrowserState> browsers_;   // By browser identifier
+    int freeze_delay_ms_;
+    bool started_;
+};
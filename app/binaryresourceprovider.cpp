@@ -1,8 +1,8 @@
 #include "binaryresourceprovider.hpp"
 #include "resourceutil.hpp"
-#include "include/cef_response.h"
-#include "include/cef_stream.h"
-#include "include/wrapper/cef_stream_resource_handler.h"
+#include "embeddedresourcehandler.hpp"
+#include "startup_cache.hpp"
+#include "ipc_benchmark.hpp"
 #include "logger.hpp"
 #include <string>
 
@@ -18,62 +18,58 @@ CefRefPtr<CefResourceHandler> BinaryResourceProvider::Create(
     CEF_REQUIRE_IO_THREAD();
     
     std::string url = request->GetURL();
-    Logger::LogMessage("BinaryResourceProvider: Handling URL: " + url);
+    Logger::LogVerbose("BinaryResourceProvider: Handling URL: " + url);
     
     // Only handle miko://app requests
     if (url.find("miko://app") != 0) {
-        Logger::LogMessage("BinaryResourceProvider: URL does not start with miko://app");
+        Logger::LogVerbose("BinaryResourceProvider: URL does not start with miko://app");
         return nullptr;
     }
     
-    // Extract the path from the URL (remove "miko://app")
+    // Extract the path from the URL (remove "miko://app", query and fragment)
     std::string path = url.substr(10); // Remove "miko://app"
+    size_t query_pos = path.find_first_of("?#");
+    if (query_pos != std::string::npos) {
+        path.erase(query_pos);
+    }
     if (path.empty() || path == "/") {
         path = "/index.html";
     }
-    Logger::LogMessage("BinaryResourceProvider: Extracted path: " + path);
+    Logger::LogVerbose("BinaryResourceProvider: Extracted path: " + path);
     
-    // For single-file HTML build, all requests should go to index.html
-    // since CSS and JS are inlined
-    std::string actualPath = path;
-    if (path != "/index.html") {
-        // Redirect all other requests to index.html for single-file build
-        actualPath = "/index.html";
-        Logger::LogMessage("BinaryResourceProvider: Redirecting " + path + " to " + actualPath + " (single-file build)");
+    // Built-in IPC benchmark page (only served with --ipc-benchmark)
+    if (const ResourceUtil::PreloadedResource* benchmarkPage = IPCBenchmark::GetPage(path)) {
+        return new EmbeddedResourceHandler(*benchmarkPage);
     }
     
-    // Try to get preloaded resource first
-    const ResourceUtil::PreloadedResource* preloaded = ResourceUtil::GetPreloadedResource(actualPath);
-    std::vector<uint8_t> resource_data;
+    // Snapshot the published bundle once for this request (lock-free)
+    const ResourceUtil::ResourceBundle* bundle = ResourceUtil::GetResourceBundle();
     
-    if (preloaded && preloaded->loaded) {
-        Logger::LogMessage("BinaryResourceProvider: Using preloaded resource for path: " + actualPath);
-        resource_data = preloaded->data;
-    } else {
-        // Fallback to traditional resource loading
-        int resource_id = ResourceUtil::GetResourceId(actualPath);
-        Logger::LogMessage("BinaryResourceProvider: Resource ID: " + std::to_string(resource_id));
-        if (resource_id == -1) {
-            Logger::LogMessage("BinaryResourceProvider: Resource not found for path: " + actualPath);
-            return nullptr; // Resource not found
-        }
-        
-        resource_data = ResourceUtil::LoadBinaryResource(resource_id);
-        if (resource_data.empty()) {
-            Logger::LogMessage("BinaryResourceProvider: Failed to load resource data for path: " + actualPath);
-            return nullptr;
-        }
+    // Assets are embedded individually; client-side routes (no file extension)
+    // that are not part of the bundle fall back to the entry document
+    std::string actualPath = path;
+    const ResourceUtil::PreloadedResource* preloaded = bundle->Find(path);
+    if (!preloaded &&
+        path.find('.', path.find_last_of('/')) == std::string::npos) {
+        actualPath = "/index.html";
+        Logger::LogVerbose("BinaryResourceProvider: Routing " + path + " to " + actualPath + " (SPA fallback)");
+        preloaded = bundle->Find(actualPath);
     }
     
-    // Create stream reader
-    CefRefPtr<CefStreamReader> stream = ResourceUtil::CreateResourceReader(resource_data);
-    if (!stream) {
-        return nullptr;
+    if (!preloaded) {
+        Logger::LogError("BinaryResourceProvider: Resource not found for path: " + actualPath);
+        return nullptr; // Resource not found
     }
     
-    // Get MIME type (always HTML for single-file build)
-    std::string mime_type = ResourceUtil::GetMimeType(actualPath);
+    // Once a startup profile exists, the entry document also preloads the recorded chunks
+    if (actualPath == "/index.html" && bundle->embedded) {
+        const ResourceUtil::PreloadedResource* warmIndex = StartupCache::GetWarmIndex();
+        if (warmIndex) {
+            preloaded = warmIndex;
+        }
+    }
+    StartupCache::NoteRequest(actualPath);
     
-    // Create and return the resource handler
-    return new CefStreamResourceHandler(mime_type, stream);
+    // Stream straight out of the embedded bundle, decoding compressed assets on the fly
+    return new EmbeddedResourceHandler(*preloaded);
 }
\ No newline at end of file
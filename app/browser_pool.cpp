@@ -0,0 +1,187 @@
+#include "browser_pool.hpp"
+#include "background_policy.hpp"
+#include "client.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include "loading_manager.hpp"
+#include "settings.hpp"
+#include "include/cef_task.h"
+#include "include/views/cef_browser_view.h"
+#include "include/views/cef_browser_view_delegate.h"
+#include "include/views/cef_window_delegate.h"
+#include "include/wrapper/cef_helpers.h"
+#include <algorithm>
+
+// Global variables
+extern CefRefPtr<SimpleClient> g_client;
+
+// Delay between two spares, so they never compete with each other or the UI
+static const int kRefillIntervalMs = 2000;
+
+class RefillTask : public CefTask {
+public:
+    void Execute() override { BrowserPool::GetInstance().Refill(); }
+
+private:
+    IMPLEMENT_REFCOUNTING(RefillTask);
+};
+
+// Spawned windows hide the Chrome toolbar like the main window
+class PooledBrowserViewDelegate : public CefBrowserViewDelegate {
+public:
+    ChromeToolbarType GetChromeToolbarType(CefRefPtr<CefBrowserView> browser_view) override {
+        return CEF_CTT_NONE;
+    }
+
+private:
+    IMPLEMENT_REFCOUNTING(PooledBrowserViewDelegate);
+};
+
+// Spawned windows keep the system frame and closing one does not quit the app
+class PooledWindowDelegate : public CefWindowDelegate {
+public:
+    bool IsFrameless(CefRefPtr<CefWindow> window) override { return false; }
+    bool CanResize(CefRefPtr<CefWindow> window) override { return true; }
+    bool CanClose(CefRefPtr<CefWindow> window) override { return true; }
+
+    void OnWindowActivationChanged(CefRefPtr<CefWindow> window, bool active) override {
+        BackgroundPolicy::GetInstance().OnWindowStateChanged();
+    }
+
+    CefSize GetPreferredSize(CefRefPtr<CefView> view) override {
+        const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+        return CefSize(config.window_width, config.window_height);
+    }
+
+    CefSize GetMinimumSize(CefRefPtr<CefView> view) override {
+        return CefSize(MIN_WINDOW_WIDTH, MIN_WINDOW_HEIGHT);
+    }
+
+private:
+    IMPLEMENT_REFCOUNTING(PooledWindowDelegate);
+};
+
+BrowserPool::BrowserPool()
+    : size_(0), memory_cap_mb_(0), refill_pending_(false), shut_down_(false) {
+}
+
+BrowserPool::~BrowserPool() {
+}
+
+BrowserPool& BrowserPool::GetInstance() {
+    static BrowserPool instance;
+    return instance;
+}
+
+void BrowserPool::Configure(size_t size, size_t memory_cap_mb) {
+    size_ = size;
+    memory_cap_mb_ = memory_cap_mb;
+    Logger::LogMessage("BrowserPool: " + std::to_string(GetTargetSize()) + " spare window(s), memory cap " +
+                       std::to_string(memory_cap_mb) + " MB");
+}
+
+size_t BrowserPool::GetTargetSize() const {
+    return std::min(size_, memory_cap_mb_ / kEstimatedSpareMb);
+}
+
+// Hidden window with a browser already navigating to the startup URL
+CefRefPtr<CefWindow> BrowserPool::CreateSpareWindow() {
+    const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+    CefBrowserSettings browser_settings;
+    browser_settings.javascript_access_clipboard = config.javascript_clipboard ? STATE_ENABLED : STATE_DISABLED;
+    browser_settings.javascript_dom_paste = config.javascript_clipboard ? STATE_ENABLED : STATE_DISABLED;
+    browser_settings.local_storage = config.local_storage ? STATE_ENABLED : STATE_DISABLED;
+    browser_settings.javascript_close_windows = STATE_DISABLED;
+    browser_settings.background_color = APP_BACKGROUND_COLOR;
+
+    CefRefPtr<CefBrowserView> browser_view = CefBrowserView::CreateBrowserView(
+        new SimpleClient(), AppConfig::GetStartupUrl(), browser_settings, nullptr, nullptr,
+        new PooledBrowserViewDelegate());
+
+    CefRefPtr<CefWindow> window = CefWindow::CreateTopLevelWindow(new PooledWindowDelegate());
+    window->AddChildView(browser_view);
+    window->SetTitle("SwipeIDE - New Window");
+    window->SetBackgroundColor(APP_BACKGROUND_COLOR);
+    return window;
+}
+
+void BrowserPool::SpawnWindow() {
+    CEF_REQUIRE_UI_THREAD();
+
+    CefRefPtr<CefWindow> window;
+    while (!spares_.empty() && !window) {
+        window = spares_.front();
+        spares_.pop_front();
+        if (window->IsClosed()) {
+            window = nullptr;
+        }
+    }
+
+    if (window) {
+        Logger::LogMessage("BrowserPool: Spawning window from pool (" + std::to_string(spares_.size()) + " left)");
+    } else {
+        Logger::LogMessage("BrowserPool: Pool empty, spawning cold window");
+        window = CreateSpareWindow();
+    }
+
+    // Remembered so Shutdown() can close it; forget the ones closed since
+    spawned_.erase(std::remove_if(spawned_.begin(), spawned_.end(),
+                                  [](const CefRefPtr<CefWindow>& spawned) { return spawned->IsClosed(); }),
+                   spawned_.end());
+    spawned_.push_back(window);
+
+    const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+    window->CenterWindow(CefSize(config.window_width, config.window_height));
+    window->Show();
+    window->Activate();
+
+    ScheduleRefill(kRefillIntervalMs);
+}
+
+void BrowserPool::ScheduleRefill(int delay_ms) {
+    if (shut_down_ || refill_pending_ || GetTargetSize() == 0) {
+        return;
+    }
+    refill_pending_ = true;
+    CefPostDelayedTask(TID_UI, new RefillTask(), delay_ms);
+}
+
+void BrowserPool::Refill() {
+    refill_pending_ = false;
+    if (shut_down_ || spares_.size() >= GetTargetSize()) {
+        return;
+    }
+
+    // Wait for the main window and whatever it is loading; a spare started now
+    // would slow down exactly what the user is waiting for
+    CefRefPtr<CefBrowser> main_browser = g_client ? g_client->GetFirstBrowser() : nullptr;
+    if (LoadingManager::GetInstance().GetState() != LoadingManager::READY ||
+        (main_browser && main_browser->IsLoading())) {
+        ScheduleRefill(kRefillIntervalMs);
+        return;
+    }
+
+    spares_.push_back(CreateSpareWindow());
+    Logger::LogMessage("BrowserPool: Prewarmed spare window (" + std::to_string(spares_.size()) + "/" +
+                       std::to_string(GetTargetSize()) + ")");
+
+    if (spares_.size() < GetTargetSize()) {
+        ScheduleRefill(kRefillIntervalMs);
+    }
+}
+
+void BrowserPool::Shutdown() {
+    shut_down_ = true;
+    for (CefRefPtr<CefWindow>& window : spares_) {
+        if (!window->IsClosed()) {
+            window->Close();
+        }
+    }
+    for (CefRefPtr<CefWindow>& window : spawned_) {
+        if (!window->IsClosed()) {
+            window->Close();
+        }
+    }
+    spares_.clear();
+    spawned_.clear();
+}
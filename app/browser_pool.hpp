@@ -0,0 +1,55 @@
+#pragma once
+
+#include "include/views/cef_window.h"
+#include <deque>
+#include <vector>
+
+// Pool of hidden, pre-navigated IDE windows for SpawnNewWindow.
+//
+// A spare is a complete top-level window whose browser (and renderer process)
+// has already loaded the startup URL, so spawning a window only has to show
+// it. The pool is topped up one spare at a time once the app has settled, and
+// never holds more spares than the memory cap allows.
+class BrowserPool {
+public:
+    // Rough resident cost of one spare (renderer with the app loaded)
+    static const size_t kEstimatedSpareMb = 150;
+
+    // Singleton access
+    static BrowserPool& GetInstance();
+
+    // Before the first refill. A size of 0 disables the pool.
+    void Configure(size_t size, size_t memory_cap_mb);
+
+    // UI thread: open a new IDE window, taking a spare when one is available
+    void SpawnWindow();
+
+    // UI thread: top the pool up |delay_ms| from now, or later if the app is busy
+    void ScheduleRefill(int delay_ms);
+
+    // UI thread: close the spares and every spawned window. Closing is
+    // asynchronous; keep the message loop running until
+    // SimpleClient::GetOpenBrowserCount() drops to 0 before CefShutdown().
+    void Shutdown();
+
+    size_t GetSpareCount() const { return spares_.size(); }
+
+private:
+    BrowserPool();
+    ~BrowserPool();
+    BrowserPool(const BrowserPool&);
+    BrowserPool& operator=(const BrowserPool&);
+
+    CefRefPtr<CefWindow> CreateSpareWindow();
+    size_t GetTargetSize() const;
+    void Refill();
+
+    friend class RefillTask;
+
+    std::deque<CefRefPtr<CefWindow>> spares_;
+    std::vector<CefRefPtr<CefWindow>> spawned_;     // Shown by SpawnWindow, maybe closed since
+    size_t size_;
+    size_t memory_cap_mb_;
+    bool refill_pending_;
+    bool shut_down_;
+};
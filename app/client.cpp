@@ -1,14 +1,24 @@
 #include "client.hpp"
+#include "background_policy.hpp"
+#include "browser_pool.hpp"
 #include "config.hpp"
 #include "logger.hpp"
 #include "resourceutil.hpp"
 #include "loading_manager.hpp"
+#include "memory_monitor.hpp"
+#include "startup_cache.hpp"
+#include "startup_trace.hpp"
 #include "internal/simpleipc.hpp"
+#include "internal/binaryipc.hpp"
+#include "internal/eventbus.hpp"
+#include "internal/commandregistry.hpp"
 #include "window_mode_manager.hpp"
 #include "include/wrapper/cef_helpers.h"
 #include "include/cef_app.h"
+#include "include/views/cef_browser_view.h"
 #include "include/views/cef_window.h"
 #include <SDL3/SDL.h>
+#include <string_view>
 
 // Cross-platform includes
 #ifdef _WIN32
@@ -19,6 +29,9 @@
 extern SDL_Window* g_sdl_window;
 extern CefRefPtr<CefWindow> g_cef_window;
 
+// Browsers of all clients between OnAfterCreated and OnBeforeClose (UI thread)
+static int g_open_browsers = 0;
+
 // CloseBrowserTask implementation
 CloseBrowserTask::CloseBrowserTask(CefRefPtr<SimpleClient> client, bool force_close)
     : client_(client), force_close_(force_close) {
@@ -28,6 +41,163 @@ void CloseBrowserTask::Execute() {
     client_->DoCloseAllBrowsers(force_close_);
 }
 
+// Task that reloads a browser after the current query has been answered
+class ReloadBrowserTask : public CefTask {
+public:
+    explicit ReloadBrowserTask(CefRefPtr<CefBrowser> browser) : browser_(browser) {}
+    void Execute() override { browser_->ReloadIgnoreCache(); }
+
+private:
+    CefRefPtr<CefBrowser> browser_;
+    IMPLEMENT_REFCOUNTING(ReloadBrowserTask);
+};
+
+// Window and browser commands sent by the page through cefQuery
+namespace {
+    // The top-level window hosting |browser|; calls from the binary channel
+    // carry no browser and drive the main window
+    CefRefPtr<CefWindow> GetWindowFor(CefRefPtr<CefBrowser> browser) {
+        if (!browser) {
+            return g_cef_window;
+        }
+        CefRefPtr<CefBrowserView> browser_view = CefBrowserView::GetForBrowser(browser);
+        return browser_view ? browser_view->GetWindow() : nullptr;
+    }
+
+    bool HandleMinimizeWindow(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        window->Minimize();
+        return true;
+    }
+
+    bool HandleMaximizeWindow(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        window->Maximize();
+        return true;
+    }
+
+    bool HandleRestoreWindow(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        window->Restore();
+        return true;
+    }
+
+    bool HandleCloseWindow(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        window->Close();
+        return true;
+    }
+
+    bool HandleGetWindowState(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        if (window->IsMaximized()) {
+            result = "maximized";
+        } else if (window->IsMinimized()) {
+            result = "minimized";
+        } else {
+            result = "normal";
+        }
+        return true;
+    }
+
+    bool HandleIsWindowMaximized(const SimpleIPC::CommandRequest& request, std::string& result) {
+        CefRefPtr<CefWindow> window = GetWindowFor(request.browser);
+        if (!window) {
+            result = "No window available";
+            return false;
+        }
+        result = window->IsMaximized() ? "true" : "false";
+        return true;
+    }
+
+    bool HandleGetWindowControlsInfo(const SimpleIPC::CommandRequest& request, std::string& result) {
+        // Return information about window controls - use web-based controls for now
+        result = "{";
+        result += "\"hasNativeControls\": false,";  // Use web-based controls
+        result += "\"useWebControls\": true,";
+        result += "\"platform\": \"";
+#ifdef _WIN32
+        result += "windows";
+#elif defined(__APPLE__)
+        result += "macos";
+#else
+        result += "linux";
+#endif
+        result += "\",";
+        result += "\"controlsPosition\": \"";
+#ifdef __APPLE__
+        result += "left";  // macOS has controls on the left
+#else
+        result += "right"; // Windows and Linux have controls on the right
+#endif
+        result += "\"";
+        result += "}";
+        return true;
+    }
+
+    bool HandleSpawnNewWindow(const SimpleIPC::CommandRequest& request, std::string& result) {
+        // Create a new browser window from the client of the requesting browser
+        CefRefPtr<CefClient> client = request.browser->GetHost()->GetClient();
+        static_cast<SimpleClient*>(client.get())->SpawnNewWindow();
+        return true;
+    }
+
+    bool HandleReloadResources(const SimpleIPC::CommandRequest& request, std::string& result) {
+        // Hot-swap the resource bundle from the dev bundle directory and reload
+        if (!ResourceUtil::ReloadResources()) {
+            result = "Resource reload failed (is --dev-bundle-dir set?)";
+            return false;
+        }
+        CefPostTask(TID_UI, new ReloadBrowserTask(request.browser));
+        return true;
+    }
+
+    bool HandleCreateNewFile(const SimpleIPC::CommandRequest& request, std::string& result) {
+        // Pages that predate the event bus still get the old global callback
+        if (!SimpleIPC::EventBus::GetInstance().Publish(request.browser->GetIdentifier(), "app.createNewFile", "{}")) {
+            CefRefPtr<CefFrame> main_frame = request.browser->GetMainFrame();
+            main_frame->ExecuteJavaScript(
+                "if (window.createNewFileFromCEF) { window.createNewFileFromCEF(); }",
+                main_frame->GetURL(), 0);
+        }
+        return true;
+    }
+}
+
+void SimpleClient::RegisterCommands() {
+    SimpleIPC::CommandRegistry& registry = SimpleIPC::CommandRegistry::GetInstance();
+    registry.Register("minimize_window", HandleMinimizeWindow);
+    registry.Register("maximize_window", HandleMaximizeWindow);
+    registry.Register("restore_window", HandleRestoreWindow);
+    registry.Register("close_window", HandleCloseWindow);
+    registry.Register("get_window_state", HandleGetWindowState);
+    registry.Register("is_window_maximized", HandleIsWindowMaximized);
+    registry.Register("get_window_controls_info", HandleGetWindowControlsInfo);
+    registry.Register("spawn_new_window", HandleSpawnNewWindow);
+    registry.Register("reload_resources", HandleReloadResources);
+    registry.Register("create_new_file", HandleCreateNewFile);
+}
+
 // SimpleClient implementation
 SimpleClient::SimpleClient() {
     // Note: Resources are now preloaded in main.cpp before client creation
@@ -36,6 +206,7 @@ SimpleClient::SimpleClient() {
     CefMessageRouterConfig config;
     message_router_ = CefMessageRouterBrowserSide::Create(config);
     message_router_->AddHandler(this, false);
+    message_router_->AddHandler(&SimpleIPC::EventBus::GetInstance(), false);
     
     // Create the binary resource provider for miko:// protocol
     resource_provider_ = new BinaryResourceProvider();
@@ -81,151 +252,87 @@ bool SimpleClient::OnQuery(CefRefPtr<CefBrowser> browser,
                           CefRefPtr<CefMessageRouterBrowserSide::Callback> callback) {
     CEF_REQUIRE_UI_THREAD();
     
-    std::string request_str = request.ToString();
-    
-    if (request_str == "minimize_window") {
-        if (g_cef_window) {
-            g_cef_window->Minimize();
-            callback->Success("");
-            return true;
-        }
-    }
-    else if (request_str == "maximize_window") {
-        if (g_cef_window) {
-            g_cef_window->Maximize();
-            callback->Success("");
-            return true;
-        }
-    }
-    else if (request_str == "restore_window") {
-        if (g_cef_window) {
-            g_cef_window->Restore();
-            callback->Success("");
-            return true;
-        }
-    }
-    else if (request_str == "close_window") {
-        if (g_cef_window) {
-            g_cef_window->Close();
-            callback->Success("");
-            return true;
-        }
-    }
-    else if (request_str == "get_window_state") {
-        if (g_cef_window) {
-            if (g_cef_window->IsMaximized()) {
-                callback->Success("maximized");
-            } else if (g_cef_window->IsMinimized()) {
-                callback->Success("minimized");
-            } else {
-                callback->Success("normal");
-            }
-            return true;
-        }
-    }
-    else if (request_str == "is_window_maximized") {
-        if (g_cef_window) {
-            callback->Success(g_cef_window->IsMaximized() ? "true" : "false");
-            return true;
-        }
-    }
-    else if (request_str == "get_window_controls_info") {
-        // Return information about window controls - use web-based controls for now
-        std::string info = "{";
-        info += "\"hasNativeControls\": false,";  // Use web-based controls
-        info += "\"useWebControls\": true,";
-        info += "\"platform\": \"";
-#ifdef _WIN32
-        info += "windows";
-#elif defined(__APPLE__)
-        info += "macos";
-#else
-        info += "linux";
-#endif
-        info += "\",";
-        info += "\"controlsPosition\": \"";
-#ifdef __APPLE__
-        info += "left";  // macOS has controls on the left
-#else
-        info += "right"; // Windows and Linux have controls on the right
-#endif
-        info += "\"";
-        info += "}";
-        callback->Success(info);
-        return true;
-    }
-    else if (request_str == "toggle_window_mode") {
-        if (g_cef_window && WindowModeManager::CanToggleMode()) {
-            WindowModeManager::ToggleWindowMode(g_cef_window);
-            callback->Success(WindowModeManager::GetModeString());
-            return true;
+    SimpleIPC::CommandRequest command_request;
+    command_request.browser = browser;
+    command_request.frame = frame;
+    
+    // Plain commands ("minimize_window") and IPC calls ("ipc_call:method:message")
+    // share one registry. The prefix and name are matched on the UTF-16 request in
+    // place; only the message of an IPC call is converted to UTF-8.
+    constexpr std::string_view kIpcCallPrefix = "ipc_call:";
+    const char16_t* text = request.c_str();
+    size_t length = request.length();
+    bool ipc_call = SimpleIPC::StartsWithAscii(text, length, kIpcCallPrefix);
+    size_t name_begin = ipc_call ? kIpcCallPrefix.size() : 0;
+    size_t name_end = length;
+    std::string argument;
+    if (ipc_call) {
+        name_end = name_begin;
+        while (name_end < length && text[name_end] != u':') {
+            ++name_end;
         }
-        callback->Failure(0, "Cannot toggle window mode");
-        return true;
-    }
-    else if (request_str == "get_window_mode") {
-        if (g_cef_window) {
-            callback->Success(WindowModeManager::GetModeString());
-            return true;
+        if (name_end < length) {
+            argument = CefString(text + name_end + 1, length - name_end - 1, false).ToString();
+            command_request.argument = argument;
         }
-        callback->Failure(0, "No window available");
-        return true;
     }
-    else if (request_str == "set_windowed_mode") {
-        if (g_cef_window) {
-            WindowModeManager::SetWindowedMode(g_cef_window);
-            callback->Success("windowed");
-            return true;
-        }
-        callback->Failure(0, "No window available");
-        return true;
+    
+    char name_buffer[SimpleIPC::kMaxCommandLength];
+    const SimpleIPC::Command* command = nullptr;
+    std::string_view name;
+    if (SimpleIPC::NarrowAscii(text + name_begin, name_end - name_begin, name_buffer, sizeof(name_buffer))) {
+        name = std::string_view(name_buffer, name_end - name_begin);
+        command = SimpleIPC::CommandRegistry::GetInstance().Find(name);
     }
-    else if (request_str == "set_borderless_mode") {
-        if (g_cef_window) {
-            WindowModeManager::SetBorderlessMode(g_cef_window);
-            callback->Success("borderless");
+    if (!command) {
+        if (ipc_call) {
+            std::string method = CefString(text + name_begin, name_end - name_begin, false).ToString();
+            callback->Success("Error: Unknown method: " + method);
             return true;
         }
-        callback->Failure(0, "No window available");
-        return true;
-    }
-    else if (request_str == "spawn_new_window") {
-        // Create a new browser window
-        SpawnNewWindow();
-        callback->Success("");
-        return true;
+        return false; // Request not handled (e.g. event bus subscriptions)
     }
-    else if (request_str == "create_new_file") {
-        // Handle new file creation via cefQuery
-        browser->GetMainFrame()->ExecuteJavaScript(
-            "if (window.createNewFileFromCEF) { window.createNewFileFromCEF(); }",
-            browser->GetMainFrame()->GetURL(), 0);
-        callback->Success("");
+    
+    if (command->async_handler) {
+        // Run off the UI thread; the result arrives later unless the query is cancelled
+        CefRefPtr<SimpleClient> self(this);
+        pending_queries_[query_id] = SimpleIPC::IPCHandler::GetInstance().HandleCallAsync(
+            name, argument, browser->GetIdentifier(),
+            [self, query_id, callback](bool success, const std::string& result) {
+                self->pending_queries_.erase(query_id);
+                if (success) {
+                    callback->Success(result);
+                } else {
+                    callback->Failure(0, result);
+                }
+            });
         return true;
     }
-    else if (request_str.substr(0, 9) == "ipc_call:") {
-        // Handle IPC calls: format is "ipc_call:method:message"
-        std::string remaining = request_str.substr(9);
-        size_t colon_pos = remaining.find(':');
-        
-        std::string method;
-        std::string message;
-        
-        if (colon_pos != std::string::npos) {
-            method = remaining.substr(0, colon_pos);
-            message = remaining.substr(colon_pos + 1);
-        } else {
-            method = remaining;
-            message = "";
-        }
-        
-        // Handle the IPC call using the singleton handler
-        std::string result = SimpleIPC::IPCHandler::GetInstance().HandleCall(method, message);
+    
+    std::string result;
+    if (command->handler(command_request, result)) {
         callback->Success(result);
-        return true;
+    } else if (ipc_call) {
+        // nativeAPI.call() has always resolved with the error text
+        callback->Success("Error: " + result);
+    } else {
+        callback->Failure(0, result);
     }
+    return true;
+}
+
+void SimpleClient::OnQueryCanceled(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefFrame> frame,
+                                   int64_t query_id) {
+    CEF_REQUIRE_UI_THREAD();
     
-    return false; // Request not handled
+    // The callback must not be used after this point; cancelling also stops the handler
+    auto it = pending_queries_.find(query_id);
+    if (it != pending_queries_.end()) {
+        it->second.Cancel();
+        pending_queries_.erase(it);
+        Logger::LogVerbose("IPC: Cancelled query " + std::to_string(query_id));
+    }
 }
 
 void SimpleClient::OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -286,12 +393,13 @@ void SimpleClient::OnDraggableRegionsChanged(
     
     // Handle draggable regions for CSS -webkit-app-region: drag
     // This method is called when the web page defines draggable regions
-    if (g_cef_window) {
-        // Set draggable regions on the CEF window
+    CefRefPtr<CefWindow> window = GetWindowFor(browser);
+    if (window) {
+        // Set draggable regions on the window hosting this browser
         // This enables CSS-based window dragging functionality
-        g_cef_window->SetDraggableRegions(regions);
+        window->SetDraggableRegions(regions);
         
-        Logger::LogMessage("Updated draggable regions: " + std::to_string(regions.size()) + " regions");
+        Logger::LogVerbose("Updated draggable regions: " + std::to_string(regions.size()) + " regions");
     }
 }
 
@@ -347,6 +455,15 @@ bool SimpleClient::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
                                           CefRefPtr<CefProcessMessage> message) {
     CEF_REQUIRE_UI_THREAD();
     
+    // Binary IPC calls carry their own method ID and payload
+    if (SimpleIPC::HandleBinaryCallMessage(browser, frame, message)) {
+        return true;
+    }
+    
+    if (MemoryMonitor::GetInstance().OnProcessMessageReceived(browser, message)) {
+        return true;
+    }
+    
     // Forward to message router
     if (message_router_) {
         return message_router_->OnProcessMessageReceived(browser, frame, source_process, message);
@@ -397,6 +514,9 @@ bool SimpleClient::OnBeforePopup(CefRefPtr<CefBrowser> browser,
 void SimpleClient::OnAfterCreated(CefRefPtr<CefBrowser> browser) {
     CEF_REQUIRE_UI_THREAD();
     browser_list_.push_back(browser);
+    ++g_open_browsers;
+    MemoryMonitor::GetInstance().AddBrowser(browser);
+    BackgroundPolicy::GetInstance().AddBrowser(browser);
     
     // Register message router with the browser
     if (message_router_) {
@@ -423,6 +543,10 @@ void SimpleClient::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
         message_router_ = nullptr;
     }
     
+    SimpleIPC::CancelBinaryCalls(browser);
+    MemoryMonitor::GetInstance().RemoveBrowser(browser);
+    BackgroundPolicy::GetInstance().RemoveBrowser(browser);
+    
     BrowserList::iterator bit = browser_list_.begin();
     for (; bit != browser_list_.end(); ++bit) {
         if ((*bit)->IsSame(browser)) {
@@ -431,10 +555,16 @@ void SimpleClient::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
         }
     }
 
-    if (browser_list_.empty()) {
-        extern bool g_running;
+    // Only the main window ends the app; spawned windows have their own clients.
+    // Once it has, the shutdown loop in main waits for the last browser to go.
+    extern CefRefPtr<SimpleClient> g_client;
+    extern bool g_running;
+    --g_open_browsers;
+    if (browser_list_.empty() && this == g_client.get()) {
         g_running = false;
         CefQuitMessageLoop();
+    } else if (g_open_browsers == 0 && !g_running) {
+        CefQuitMessageLoop();
     }
 }
 
@@ -491,6 +621,7 @@ void SimpleClient::OnLoadStart(CefRefPtr<CefBrowser> browser,
     CEF_REQUIRE_UI_THREAD();
     
     if (frame->IsMain()) {
+        StartupTrace::Mark("OnLoadStart");
         std::string mode = AppConfig::IsDebugMode() ? "DEBUG" : "RELEASE";
         Logger::LogMessage("Loading page in " + mode + " mode...");
         
@@ -505,12 +636,18 @@ void SimpleClient::OnLoadEnd(CefRefPtr<CefBrowser> browser,
     CEF_REQUIRE_UI_THREAD();
     
     if (frame->IsMain()) {
+        StartupTrace::Mark("OnLoadEnd");
         Logger::LogMessage("Main frame loaded successfully (HTTP " + std::to_string(httpStatusCode) + ")");
         
-        // Notify loading manager that content is loaded
-        LoadingManager& loadingManager = LoadingManager::GetInstance();
-        loadingManager.SetState(LoadingManager::READY, "Application ready");
-        loadingManager.OnContentLoaded();
+        // Fallback readiness signal; first paint or app_ready usually come first.
+        // Spares and spawned windows have their own clients and do not count.
+        extern CefRefPtr<SimpleClient> g_client;
+        if (this == g_client.get() && browser->IsSame(GetFirstBrowser())) {
+            LoadingManager::GetInstance().OnContentLoaded();
+        }
+        
+        // Give chunks imported right after load a moment before the profile is stored
+        StartupCache::ScheduleFinishRecording(3000);
     }
 }
 
@@ -548,6 +685,10 @@ bool SimpleClient::HasBrowsers() {
     return !browser_list_.empty();
 }
 
+int SimpleClient::GetOpenBrowserCount() {
+    return g_open_browsers;
+}
+
 bool SimpleClient::OnPreKeyEvent(CefRefPtr<CefBrowser> browser,
                                  const CefKeyEvent& event,
                                  CefEventHandle os_event,
@@ -671,42 +812,24 @@ void SimpleClient::OnDownloadUpdated(CefRefPtr<CefBrowser> browser,
     int64_t total = download_item->GetTotalBytes();
     if (total > 0) {
       int progress = static_cast<int>((received * 100) / total);
-      Logger::LogMessage("Download progress: " + std::to_string(progress) + "% - " + download_item->GetFullPath().ToString());
+      Logger::LogVerbose("Download progress: " + std::to_string(progress) + "% - " + download_item->GetFullPath().ToString());
     }
   }
+
+  // Progress updates of one download coalesce to the latest within a batch
+  std::string id = std::to_string(download_item->GetId());
+  std::string state = download_item->IsComplete() ? "complete" :
+                      download_item->IsCanceled() ? "canceled" : "progress";
+  SimpleIPC::EventBus::GetInstance().Publish("download",
+      "{\"id\": " + id + ", \"state\": \"" + state + "\", " +
+      "\"received\": " + std::to_string(download_item->GetReceivedBytes()) + ", " +
+      "\"total\": " + std::to_string(download_item->GetTotalBytes()) + "}",
+      state == "progress" ? id : std::string());
 }
 
 void SimpleClient::SpawnNewWindow() {
     CEF_REQUIRE_UI_THREAD();
     
-    // Get the startup URL from config
-    std::string url = AppConfig::GetStartupUrl();
-    
-    // Create window info for the new browser window
-    CefWindowInfo window_info;
-    
-#ifdef _WIN32
-    window_info.SetAsPopup(nullptr, "SwipeIDE - New Window");
-    window_info.bounds.x = 100;
-    window_info.bounds.y = 100;
-    window_info.bounds.width = 1200;
-    window_info.bounds.height = 800;
-    window_info.style |= WS_OVERLAPPEDWINDOW;
-#else
-    // Linux - use windowed mode
-    window_info.SetAsChild(0, CefRect(100, 100, 1200, 800));
-#endif
-    
-    // Browser settings
-    CefBrowserSettings browser_settings;
-    // Note: web_security, file_access_from_file_urls, and universal_access_from_file_urls
-    // are not available in this version of CEF
-    
-    // Create a new client instance for the new window
-    CefRefPtr<SimpleClient> new_client = new SimpleClient();
-    
-    // Create the new browser window
-    CefBrowserHost::CreateBrowser(window_info, new_client, url, browser_settings, nullptr, nullptr);
-    
-    Logger::LogMessage("Spawned new browser window");
+    // Hidden, pre-navigated windows make this instant (see BrowserPool)
+    BrowserPool::GetInstance().SpawnWindow();
 }
\ No newline at end of file
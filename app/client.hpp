@@ -11,7 +11,9 @@
 #include "include/wrapper/cef_message_router.h"
 #include "include/cef_task.h"
 #include "binaryresourceprovider.hpp"
+#include "worker_pool.hpp"
 #include <list>
+#include <map>
 
 class SimpleClient;
 
@@ -58,6 +60,10 @@ public:
                         const CefString& request,
                         bool persistent,
                         CefRefPtr<CefMessageRouterBrowserSide::Callback> callback) override;
+    
+    virtual void OnQueryCanceled(CefRefPtr<CefBrowser> browser,
+                                 CefRefPtr<CefFrame> frame,
+                                 int64_t query_id) override;
 
     // CefDisplayHandler methods
     virtual void OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -157,6 +163,9 @@ public:
 
 
 
+    // Register the window and browser commands with the CommandRegistry
+    static void RegisterCommands();
+    
     // Browser management
     void CloseAllBrowsers(bool force_close);
     void DoCloseAllBrowsers(bool force_close);
@@ -164,6 +173,10 @@ public:
     bool HasBrowsers();
     void SpawnNewWindow();
 
+    // Browsers of every client (main, spawned and pooled windows) that have
+    // not reached OnBeforeClose yet. UI thread only.
+    static int GetOpenBrowserCount();
+
 private:
     typedef std::list<CefRefPtr<CefBrowser>> BrowserList;
     BrowserList browser_list_;
@@ -171,6 +184,9 @@ private:
     // Message router for handling JavaScript queries
     CefRefPtr<CefMessageRouterBrowserSide> message_router_;
     
+    // Async IPC calls still running on the worker pool, by query ID (UI thread only)
+    std::map<int64_t, CancelToken> pending_queries_;
+    
     // Binary resource provider for handling miko:// protocol
     CefRefPtr<BinaryResourceProvider> resource_provider_;
 
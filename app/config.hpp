@@ -4,6 +4,7 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include "settings.hpp"
 #include "webapp.hpp"
 
 // Application configuration constants
@@ -11,12 +12,17 @@
 #define APP_VERSION "1.0.0"
 #define APP_AUTHOR "Ariz Kamizuki"
 
-// Window configuration
+// Window configuration (defaults for window-width/window-height, see Settings)
 #define DEFAULT_WINDOW_WIDTH 1200
 #define DEFAULT_WINDOW_HEIGHT 800
 #define MIN_WINDOW_WIDTH 800
 #define MIN_WINDOW_HEIGHT 600
 
+// Native colours matching the web app theme (ARGB), so nothing flashes white
+// before the first paint
+#define APP_BACKGROUND_COLOR 0xFF1E1E1E
+#define APP_SPLASH_TEXT_COLOR 0xFFCCCCCC
+
 // Window mode enumeration
 enum class WindowMode {
     WINDOWED,    // Standard window with title bar and borders
@@ -26,7 +32,7 @@ enum class WindowMode {
 // Debug configuration
 #ifdef _DEBUG
     #define DEBUG_MODE 1
-    #define LOG_LEVEL 0  // Verbose logging
+    #define LOG_LEVEL 0  // Verbose logging (log-level setting overrides)
 #else
     #define DEBUG_MODE 0
     #define LOG_LEVEL 2  // Error logging only
@@ -93,10 +99,9 @@ public:
         return "index.html";
     }
     
-    // Window mode configuration - FORCE BORDERLESS
+    // Window mode configuration (window-mode setting, borderless by default)
     static WindowMode GetWindowMode() {
-        // Force borderless mode for custom UI experience
-        return WindowMode::BORDERLESS;
+        return Settings::GetInstance().GetConfig().borderless ? WindowMode::BORDERLESS : WindowMode::WINDOWED;
     }
     
     static bool IsWindowedMode() {
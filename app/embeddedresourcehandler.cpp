@@ -0,0 +1,299 @@
+#include "embeddedresourcehandler.hpp"
+#include <brotli/decode.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // Scratch size used when skipping through compressed data
+    constexpr size_t kSkipBufferSize = 16 * 1024;
+
+    std::string Trim(const std::string& value) {
+        size_t begin = value.find_first_not_of(" \t");
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        size_t end = value.find_last_not_of(" \t");
+        return value.substr(begin, end - begin + 1);
+    }
+
+    // Parse a non-empty run of decimal digits
+    bool ParseSize(const std::string& value, size_t& out) {
+        if (value.empty() || value.size() > 19) {
+            return false;
+        }
+        for (char c : value) {
+            if (!isdigit(static_cast<unsigned char>(c))) {
+                return false;
+            }
+        }
+        out = static_cast<size_t>(strtoull(value.c_str(), nullptr, 10));
+        return true;
+    }
+}
+
+EmbeddedResourceHandler::EmbeddedResourceHandler(const ResourceUtil::PreloadedResource& resource)
+    : data_(resource.data),
+      encoding_(resource.encoding),
+      original_size_(resource.originalSize),
+      mime_type_(resource.mimeType),
+      etag_(resource.etag),
+      immutable_(resource.immutable),
+      status_(200),
+      range_start_(0),
+      response_length_(resource.originalSize),
+      delivered_(0),
+      offset_(0),
+      produced_(0),
+      decoder_(nullptr) {
+}
+
+EmbeddedResourceHandler::~EmbeddedResourceHandler() {
+    if (decoder_) {
+        BrotliDecoderDestroyInstance(decoder_);
+    }
+}
+
+bool EmbeddedResourceHandler::MatchesIfNoneMatch(const std::string& header) const {
+    if (etag_.empty()) {
+        return false;
+    }
+
+    // Comma-separated list of entity tags; If-None-Match uses weak comparison
+    size_t pos = 0;
+    while (pos <= header.size()) {
+        size_t comma = header.find(',', pos);
+        std::string tag = Trim(header.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos));
+        if (tag == "*") {
+            return true;
+        }
+        if (tag.compare(0, 2, "W/") == 0) {
+            tag = tag.substr(2);
+        }
+        if (tag == etag_) {
+            return true;
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+bool EmbeddedResourceHandler::ParseRange(const std::string& header, size_t& start, size_t& length) const {
+    // Only a single "bytes=" range is supported; anything else is served in full
+    std::string value = Trim(header);
+    if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos) {
+        return false;
+    }
+    value = Trim(value.substr(6));
+
+    size_t dash = value.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    std::string first = Trim(value.substr(0, dash));
+    std::string last = Trim(value.substr(dash + 1));
+
+    size_t first_pos = 0;
+    size_t last_pos = 0;
+    if (first.empty()) {
+        // Suffix range: the final N bytes
+        if (!ParseSize(last, last_pos) || last_pos == 0) {
+            return false;
+        }
+        length = std::min(last_pos, original_size_);
+        start = original_size_ - length;
+        return true;
+    }
+
+    if (!ParseSize(first, first_pos)) {
+        return false;
+    }
+    if (last.empty()) {
+        last_pos = original_size_ == 0 ? 0 : original_size_ - 1;
+    } else if (!ParseSize(last, last_pos) || last_pos < first_pos) {
+        return false;
+    }
+
+    start = first_pos;
+    length = start < original_size_ ? std::min(last_pos, original_size_ - 1) - start + 1 : 0;
+    return true;
+}
+
+bool EmbeddedResourceHandler::Open(CefRefPtr<CefRequest> request,
+                                   bool& handle_request,
+                                   CefRefPtr<CefCallback> callback) {
+    // Data is already resident in the binary, so the request is handled immediately
+    handle_request = true;
+
+    if (MatchesIfNoneMatch(request->GetHeaderByName("If-None-Match").ToString())) {
+        status_ = 304;
+        response_length_ = 0;
+        return true;
+    }
+
+    size_t start = 0;
+    size_t length = 0;
+    if (ParseRange(request->GetHeaderByName("Range").ToString(), start, length)) {
+        if (length == 0) {
+            status_ = 416;
+            response_length_ = 0;
+            return true;
+        }
+        status_ = 206;
+        range_start_ = start;
+        response_length_ = length;
+    }
+
+    if (encoding_ == ResourceUtil::ENCODING_BROTLI) {
+        // Decoder state is created lazily per request; the ring buffer it
+        // allocates is bounded by the window size chosen in buildtobin.ts
+        decoder_ = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!decoder_) {
+            return false;
+        }
+    }
+
+    // Position the stream at the start of the requested range
+    return range_start_ == 0 || Advance(range_start_);
+}
+
+void EmbeddedResourceHandler::GetResponseHeaders(CefRefPtr<CefResponse> response,
+                                                 int64_t& response_length,
+                                                 CefString& redirectUrl) {
+    CefResponse::HeaderMap headers;
+    headers.insert(std::make_pair("Accept-Ranges", "bytes"));
+    headers.insert(std::make_pair("Cache-Control",
+        immutable_ ? "public, max-age=31536000, immutable" : "no-cache"));
+    if (!etag_.empty()) {
+        headers.insert(std::make_pair("ETag", etag_));
+    }
+
+    switch (status_) {
+        case 304:
+            response->SetStatusText("Not Modified");
+            break;
+        case 206:
+            response->SetStatusText("Partial Content");
+            headers.insert(std::make_pair("Content-Range",
+                "bytes " + std::to_string(range_start_) + "-" +
+                std::to_string(range_start_ + response_length_ - 1) + "/" +
+                std::to_string(original_size_)));
+            break;
+        case 416:
+            response->SetStatusText("Range Not Satisfiable");
+            headers.insert(std::make_pair("Content-Range", "bytes */" + std::to_string(original_size_)));
+            break;
+        default:
+            response->SetStatusText("OK");
+            break;
+    }
+
+    response->SetStatus(status_);
+    response->SetMimeType(mime_type_);
+    response->SetHeaderMap(headers);
+    response_length = static_cast<int64_t>(response_length_);
+}
+
+int64_t EmbeddedResourceHandler::Produce(uint8_t* out, size_t size) {
+    if (encoding_ == ResourceUtil::ENCODING_IDENTITY) {
+        size_t chunk = std::min(data_.size - offset_, size);
+        memcpy(out, data_.data + offset_, chunk);
+        offset_ += chunk;
+        produced_ += chunk;
+        return static_cast<int64_t>(chunk);
+    }
+
+    if (!decoder_) {
+        return -1;
+    }
+
+    size_t available_in = data_.size - offset_;
+    const uint8_t* next_in = data_.data + offset_;
+    size_t available_out = size;
+    uint8_t* next_out = out;
+
+    BrotliDecoderResult result = BrotliDecoderDecompressStream(
+        decoder_, &available_in, &next_in, &available_out, &next_out, nullptr);
+
+    offset_ = data_.size - available_in;
+    size_t written = size - available_out;
+    produced_ += written;
+
+    if (result == BROTLI_DECODER_RESULT_ERROR ||
+        (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT && written == 0)) {
+        // Corrupt or truncated stream
+        return -1;
+    }
+    return static_cast<int64_t>(written);
+}
+
+bool EmbeddedResourceHandler::Advance(size_t count) {
+    if (encoding_ == ResourceUtil::ENCODING_IDENTITY) {
+        count = std::min(count, data_.size - offset_);
+        offset_ += count;
+        produced_ += count;
+        return true;
+    }
+
+    // Compressed data has to be decoded to find the target position
+    uint8_t scratch[kSkipBufferSize];
+    while (count > 0) {
+        int64_t written = Produce(scratch, std::min(kSkipBufferSize, count));
+        if (written <= 0) {
+            return false;
+        }
+        count -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool EmbeddedResourceHandler::Skip(int64_t bytes_to_skip,
+                                   int64_t& bytes_skipped,
+                                   CefRefPtr<CefResourceSkipCallback> callback) {
+    size_t remaining = response_length_ - delivered_;
+    if (bytes_to_skip <= 0 || remaining == 0) {
+        bytes_skipped = -2; // ERR_FAILED
+        return false;
+    }
+
+    size_t target = std::min(remaining, static_cast<size_t>(bytes_to_skip));
+    if (!Advance(target)) {
+        bytes_skipped = -2; // ERR_FAILED
+        return false;
+    }
+
+    delivered_ += target;
+    bytes_skipped = static_cast<int64_t>(target);
+    return true;
+}
+
+bool EmbeddedResourceHandler::Read(void* data_out,
+                                   int bytes_to_read,
+                                   int& bytes_read,
+                                   CefRefPtr<CefResourceReadCallback> callback) {
+    size_t remaining = response_length_ - delivered_;
+    if (remaining == 0 || bytes_to_read <= 0) {
+        // Response complete
+        bytes_read = 0;
+        return false;
+    }
+
+    size_t chunk = std::min(remaining, static_cast<size_t>(bytes_to_read));
+    int64_t written = Produce(static_cast<uint8_t*>(data_out), chunk);
+    if (written < 0) {
+        bytes_read = -2; // ERR_FAILED
+        return false;
+    }
+
+    delivered_ += static_cast<size_t>(written);
+    bytes_read = static_cast<int>(written);
+    return written > 0;
+}
+
+void EmbeddedResourceHandler::Cancel() {
+    delivered_ = response_length_;
+}
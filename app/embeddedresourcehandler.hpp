@@ -0,0 +1,72 @@
+#pragma once
+#include "include/cef_resource_handler.h"
+#include "include/cef_request.h"
+#include "include/cef_response.h"
+#include "include/cef_callback.h"
+#include "resourceutil.hpp"
+#include <string>
+
+struct BrotliDecoderStateStruct;
+
+// Resource handler that streams directly out of the static bundle arrays.
+// Unlike CefStreamResourceHandler it never copies the resource into an
+// intermediate buffer; the only copy is into the buffer CEF hands to Read().
+// Brotli-compressed assets are decoded incrementally into that same buffer.
+//
+// Responses carry a strong ETag and Cache-Control, answer If-None-Match
+// with 304 and honour single-range Range requests with 206.
+class EmbeddedResourceHandler : public CefResourceHandler {
+public:
+    explicit EmbeddedResourceHandler(const ResourceUtil::PreloadedResource& resource);
+    ~EmbeddedResourceHandler() override;
+
+    // CefResourceHandler methods
+    bool Open(CefRefPtr<CefRequest> request,
+              bool& handle_request,
+              CefRefPtr<CefCallback> callback) override;
+
+    void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                            int64_t& response_length,
+                            CefString& redirectUrl) override;
+
+    bool Skip(int64_t bytes_to_skip,
+              int64_t& bytes_skipped,
+              CefRefPtr<CefResourceSkipCallback> callback) override;
+
+    bool Read(void* data_out,
+              int bytes_to_read,
+              int& bytes_read,
+              CefRefPtr<CefResourceReadCallback> callback) override;
+
+    void Cancel() override;
+
+private:
+    // Conditional and partial request handling
+    bool MatchesIfNoneMatch(const std::string& header) const;
+    bool ParseRange(const std::string& header, size_t& start, size_t& length) const;
+
+    // Produce up to |size| decoded bytes into |out|; returns bytes written or -1 on error
+    int64_t Produce(uint8_t* out, size_t size);
+
+    // Discard |count| decoded bytes; returns false on a decode error
+    bool Advance(size_t count);
+
+    ResourceUtil::ResourceSpan data_;
+    ResourceUtil::ResourceEncoding encoding_;
+    size_t original_size_;
+    std::string mime_type_;
+    std::string etag_;
+    bool immutable_;
+
+    int status_;
+    size_t range_start_;
+    size_t response_length_; // Bytes this response delivers
+    size_t delivered_;       // Bytes handed to CEF so far
+
+    size_t offset_;          // Position in the stored (possibly compressed) bytes
+    size_t produced_;        // Decoded bytes produced so far
+    BrotliDecoderStateStruct* decoder_;
+
+    IMPLEMENT_REFCOUNTING(EmbeddedResourceHandler);
+    DISALLOW_COPY_AND_ASSIGN(EmbeddedResourceHandler);
+};
@@ -0,0 +1,150 @@
+#include "file_reader.hpp"
+#include <cerrno>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+FileReader::FileReader()
+    : size_(0), open_(false)
+#ifdef _WIN32
+    , handle_(INVALID_HANDLE_VALUE)
+#else
+    , fd_(-1)
+#endif
+{
+}
+
+FileReader::~FileReader() {
+    Close();
+}
+
+FileReader::FileReader(FileReader&& other) noexcept
+    : size_(other.size_), open_(other.open_)
+#ifdef _WIN32
+    , handle_(other.handle_)
+#else
+    , fd_(other.fd_)
+#endif
+{
+    other.size_ = 0;
+    other.open_ = false;
+#ifdef _WIN32
+    other.handle_ = INVALID_HANDLE_VALUE;
+#else
+    other.fd_ = -1;
+#endif
+}
+
+FileReader& FileReader::operator=(FileReader&& other) noexcept {
+    if (this != &other) {
+        Close();
+        std::swap(size_, other.size_);
+        std::swap(open_, other.open_);
+#ifdef _WIN32
+        std::swap(handle_, other.handle_);
+#else
+        std::swap(fd_, other.fd_);
+#endif
+    }
+    return *this;
+}
+
+bool FileReader::Open(const std::string& path) {
+    Close();
+
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wide_path(length > 0 ? length - 1 : 0, L'\0');
+    if (length > 1) {
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide_path[0], length);
+    }
+    HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    handle_ = file;
+    size_ = static_cast<uint64_t>(file_size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    size_ = static_cast<uint64_t>(info.st_size);
+#endif
+
+    open_ = true;
+    return true;
+}
+
+void FileReader::Close() {
+#ifdef _WIN32
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+#endif
+    size_ = 0;
+    open_ = false;
+}
+
+bool FileReader::Read(uint64_t offset, void* buffer, size_t count, size_t& read) {
+    read = 0;
+    if (!open_) {
+        return false;
+    }
+    char* out = static_cast<char*>(buffer);
+    while (read < count) {
+#ifdef _WIN32
+        // A synchronous handle reads at the OVERLAPPED offset and waits
+        OVERLAPPED position = {};
+        uint64_t at = offset + read;
+        position.Offset = static_cast<DWORD>(at);
+        position.OffsetHigh = static_cast<DWORD>(at >> 32);
+        size_t remaining = count - read;
+        DWORD wanted = static_cast<DWORD>(remaining < (1u << 30) ? remaining : (1u << 30));
+        DWORD got = 0;
+        if (!ReadFile(handle_, out + read, wanted, &got, &position)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            return false;
+        }
+#else
+        ssize_t got = pread(fd_, out + read, count - read, static_cast<off_t>(offset + read));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+#endif
+        if (got == 0) {
+            break;
+        }
+        read += static_cast<size_t>(got);
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Positioned reads (pread, ReadFile at an offset) from a regular file.
+//
+// Unlike a MappedFile, a file that is truncated while it is read only makes
+// the read come back short instead of faulting the process, and the handle is
+// shared for writing and deleting, so holding it never keeps another program
+// from replacing the file. Meant for workspace files that can change at any
+// time; the data lands in a buffer the caller owns and can reuse.
+class FileReader {
+public:
+    FileReader();
+    ~FileReader();
+    FileReader(FileReader&& other) noexcept;
+    FileReader& operator=(FileReader&& other) noexcept;
+
+    // Opens |path|, closing any previous file. Returns false (and logs nothing;
+    // callers decide whether a missing file is an error) on failure or when
+    // |path| is not a regular file.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return open_; }
+    uint64_t GetSize() const { return size_; }  // When it was opened
+
+    // Up to |count| bytes from |offset|; |read| is short only at the end of
+    // the file. False on a read error.
+    bool Read(uint64_t offset, void* buffer, size_t count, size_t& read);
+
+private:
+    FileReader(const FileReader&);
+    FileReader& operator=(const FileReader&);
+
+    uint64_t size_;
+    bool open_;
+#ifdef _WIN32
+    void* handle_;      // HANDLE of the file
+#else
+    int fd_;
+#endif
+};
@@ -0,0 +1,143 @@
+#include "file_service.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <filesystem>
+#endif
+
+FileService::FileService() {
+}
+
+FileService::~FileService() {
+}
+
+FileService& FileService::GetInstance() {
+    static FileService instance;
+    return instance;
+}
+
+bool FileService::StatPath(const std::string& path, FileInfo& info, std::string& error) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_wstat64(std::filesystem::u8path(path).c_str(), &st) != 0) {
+        error = "Cannot stat " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    info.modified_ms = static_cast<int64_t>(st.st_mtime) * 1000;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        error = "Cannot stat " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#ifdef __APPLE__
+    info.modified_ms = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+    info.modified_ms = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+#endif
+    info.size = static_cast<int64_t>(st.st_size);
+    info.directory = (st.st_mode & S_IFMT) == S_IFDIR;
+    return true;
+}
+
+// Worker thread
+bool FileService::OpenFile(const std::string& path, FileReader& file, std::string& error) {
+    FileInfo info;
+    if (!StatPath(path, info, error)) {
+        return false;
+    }
+    if (info.directory) {
+        error = path + " is a directory";
+        return false;
+    }
+    if (!file.Open(path)) {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool FileService::HandleStat(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error) {
+    FileInfo info;
+    if (!StatPath(message, info, error)) {
+        return false;
+    }
+    output = "{\"size\": " + std::to_string(info.size) +
+             ", \"directory\": " + (info.directory ? "true" : "false") +
+             ", \"modified\": " + std::to_string(info.modified_ms) +
+             ", \"chunkSize\": " + std::to_string(kChunkBytes) + "}";
+    return true;
+}
+
+bool FileService::HandleReadFile(const std::string& message, int browser_id, const CancelToken& token,
+                                 std::string& output, std::string& error) {
+    FileReader file;
+    if (!OpenFile(message, file, error)) {
+        return false;
+    }
+    if (file.GetSize() > kChunkBytes) {
+        error = message + " is " + std::to_string(file.GetSize()) + " bytes; read it in chunks with readRange";
+        return false;
+    }
+    size_t read = 0;
+    output.resize(static_cast<size_t>(file.GetSize()));
+    if (!file.Read(0, &output[0], output.size(), read)) {
+        error = "Cannot read " + message + ": " + std::strerror(errno);
+        return false;
+    }
+    output.resize(read);
+    return true;
+}
+
+// "offset:length:path"; the path goes last so it may contain colons
+bool FileService::HandleReadRange(const std::string& message, int browser_id, const CancelToken& token,
+                                  std::string& output, std::string& error) {
+    const char* text = message.c_str();
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long offset = std::strtoull(text, &end, 10);
+    bool valid = end != text && *end == ':' && errno == 0;
+    unsigned long long length = 0;
+    if (valid) {
+        text = end + 1;
+        length = std::strtoull(text, &end, 10);
+        valid = end != text && *end == ':' && errno == 0;
+    }
+    if (!valid) {
+        error = "Expected offset:length:path";
+        return false;
+    }
+    std::string path(end + 1);
+
+    FileReader file;
+    if (!OpenFile(path, file, error)) {
+        return false;
+    }
+
+    // Past the end reads nothing, so the caller sees where the file stops
+    uint64_t size = file.GetSize();
+    uint64_t begin = std::min<unsigned long long>(offset, size);
+    size_t count = static_cast<size_t>(std::min<unsigned long long>(std::min<unsigned long long>(length, kChunkBytes),
+                                                                    size - begin));
+    size_t read = 0;
+    output.resize(count);
+    if (!file.Read(begin, &output[0], count, read)) {
+        error = "Cannot read " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    output.resize(read);
+    return true;
+}
+
+void FileService::RegisterCommands() {
+    SimpleIPC::IPCHandler& ipc = SimpleIPC::IPCHandler::GetInstance();
+    ipc.RegisterAsyncHandler("stat", HandleStat);
+    ipc.RegisterAsyncHandler("readFile", HandleReadFile);
+    ipc.RegisterAsyncHandler("readRange", HandleReadRange);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "file_reader.hpp"
+#include "internal/simpleipc.hpp"
+#include <cstdint>
+#include <string>
+
+// Workspace file access for the editor.
+//
+// Files are served in bounded chunks, read with positioned reads straight into
+// the reply (see FileReader), so opening a large generated source or log costs
+// one chunk of memory at a time instead of a copy of the whole file, and all
+// work happens on the worker pool:
+//
+//   stat        path                    -> {"size", "directory", "modified", "chunkSize"}
+//   readFile    path                    -> whole file, if it fits in one chunk
+//   readRange   "offset:length:path"    -> at most chunkSize bytes from offset
+//
+// Over nativeAPI.invoke() the bytes arrive as an ArrayBuffer without any string
+// conversion; nativeAPI.readFileChunks(path, onChunk) streams a whole file that
+// way. No file stays open between calls, and a file truncated meanwhile only
+// makes a chunk come back short.
+class FileService {
+public:
+    // Largest payload of a single reply
+    static constexpr size_t kChunkBytes = 4 * 1024 * 1024;
+
+    // Singleton access
+    static FileService& GetInstance();
+
+    // Register stat, readFile and readRange as async IPC methods
+    static void RegisterCommands();
+
+private:
+    struct FileInfo {
+        int64_t size;
+        int64_t modified_ms;    // Since the Unix epoch
+        bool directory;
+    };
+
+    FileService();
+    ~FileService();
+    FileService(const FileService&);
+    FileService& operator=(const FileService&);
+
+    static bool StatPath(const std::string& path, FileInfo& info, std::string& error);
+    static bool OpenFile(const std::string& path, FileReader& file, std::string& error);
+
+    static bool HandleStat(const std::string& message, int browser_id, const CancelToken& token,
+                           std::string& output, std::string& error);
+    static bool HandleReadFile(const std::string& message, int browser_id, const CancelToken& token,
+                               std::string& output, std::string& error);
+    static bool HandleReadRange(const std::string& message, int browser_id, const CancelToken& token,
+                                std::string& output, std::string& error);
+};
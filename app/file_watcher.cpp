@@ -0,0 +1,612 @@
+#include "file_watcher.hpp"
+#include "logger.hpp"
+#include "workspace_index.hpp"
+#include "internal/eventbus.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+
+#ifdef __linux__
+    #include <errno.h>
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    const char kChangesTopic[] = "workspace.changes";
+    const char* const kChangeNames[] = { "created", "modified", "deleted" };
+
+    // Flushed early beyond this many pending paths, so a mass deletion does
+    // not grow the change set without bound
+    const size_t kMaxPendingChanges = 100000;
+    // Directories with events this recent are rescanned after an overflow
+    const int kOverflowWindowMs = 2000;
+    // More rescan targets than this collapse to the whole workspace
+    const size_t kMaxOverflowTargets = 64;
+    // Bookkeeping per watch besides a long path: a map node, a hash node and its bucket
+    const size_t kWatchOverheadBytes = 120;
+
+    size_t WatchBytes(const std::string& path) {
+        return kWatchOverheadBytes + (path.size() > 15 ? path.size() + 1 : 0);
+    }
+
+    std::string JsonPaths(const std::vector<std::string>& paths) {
+        std::string json = "[";
+        for (size_t i = 0; i < paths.size(); ++i) {
+            json += std::string(i ? "," : "") + "\"" + SimpleIPC::EscapeJson(paths[i]) + "\"";
+        }
+        return json + "]";
+    }
+
+#ifdef __linux__
+    const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY |
+                                IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+    size_t ReadKernelLimit() {
+        size_t limit = 8192;    // The historical default
+        FILE* file = std::fopen("/proc/sys/fs/inotify/max_user_watches", "r");
+        if (file) {
+            if (std::fscanf(file, "%zu", &limit) != 1) {
+                limit = 8192;
+            }
+            std::fclose(file);
+        }
+        return limit;
+    }
+#endif
+}
+
+FileWatcher::FileWatcher()
+    : limit_(0),
+      kernel_limit_(0),
+      debounce_(100),
+      stop_(false),
+      inotify_fd_(-1),
+      wake_fd_(-1),
+      kernel_full_(false),
+      running_(false),
+      watch_count_(0),
+      user_bytes_(0),
+      unwatched_count_(0),
+      overflow_count_(0) {
+}
+
+FileWatcher::~FileWatcher() {
+}
+
+FileWatcher& FileWatcher::GetInstance() {
+    static FileWatcher instance;
+    return instance;
+}
+
+void FileWatcher::Configure(int limit, int debounce_ms, const std::vector<std::string>& excluded) {
+    limit_ = static_cast<size_t>(std::max(limit, 0));
+    debounce_ = std::chrono::milliseconds(debounce_ms);
+    excluded_ = excluded;
+}
+
+void FileWatcher::Start() {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    kernel_limit_ = ReadKernelLimit();
+    limit_ = limit_ == 0 ? kernel_limit_ - kernel_limit_ / 10 : std::min(limit_, kernel_limit_);
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || wake_fd_ < 0) {
+        Logger::LogError("FileWatcher: inotify unavailable, errno " + std::to_string(errno));
+        if (inotify_fd_ >= 0) {
+            close(inotify_fd_);
+        }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
+        inotify_fd_ = -1;
+        wake_fd_ = -1;
+        return;
+    }
+
+    WorkspaceIndex::GetInstance().AddTreeCallback(
+        [this](const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree, const TreeDiff& diff, bool reset) {
+            OnTreeChanged(root, tree, diff, reset);
+        });
+    stop_ = false;
+    running_ = true;
+    thread_ = std::thread(&FileWatcher::Run, this);
+    Logger::LogMessage("FileWatcher: Started; up to " + std::to_string(limit_) + " watches (max_user_watches " +
+                       std::to_string(kernel_limit_) + ")");
+#else
+    Logger::LogMessage("FileWatcher: Not available on this platform");
+#endif
+}
+
+void FileWatcher::Shutdown() {
+#ifdef __linux__
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_ = true;
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Wake();
+    }
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    close(inotify_fd_);
+    close(wake_fd_);
+    inotify_fd_ = -1;
+    wake_fd_ = -1;
+    updates_.clear();
+#endif
+}
+
+// With mutex_ held
+void FileWatcher::Wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    if (wake_fd_ >= 0 && write(wake_fd_, &one, sizeof(one)) < 0) {
+        // Counter already signalled
+    }
+#endif
+}
+
+// Index worker thread; the watcher thread applies the tree
+void FileWatcher::OnTreeChanged(const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree,
+                                const TreeDiff& diff, bool reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wake_fd_ < 0) {
+        return;
+    }
+    if (reset) {
+        updates_.clear();
+    }
+    updates_.push_back({ root, tree, diff, reset });
+    Wake();
+}
+
+std::string FileWatcher::GetStatusJson() const {
+    size_t watches = watch_count_.load();
+    return "{\"watches\": " + std::to_string(watches) + ", \"limit\": " + std::to_string(limit_) +
+           ", \"kernelLimit\": " + std::to_string(kernel_limit_) + ", \"unwatched\": " +
+           std::to_string(unwatched_count_.load()) + ", \"kernelBytes\": " +
+           std::to_string(watches * kKernelBytesPerWatch) + ", \"userBytes\": " + std::to_string(user_bytes_.load()) +
+           ", \"overflows\": " + std::to_string(overflow_count_.load()) + "}";
+}
+
+bool FileWatcher::IsWatchingAll() const {
+    return running_.load() && watch_count_.load() > 0 && unwatched_count_.load() == 0;
+}
+
+#ifdef __linux__
+
+void FileWatcher::Run() {
+    while (!stop_) {
+        pollfd fds[2] = { { inotify_fd_, POLLIN, 0 }, { wake_fd_, POLLIN, 0 } };
+        int ready = poll(fds, 2, GetTimeout(Clock::now()));
+        if (ready < 0 && errno != EINTR) {
+            Logger::LogError("FileWatcher: poll failed, errno " + std::to_string(errno));
+            break;
+        }
+        if (stop_) {
+            break;
+        }
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            uint64_t count;
+            if (read(wake_fd_, &count, sizeof(count)) < 0) {
+                // Already drained
+            }
+        }
+
+        Clock::time_point now = Clock::now();
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            ReadEvents(now);
+        }
+        ApplyUpdates();
+
+        if ((!changes_.empty() || !refresh_.empty()) &&
+            (now - last_change_ >= debounce_ || now - first_change_ >= std::chrono::milliseconds(kMaxDelayMs))) {
+            Flush(now);
+        }
+        if (!unwatched_.empty() && now >= next_unwatched_scan_) {
+            RetryUnwatched();
+            next_unwatched_scan_ = now + std::chrono::milliseconds(kUnwatchedRescanMs);
+        }
+    }
+    running_ = false;
+}
+
+int FileWatcher::GetTimeout(Clock::time_point now) const {
+    int timeout = -1;
+    auto until = [&timeout, now](Clock::time_point deadline) {
+        long long ms = std::max<long long>(0, std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+        int wait = static_cast<int>(std::min<long long>(ms, 24 * 3600 * 1000));
+        timeout = timeout < 0 ? wait : std::min(timeout, wait);
+    };
+    if (!changes_.empty() || !refresh_.empty()) {
+        until(std::min(last_change_ + debounce_, first_change_ + std::chrono::milliseconds(kMaxDelayMs)));
+    }
+    if (!unwatched_.empty()) {
+        until(next_unwatched_scan_);
+    }
+    return timeout;
+}
+
+void FileWatcher::ApplyUpdates() {
+    std::vector<Update> updates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        updates.swap(updates_);
+    }
+
+    for (Update& update : updates) {
+        if (update.reset) {
+            root_ = update.root;
+            tree_ = update.tree;
+            ResetWatches();
+            continue;
+        }
+        if (update.root != root_) {
+            continue;           // Left over from the workspace open before
+        }
+        tree_ = update.tree;
+
+        // A moved directory is removed and added, and watched again under its new path
+        for (const std::string& path : update.diff.removed) {
+            RemoveWatches(path);
+        }
+        std::vector<std::string> added;
+        for (uint32_t node : update.diff.added) {
+            if (tree_->IsDirectory(node)) {
+                WatchSubtree(*tree_, node, &added);
+            }
+        }
+        // Entries created between the read that found these directories and
+        // their watches went unnoticed; reading them once more closes the gap
+        if (!added.empty()) {
+            WorkspaceIndex::GetInstance().Refresh(added);
+        }
+    }
+}
+
+void FileWatcher::ResetWatches() {
+    // Closing the descriptor drops every watch at once
+    close(inotify_fd_);
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        Logger::LogError("FileWatcher: inotify_init1 failed, errno " + std::to_string(errno));
+        running_ = false;
+    }
+    watches_.clear();
+    paths_.clear();
+    unwatched_.clear();
+    ignore_rules_.clear();
+    excluded_paths_.clear();
+    for (const std::string& excluded : excluded_) {
+        if (excluded.size() > root_.size() + 1 && excluded.compare(0, root_.size(), root_) == 0 &&
+            excluded[root_.size()] == '/') {
+            excluded_paths_.push_back(excluded.substr(root_.size() + 1));
+        }
+    }
+    changes_.clear();
+    refresh_.clear();
+    active_.clear();
+    kernel_full_ = false;
+    watch_count_ = 0;
+    user_bytes_ = 0;
+    next_unwatched_scan_ = Clock::now() + std::chrono::milliseconds(kUnwatchedRescanMs);
+
+    if (inotify_fd_ >= 0 && tree_) {
+        WatchSubtree(*tree_, WorkspaceTree::kRoot, nullptr);
+    }
+    Logger::LogMessage("FileWatcher: Watching " + std::to_string(watch_count_.load()) + " directories of " + root_ +
+                       " (~" + std::to_string(watch_count_.load() * kKernelBytesPerWatch / (1024 * 1024)) +
+                       " MB kernel, " + std::to_string(user_bytes_.load() / 1024) + " KB bookkeeping)");
+    if (!unwatched_.empty()) {
+        Logger::LogMessage("FileWatcher: Watch limit reached; " + std::to_string(unwatched_.size()) +
+                           " subtrees are rescanned every " + std::to_string(kUnwatchedRescanMs / 1000) + " s instead");
+    }
+}
+
+// Breadth first, so running out of watches leaves out the deepest directories
+void FileWatcher::WatchSubtree(const WorkspaceTree& tree, uint32_t directory, std::vector<std::string>* added) {
+    std::deque<uint32_t> queue;
+    queue.push_back(directory);
+    while (!queue.empty()) {
+        uint32_t node = queue.front();
+        queue.pop_front();
+        std::string path = tree.GetPath(node);
+        if (IsExcluded(path)) {
+            continue;
+        }
+
+        bool watched = !kernel_full_ && watch_count_ < limit_ && AddWatch(path);
+        if (!watched) {
+            if (kernel_full_ || watch_count_ >= limit_) {
+                unwatched_.insert(path);
+            }
+            continue;
+        }
+        if (added) {
+            added->push_back(path);
+        }
+        uint32_t first = tree.GetFirstChild(node);
+        uint32_t end = first + tree.GetChildCount(node);
+        for (uint32_t child = first; child < end; ++child) {
+            if (tree.IsDirectory(child)) {
+                queue.push_back(child);
+            }
+        }
+    }
+    unwatched_count_ = unwatched_.size();
+}
+
+bool FileWatcher::AddWatch(const std::string& path) {
+    std::string full = path.empty() ? root_ : root_ + "/" + path;
+    int wd = inotify_add_watch(inotify_fd_, full.c_str(), kWatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !kernel_full_) {
+            Logger::LogError("FileWatcher: Out of inotify watches after " + std::to_string(watch_count_.load()) +
+                             "; raise fs.inotify.max_user_watches");
+            kernel_full_ = true;
+        }
+        return false;
+    }
+
+    // The kernel hands out one watch per directory, whatever path reaches it
+    auto existing = paths_.find(wd);
+    if (existing != paths_.end()) {
+        if (*existing->second == path) {
+            return true;
+        }
+        ForgetWatch(watches_.find(*existing->second));
+    }
+    auto inserted = watches_.emplace(path, wd);
+    if (inserted.second) {
+        ++watch_count_;
+        user_bytes_ += WatchBytes(path);
+    } else {
+        // A directory replaced under the same name
+        inotify_rm_watch(inotify_fd_, inserted.first->second);
+        paths_.erase(inserted.first->second);
+        inserted.first->second = wd;
+    }
+    paths_[wd] = &inserted.first->first;
+    return true;
+}
+
+// |path| and everything below it
+void FileWatcher::RemoveWatches(const std::string& path) {
+    std::string prefix = path + "/";
+    auto it = watches_.lower_bound(path);
+    while (it != watches_.end() && (it->first == path || it->first.compare(0, prefix.size(), prefix) == 0)) {
+        inotify_rm_watch(inotify_fd_, it->second);
+        it = ForgetWatch(it);
+    }
+    for (auto unwatched = unwatched_.lower_bound(path);
+         unwatched != unwatched_.end() && (*unwatched == path || unwatched->compare(0, prefix.size(), prefix) == 0);) {
+        unwatched = unwatched_.erase(unwatched);
+    }
+    unwatched_count_ = unwatched_.size();
+}
+
+std::map<std::string, int>::iterator FileWatcher::ForgetWatch(std::map<std::string, int>::iterator it) {
+    if (it == watches_.end()) {
+        return it;
+    }
+    paths_.erase(it->second);
+    --watch_count_;
+    user_bytes_ -= WatchBytes(it->first);
+    return watches_.erase(it);
+}
+
+void FileWatcher::ReadEvents(Clock::time_point now) {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                RecoverFromOverflow(now);
+                continue;
+            }
+            auto it = paths_.find(event->wd);
+            if (it == paths_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // Directory deleted or unmounted
+                ForgetWatch(watches_.find(*it->second));
+                continue;
+            }
+            if (event->len == 0) {
+                continue;       // The directory itself; its parent reports it too
+            }
+            std::string name = event->name;
+            bool is_directory = (event->mask & IN_ISDIR) != 0;
+            if (is_directory && name == ".git") {
+                continue;
+            }
+
+            const std::string& directory = *it->second;
+            std::string path = directory.empty() ? name : directory + "/" + name;
+            if (name == ".gitignore") {
+                ignore_rules_.clear();      // Rules below this directory may have changed
+            } else if (IsExcluded(path) || IsIgnored(directory, path, is_directory)) {
+                continue;
+            }
+            Change change = (event->mask & (IN_CREATE | IN_MOVED_TO)) ? CHANGE_CREATED :
+                            (event->mask & (IN_DELETE | IN_MOVED_FROM)) ? CHANGE_DELETED : CHANGE_MODIFIED;
+            if (changes_.empty() && refresh_.empty()) {
+                first_change_ = now;
+            }
+            last_change_ = now;
+            refresh_.insert(directory);
+            active_[directory] = now;
+            AddChange(path, change);
+        }
+    }
+    if (changes_.size() >= kMaxPendingChanges) {
+        Flush(now);
+    }
+}
+
+// At or below an excluded path, or a rotated copy of an excluded file
+bool FileWatcher::IsExcluded(const std::string& path) const {
+    for (const std::string& excluded : excluded_paths_) {
+        if (path.compare(0, excluded.size(), excluded) != 0) {
+            continue;
+        }
+        if (path.size() == excluded.size() || path[excluded.size()] == '/') {
+            return true;
+        }
+        if (path[excluded.size()] == '.' && path.size() > excluded.size() + 1 &&
+            path.find_first_not_of("0123456789", excluded.size() + 1) == std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The index leaves ignored files out, so their changes would only cost a refresh
+bool FileWatcher::IsIgnored(const std::string& directory, const std::string& path, bool is_directory) {
+    auto rules = ignore_rules_.find(directory);
+    if (rules == ignore_rules_.end()) {
+        rules = ignore_rules_.emplace(directory, WorkspaceIndex::LoadRulesFor(root_, path)).first;
+    }
+    return rules->second && rules->second->IsIgnored(path, is_directory);
+}
+
+void FileWatcher::AddChange(const std::string& path, Change change) {
+    auto inserted = changes_.emplace(path, change);
+    if (inserted.second) {
+        return;
+    }
+    Change& pending = inserted.first->second;
+    if (pending == CHANGE_CREATED && change == CHANGE_DELETED) {
+        changes_.erase(inserted.first);     // Came and went within one batch
+    } else if (pending == CHANGE_DELETED && change == CHANGE_CREATED) {
+        pending = CHANGE_MODIFIED;          // Replaced
+    } else if (change == CHANGE_DELETED) {
+        pending = CHANGE_DELETED;
+    }
+}
+
+// Events were dropped, so pending changes are incomplete. Queue overflows come
+// from bursts in a few busy trees (a checkout, a build writing its output),
+// and the lost events are the tail of that burst: rescan the subtrees of the
+// directories active just now, and the whole workspace only when the burst
+// was spread too wide to tell.
+void FileWatcher::RecoverFromOverflow(Clock::time_point now) {
+    ++overflow_count_;
+    std::set<std::string> targets(refresh_.begin(), refresh_.end());
+    for (const auto& entry : active_) {
+        if (now - entry.second <= std::chrono::milliseconds(kOverflowWindowMs)) {
+            targets.insert(entry.first);
+        }
+    }
+    if (targets.size() > kMaxOverflowTargets) {
+        std::set<std::string> top;
+        for (const std::string& target : targets) {
+            top.insert(target.substr(0, target.find('/')));
+        }
+        targets.swap(top);
+    }
+    if (targets.empty() || targets.size() > kMaxOverflowTargets) {
+        targets = { std::string() };
+    }
+    refresh_.clear();       // The rescan covers them
+
+    std::vector<std::string> rescanned(targets.begin(), targets.end());
+    Logger::LogMessage("FileWatcher: Event queue overflowed; rescanning " + std::to_string(rescanned.size()) +
+                       (rescanned.size() == 1 && rescanned[0].empty() ? " (whole workspace)" : " subtrees"));
+    WorkspaceIndex::GetInstance().Rescan(rescanned);
+    SimpleIPC::EventBus::GetInstance().Publish(kChangesTopic,
+        "{\"overflow\": true, \"rescanned\": " + JsonPaths(rescanned) + "}");
+}
+
+void FileWatcher::Flush(Clock::time_point now) {
+    if (!changes_.empty()) {
+        std::vector<std::string> lists[3];
+        for (const auto& entry : changes_) {
+            Change change = entry.second;
+            // Saves that write a temporary and rename it over the file arrive
+            // as a create of a path the tree already has
+            if (change == CHANGE_CREATED && tree_ && tree_->Find(entry.first) != WorkspaceTree::kNotFound) {
+                change = CHANGE_MODIFIED;
+            }
+            lists[change].push_back(entry.first);
+        }
+
+        // Split like the tree diffs, so no single delivery grows with the burst
+        size_t positions[3] = { 0, 0, 0 };
+        do {
+            std::string json = "{";
+            size_t budget = kMaxChangeEntries;
+            for (int kind = 0; kind < 3; ++kind) {
+                json += std::string(kind ? ", " : "") + "\"" + kChangeNames[kind] + "\": [";
+                for (bool first = true; positions[kind] < lists[kind].size() && budget > 0;
+                     ++positions[kind], --budget, first = false) {
+                    json += std::string(first ? "" : ",") + "\"" + SimpleIPC::EscapeJson(lists[kind][positions[kind]]) + "\"";
+                }
+                json += "]";
+            }
+            json += "}";
+            SimpleIPC::EventBus::GetInstance().Publish(kChangesTopic, json);
+        } while (positions[0] < lists[0].size() || positions[1] < lists[1].size() || positions[2] < lists[2].size());
+        changes_.clear();
+    }
+
+    if (!refresh_.empty()) {
+        WorkspaceIndex::GetInstance().Refresh(std::vector<std::string>(refresh_.begin(), refresh_.end()));
+        refresh_.clear();
+    }
+    for (auto it = active_.begin(); it != active_.end();) {
+        if (now - it->second > std::chrono::milliseconds(kOverflowWindowMs)) {
+            it = active_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Watches may have been freed since; whatever is still unwatched is read again
+void FileWatcher::RetryUnwatched() {
+    kernel_full_ = false;
+    std::set<std::string> unwatched;
+    unwatched.swap(unwatched_);
+    std::vector<std::string> rescan;
+    for (const std::string& path : unwatched) {
+        uint32_t node = tree_ ? tree_->Find(path) : WorkspaceTree::kNotFound;
+        if (node == WorkspaceTree::kNotFound || !tree_->IsDirectory(node)) {
+            continue;
+        }
+        WatchSubtree(*tree_, node, nullptr);
+        rescan.push_back(path);
+    }
+    unwatched_count_ = unwatched_.size();
+    WorkspaceIndex::GetInstance().Rescan(rescan);
+}
+
+#endif
+
+bool FileWatcher::HandleStatus(const std::string& message, int browser_id, const CancelToken& token,
+                               std::string& output, std::string& error) {
+    output = GetInstance().GetStatusJson();
+    return true;
+}
+
+void FileWatcher::RegisterCommands() {
+    SimpleIPC::IPCHandler::GetInstance().RegisterAsyncHandler("watcherStatus", HandleStatus);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "gitignore.hpp"
+#include "workspace_tree.hpp"
+#include "internal/simpleipc.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches the open workspace for changes made outside the app (Linux, inotify).
+//
+// One thread owns the inotify descriptor. It follows the WorkspaceIndex trees,
+// keeping one watch per indexed directory, and turns events into change sets:
+// events are coalesced per path (an atomic save's create/rename pair becomes a
+// single "modified") and flushed once the workspace has been quiet for the
+// debounce interval, or at the latest after kMaxDelayMs during a steady stream.
+// Events for files .gitignore excludes, and below the paths the app writes
+// itself (the browser cache, the log), are dropped before they count, so those
+// writes never trigger a refresh, which logs and writes again. Each flush
+// refreshes the affected directory listings in the index, which publishes the
+// tree diffs, and sends the change set to the page:
+//
+//   topic "workspace.changes"   -> {"created": [paths], "modified": [paths], "deleted": [paths]}
+//                                  {"overflow": true, "rescanned": [paths]} after lost events
+//   watcherStatus               -> {"watches", "limit", "kernelLimit", "unwatched",
+//                                   "kernelBytes", "userBytes", "overflows"}
+//
+// Watches are a per-user kernel resource (fs.inotify.max_user_watches, each
+// pinning about a kilobyte of kernel memory), so at most |limit| are used,
+// breadth first; directories beyond it are rescanned every kUnwatchedRescanMs
+// instead, and picked up once watches are freed. fanotify is not used: without
+// CAP_SYS_ADMIN it only offers per-inode marks, which scale no better.
+class FileWatcher {
+public:
+    // Largest number of paths in one workspace.changes event
+    static constexpr size_t kMaxChangeEntries = 2000;
+    // Longest a change waits while events keep arriving
+    static constexpr int kMaxDelayMs = 1000;
+    // How often directories left without a watch are rescanned
+    static constexpr int kUnwatchedRescanMs = 60000;
+    // Kernel memory per watch on 64-bit (inotify mark plus the pinned inode)
+    static constexpr size_t kKernelBytesPerWatch = 1080;
+
+    // Singleton access
+    static FileWatcher& GetInstance();
+
+    // Before Start(). |limit| 0 uses 90% of max_user_watches, leaving the rest
+    // to other programs of the same user. Nothing at or below the absolute
+    // paths in |excluded| is watched or reported; a file there also covers its
+    // rotated copies (<file>.1, ...).
+    void Configure(int limit, int debounce_ms, const std::vector<std::string>& excluded);
+
+    // Follow the trees of WorkspaceIndex and start the watcher thread
+    void Start();
+    void Shutdown();
+
+    std::string GetStatusJson() const;
+
+    // Any thread. True while every directory of the workspace tree is watched,
+    // so the tree misses no change made outside the app for longer than the
+    // debounce. Always false where there is no watcher.
+    bool IsWatchingAll() const;
+
+    // Register watcherStatus as an async IPC method
+    static void RegisterCommands();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Change {
+        CHANGE_CREATED,
+        CHANGE_MODIFIED,
+        CHANGE_DELETED
+    };
+
+    // A tree from WorkspaceIndex, waiting for the watcher thread
+    struct Update {
+        std::string root;
+        std::shared_ptr<const WorkspaceTree> tree;
+        TreeDiff diff;
+        bool reset;
+    };
+
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+
+    void OnTreeChanged(const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree,
+                       const TreeDiff& diff, bool reset);
+    void Wake();
+
+    // Watcher thread
+    void Run();
+    void ApplyUpdates();
+    void ResetWatches();
+    void WatchSubtree(const WorkspaceTree& tree, uint32_t directory, std::vector<std::string>* added);
+    bool AddWatch(const std::string& path);
+    void RemoveWatches(const std::string& path);
+    std::map<std::string, int>::iterator ForgetWatch(std::map<std::string, int>::iterator it);
+    void ReadEvents(Clock::time_point now);
+    bool IsExcluded(const std::string& path) const;
+    bool IsIgnored(const std::string& directory, const std::string& path, bool is_directory);
+    void AddChange(const std::string& path, Change change);
+    void RecoverFromOverflow(Clock::time_point now);
+    void Flush(Clock::time_point now);
+    void RetryUnwatched();
+    int GetTimeout(Clock::time_point now) const;
+
+    static bool HandleStatus(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error);
+
+    // Configuration
+    size_t limit_;
+    size_t kernel_limit_;
+    std::chrono::milliseconds debounce_;
+    std::vector<std::string> excluded_;
+
+    std::thread thread_;
+    std::atomic<bool> stop_;
+    int inotify_fd_;
+    int wake_fd_;
+
+    std::mutex mutex_;
+    std::vector<Update> updates_;               // Trees not applied yet
+
+    // Watcher thread only
+    std::string root_;
+    std::shared_ptr<const WorkspaceTree> tree_; // Newest tree applied
+    std::map<std::string, int> watches_;        // Relative directory -> watch; sorted for subtree removal
+    std::unordered_map<int, const std::string*> paths_;  // Watch -> key in watches_
+    std::set<std::string> unwatched_;           // Subtrees left out by the limit
+    std::vector<std::string> excluded_paths_;   // |excluded_| inside the root, relative
+    std::map<std::string, std::shared_ptr<const IgnoreRules>> ignore_rules_;  // By directory, loaded on its first event
+    bool kernel_full_;                          // max_user_watches ran out before limit_
+    std::map<std::string, Change> changes_;     // Pending change set
+    std::set<std::string> refresh_;             // Directories whose listing changed
+    std::map<std::string, Clock::time_point> active_;    // Directories with recent events
+    Clock::time_point first_change_;
+    Clock::time_point last_change_;
+    Clock::time_point next_unwatched_scan_;
+
+    // Readable from any thread
+    std::atomic<bool> running_;                 // Thread up with an inotify descriptor
+    std::atomic<size_t> watch_count_;
+    std::atomic<size_t> user_bytes_;
+    std::atomic<size_t> unwatched_count_;
+    std::atomic<uint64_t> overflow_count_;
+};
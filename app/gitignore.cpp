@@ -0,0 +1,182 @@
+#include "gitignore.hpp"
+
+namespace {
+    // [abc], [a-z], [!abc]; |pi| points after the '['. Returns false for an
+    // unterminated class, which then matches a literal '['.
+    bool MatchClass(std::string_view pattern, size_t& pi, char c, bool& matched) {
+        size_t i = pi;
+        bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate) {
+            ++i;
+        }
+        bool found = false;
+        bool first = true;
+        while (i < pattern.size() && (first || pattern[i] != ']')) {
+            char low = pattern[i];
+            char high = low;
+            if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+                high = pattern[i + 2];
+                i += 2;
+            }
+            if (c >= low && c <= high) {
+                found = true;
+            }
+            ++i;
+            first = false;
+        }
+        if (i >= pattern.size()) {
+            return false;
+        }
+        pi = i + 1;
+        matched = found != negate;
+        return true;
+    }
+}
+
+bool IgnoreRules::Match(std::string_view pattern, std::string_view text) {
+    size_t pi = 0;
+    size_t ti = 0;
+    while (pi < pattern.size()) {
+        char c = pattern[pi];
+        if (c == '*') {
+            if (pi + 1 < pattern.size() && pattern[pi + 1] == '*') {
+                pi += 2;
+                if (pi < pattern.size() && pattern[pi] == '/') {
+                    // "**/" matches zero or more whole directories
+                    std::string_view rest = pattern.substr(pi + 1);
+                    for (size_t k = ti; k <= text.size(); ++k) {
+                        if ((k == ti || text[k - 1] == '/') && Match(rest, text.substr(k))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                std::string_view rest = pattern.substr(pi);
+                for (size_t k = ti; k <= text.size(); ++k) {
+                    if (Match(rest, text.substr(k))) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            std::string_view rest = pattern.substr(pi + 1);
+            for (size_t k = ti; k <= text.size(); ++k) {
+                if (Match(rest, text.substr(k))) {
+                    return true;
+                }
+                if (k < text.size() && text[k] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        if (ti >= text.size()) {
+            return false;
+        }
+        if (c == '?') {
+            if (text[ti] == '/') {
+                return false;
+            }
+            ++pi;
+            ++ti;
+            continue;
+        }
+        if (c == '[') {
+            size_t class_end = pi + 1;
+            bool matched = false;
+            if (MatchClass(pattern, class_end, text[ti], matched)) {
+                if (!matched || text[ti] == '/') {
+                    return false;
+                }
+                pi = class_end;
+                ++ti;
+                continue;
+            }
+        }
+        if (c == '\\' && pi + 1 < pattern.size()) {
+            c = pattern[++pi];
+        }
+        if (c != text[ti]) {
+            return false;
+        }
+        ++pi;
+        ++ti;
+    }
+    return ti == text.size();
+}
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::Parse(std::shared_ptr<const IgnoreRules> parent,
+                                                      const std::string& base, std::string_view text) {
+    std::shared_ptr<IgnoreRules> rules(new IgnoreRules());
+    rules->parent_ = parent;
+    rules->base_ = base;
+
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        // Trailing spaces are dropped unless escaped
+        while (!line.empty() && line.back() == ' ' && (line.size() < 2 || line[line.size() - 2] != '\\')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Rule rule = { std::string(), false, false, false };
+        if (line[0] == '!') {
+            rule.negate = true;
+            line.remove_prefix(1);
+        } else if (line[0] == '\\') {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.directory_only = true;
+            line.remove_suffix(1);
+        }
+        if (!line.empty() && line[0] == '/') {
+            rule.anchored = true;
+            line.remove_prefix(1);
+        }
+        if (line.find('/') != std::string_view::npos) {
+            rule.anchored = true;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        rule.pattern = std::string(line);
+        rules->rules_.push_back(std::move(rule));
+    }
+    return rules;
+}
+
+bool IgnoreRules::IsIgnored(std::string_view path, bool directory) const {
+    std::string_view name = path.substr(path.rfind('/') + 1);
+
+    for (const IgnoreRules* rules = this; rules; rules = rules->parent_.get()) {
+        // Path below the directory of this .gitignore
+        std::string_view relative = path;
+        if (!rules->base_.empty()) {
+            if (path.size() <= rules->base_.size() || path.compare(0, rules->base_.size(), rules->base_) != 0 ||
+                path[rules->base_.size()] != '/') {
+                continue;
+            }
+            relative = path.substr(rules->base_.size() + 1);
+        }
+
+        for (auto it = rules->rules_.rbegin(); it != rules->rules_.rend(); ++it) {
+            if (it->directory_only && !directory) {
+                continue;
+            }
+            if (Match(it->pattern, it->anchored ? relative : name)) {
+                return !it->negate;
+            }
+        }
+    }
+    return false;
+}
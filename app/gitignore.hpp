@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Patterns of one .gitignore file, chained to the files of the parent
+// directories.
+//
+// Supports the usual syntax: '#' comments, '!' negation, a trailing '/' for
+// directories only, a leading or inner '/' anchoring the pattern to the file's
+// directory, and '*', '?', '[...]' and '**' wildcards. As in git, deeper files
+// win over their parents and later lines over earlier ones.
+class IgnoreRules {
+public:
+    // |base| is the directory holding the file, relative to the workspace root
+    // ("" for the root, no trailing slash)
+    static std::shared_ptr<const IgnoreRules> Parse(std::shared_ptr<const IgnoreRules> parent,
+                                                    const std::string& base, std::string_view text);
+
+    // |path| is relative to the workspace root
+    bool IsIgnored(std::string_view path, bool directory) const;
+
+    // Glob match of a whole string; '*' and '?' do not cross '/', "**" does
+    static bool Match(std::string_view pattern, std::string_view text);
+
+private:
+    struct Rule {
+        std::string pattern;
+        bool negate;
+        bool directory_only;
+        bool anchored;      // Matched against the path below |base_|, not just the name
+    };
+
+    IgnoreRules() {}
+
+    std::shared_ptr<const IgnoreRules> parent_;
+    std::string base_;
+    std::vector<Rule> rules_;
+};
@@ -0,0 +1,289 @@
+#include "binaryipc.hpp"
+#include "simpleipc.hpp"
+#include "include/cef_values.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SimpleIPC {
+
+    namespace {
+        // Frees the heap copy backing an ArrayBuffer handed to JS
+        class FreeBufferCallback : public CefV8ArrayBufferReleaseCallback {
+        public:
+            void ReleaseBuffer(void* buffer) override {
+                std::free(buffer);
+            }
+
+        private:
+            IMPLEMENT_REFCOUNTING(FreeBufferCallback);
+        };
+
+        // Browser process, UI thread: cancel tokens of the async calls in flight,
+        // by browser ID and request ID
+        typedef std::pair<int, int> CallKey;
+
+        std::map<CallKey, CancelToken>& GetPendingCalls() {
+            static std::map<CallKey, CancelToken> calls;
+            return calls;
+        }
+
+        CefRefPtr<CefBinaryValue> ToBinaryValue(const void* data, size_t size) {
+            return size > 0 ? CefBinaryValue::Create(data, size) : nullptr;
+        }
+
+        // nativeAPI.invoke(method, payload?)
+        class InvokeHandler : public CefV8Handler {
+        public:
+            explicit InvokeHandler(BinaryIPCRenderer* owner) : owner_(owner) {}
+
+            bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception) override {
+                if (arguments.empty()) {
+                    exception = "invoke: method is required";
+                    return true;
+                }
+
+                int method_id = METHOD_INVALID;
+                if (arguments[0]->IsString()) {
+                    method_id = FindMethodId(arguments[0]->GetStringValue().ToString().c_str());
+                } else if (arguments[0]->IsInt()) {
+                    method_id = arguments[0]->GetIntValue();
+                }
+                if (!FindMethodName(method_id)) {
+                    exception = "invoke: unknown method";
+                    return true;
+                }
+
+                // Payloads are read in place; the only copy is into the process message
+                const void* data = nullptr;
+                size_t size = 0;
+                std::string text;
+                CefRefPtr<CefV8Value> payload = arguments.size() > 1 ? arguments[1] : nullptr;
+                if (payload && payload->IsString()) {
+                    text = payload->GetStringValue().ToString();
+                    data = text.data();
+                    size = text.size();
+                } else if (payload && payload->IsArrayBuffer()) {
+                    data = payload->GetArrayBufferData();
+                    size = payload->GetArrayBufferByteLength();
+                } else if (payload && payload->IsObject() && payload->HasValue("buffer")) {
+                    // Typed array or DataView: view into its underlying ArrayBuffer
+                    CefRefPtr<CefV8Value> buffer = payload->GetValue("buffer");
+                    if (buffer && buffer->IsArrayBuffer()) {
+                        size_t offset = payload->GetValue("byteOffset")->GetUIntValue();
+                        size_t length = payload->GetValue("byteLength")->GetUIntValue();
+                        if (offset + length <= buffer->GetArrayBufferByteLength()) {
+                            data = static_cast<const uint8_t*>(buffer->GetArrayBufferData()) + offset;
+                            size = length;
+                        }
+                    }
+                } else if (payload && !payload->IsUndefined() && !payload->IsNull()) {
+                    exception = "invoke: payload must be an ArrayBuffer, typed array or string";
+                    return true;
+                }
+
+                retval = owner_->SendCall(CefV8Context::GetCurrentContext(), method_id, data, size);
+                return true;
+            }
+
+        private:
+            BinaryIPCRenderer* owner_;  // Owned by the render process handler, outlives contexts
+            IMPLEMENT_REFCOUNTING(InvokeHandler);
+        };
+    }
+
+    static void SendReply(CefRefPtr<CefFrame> frame, int request_id, bool success,
+                          const void* data, size_t size, const std::string& error) {
+        CefRefPtr<CefProcessMessage> reply = CefProcessMessage::Create(kBinaryReplyMessage);
+        CefRefPtr<CefListValue> reply_args = reply->GetArgumentList();
+        reply_args->SetInt(ARG_REQUEST_ID, request_id);
+        reply_args->SetBool(ARG_SUCCESS, success);
+        if (!success) {
+            reply_args->SetString(ARG_PAYLOAD, error);
+        } else if (CefRefPtr<CefBinaryValue> result = ToBinaryValue(data, size)) {
+            reply_args->SetBinary(ARG_PAYLOAD, result);
+        } else {
+            reply_args->SetNull(ARG_PAYLOAD);
+        }
+
+        frame->SendProcessMessage(PID_RENDERER, reply);
+    }
+
+    bool HandleBinaryCallMessage(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame,
+                                 CefRefPtr<CefProcessMessage> message) {
+        std::string message_name = message->GetName().ToString();
+        if (message_name == kBinaryCancelMessage) {
+            auto it = GetPendingCalls().find(
+                CallKey(browser->GetIdentifier(), message->GetArgumentList()->GetInt(ARG_REQUEST_ID)));
+            if (it != GetPendingCalls().end()) {
+                it->second.Cancel();
+                GetPendingCalls().erase(it);
+            }
+            return true;
+        }
+        if (message_name != kBinaryCallMessage) {
+            return false;
+        }
+
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        int request_id = args->GetInt(ARG_REQUEST_ID);
+        int method_id = args->GetInt(ARG_METHOD_ID);
+
+        // Read the payload in place (no copy out of the message)
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        CefRefPtr<CefBinaryValue> payload;
+        if (args->GetType(ARG_PAYLOAD) == VTYPE_BINARY) {
+            payload = args->GetBinary(ARG_PAYLOAD);
+            data = static_cast<const uint8_t*>(payload->GetRawData());
+            size = payload->GetSize();
+        }
+
+        IPCHandler& ipc = IPCHandler::GetInstance();
+        const char* name = FindMethodName(method_id);
+        if (name && ipc.IsAsync(name)) {
+            // Reply from the UI thread once the worker pool is done; a cancelled
+            // call never gets here and was already dropped from the pending calls
+            CallKey key(browser->GetIdentifier(), request_id);
+            GetPendingCalls()[key] = ipc.HandleCallAsync(
+                name, std::string(reinterpret_cast<const char*>(data), size), browser->GetIdentifier(),
+                [frame, request_id, key](bool success, const std::string& result) {
+                    GetPendingCalls().erase(key);
+                    if (frame->IsValid()) {
+                        SendReply(frame, request_id, success, result.data(), result.size(), result);
+                    }
+                });
+            return true;
+        }
+
+        std::vector<uint8_t> output;
+        std::string error;
+        bool success = ipc.HandleBinaryCall(method_id, data, size, output, error);
+        SendReply(frame, request_id, success, output.data(), output.size(), error);
+        return true;
+    }
+
+    void CancelBinaryCalls(CefRefPtr<CefBrowser> browser) {
+        std::map<CallKey, CancelToken>& calls = GetPendingCalls();
+        int browser_id = browser->GetIdentifier();
+        auto it = calls.lower_bound(CallKey(browser_id, 0));
+        while (it != calls.end() && it->first.first == browser_id) {
+            it->second.Cancel();
+            it = calls.erase(it);
+        }
+    }
+
+    BinaryIPCRenderer::BinaryIPCRenderer() : next_request_id_(1) {
+    }
+
+    void BinaryIPCRenderer::OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                             CefRefPtr<CefFrame> frame,
+                                             CefRefPtr<CefV8Context> context) {
+        CefRefPtr<CefV8Value> global = context->GetGlobal();
+
+        // Share window.nativeAPI with the string-based members InitializeIPC() adds
+        CefRefPtr<CefV8Value> api = global->GetValue("nativeAPI");
+        if (!api || !api->IsObject()) {
+            api = CefV8Value::CreateObject(nullptr, nullptr);
+            global->SetValue("nativeAPI", api, V8_PROPERTY_ATTRIBUTE_NONE);
+        }
+
+        api->SetValue("invoke", CefV8Value::CreateFunction("invoke", new InvokeHandler(this)),
+                      V8_PROPERTY_ATTRIBUTE_READONLY);
+
+        CefRefPtr<CefV8Value> methods = CefV8Value::CreateObject(nullptr, nullptr);
+        for (size_t i = 0; i < kMethodCount; ++i) {
+            methods->SetValue(kMethods[i].name, CefV8Value::CreateInt(kMethods[i].id),
+                              V8_PROPERTY_ATTRIBUTE_READONLY);
+        }
+        api->SetValue("methods", methods, V8_PROPERTY_ATTRIBUTE_READONLY);
+    }
+
+    void BinaryIPCRenderer::OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                              CefRefPtr<CefFrame> frame,
+                                              CefRefPtr<CefV8Context> context) {
+        // Replies for a released context have nowhere to go; stop the work too
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->second.context->IsSame(context)) {
+                if (frame && frame->IsValid()) {
+                    CefRefPtr<CefProcessMessage> cancel = CefProcessMessage::Create(kBinaryCancelMessage);
+                    cancel->GetArgumentList()->SetInt(ARG_REQUEST_ID, it->first);
+                    frame->SendProcessMessage(PID_BROWSER, cancel);
+                }
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    CefRefPtr<CefV8Value> BinaryIPCRenderer::SendCall(CefRefPtr<CefV8Context> context, int method_id,
+                                                      const void* data, size_t size) {
+        CefRefPtr<CefV8Value> promise = CefV8Value::CreatePromise();
+        int request_id = next_request_id_++;
+
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kBinaryCallMessage);
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        args->SetInt(ARG_REQUEST_ID, request_id);
+        args->SetInt(ARG_METHOD_ID, method_id);
+        if (CefRefPtr<CefBinaryValue> payload = ToBinaryValue(data, size)) {
+            args->SetBinary(ARG_PAYLOAD, payload);
+        } else {
+            args->SetNull(ARG_PAYLOAD);
+        }
+
+        pending_[request_id] = { context, promise };
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        return promise;
+    }
+
+    bool BinaryIPCRenderer::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                                     CefRefPtr<CefFrame> frame,
+                                                     CefProcessId source_process,
+                                                     CefRefPtr<CefProcessMessage> message) {
+        if (message->GetName().ToString() != kBinaryReplyMessage) {
+            return false;
+        }
+
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        auto it = pending_.find(args->GetInt(ARG_REQUEST_ID));
+        if (it == pending_.end()) {
+            return true;  // Context went away while the call was in flight
+        }
+        PendingCall call = it->second;
+        pending_.erase(it);
+
+        if (!call.context->IsValid() || !call.context->Enter()) {
+            return true;
+        }
+
+        if (args->GetBool(ARG_SUCCESS)) {
+            // Copy once into memory the ArrayBuffer owns and frees on GC
+            size_t size = 0;
+            void* buffer = nullptr;
+            if (args->GetType(ARG_PAYLOAD) == VTYPE_BINARY) {
+                CefRefPtr<CefBinaryValue> payload = args->GetBinary(ARG_PAYLOAD);
+                size = payload->GetSize();
+                buffer = std::malloc(size);
+                if (buffer) {
+                    payload->GetData(buffer, size, 0);
+                } else {
+                    size = 0;
+                }
+            }
+            call.promise->ResolvePromise(
+                CefV8Value::CreateArrayBuffer(buffer, size, new FreeBufferCallback()));
+        } else {
+            call.promise->RejectPromise(args->GetString(ARG_PAYLOAD));
+        }
+
+        call.context->Exit();
+        return true;
+    }
+}
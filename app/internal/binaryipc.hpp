@@ -0,0 +1,61 @@
+#pragma once
+
+#include "include/cef_browser.h"
+#include "include/cef_frame.h"
+#include "include/cef_process_message.h"
+#include "include/cef_v8.h"
+#include "ipcmethods.hpp"
+#include <map>
+
+// Binary IPC transport. Calls travel as CefProcessMessage lists carrying a
+// CefBinaryValue payload, so file contents and other large buffers never go
+// through string encoding, UTF-16 conversion or prefix splitting.
+//
+// JavaScript (installed by BinaryIPCRenderer in every V8 context):
+//   nativeAPI.invoke(method, payload?) -> Promise<ArrayBuffer>
+//     method:  name or ID from nativeAPI.methods
+//     payload: ArrayBuffer, typed array / DataView, string (sent as UTF-8) or nothing
+namespace SimpleIPC {
+    // Browser process: dispatch a kBinaryCallMessage and reply to the sending frame,
+    // or cancel the async call a kBinaryCancelMessage names. Returns false if
+    // |message| is neither.
+    bool HandleBinaryCallMessage(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame,
+                                 CefRefPtr<CefProcessMessage> message);
+
+    // Browser process: cancel the async calls |browser| still has in flight
+    void CancelBinaryCalls(CefRefPtr<CefBrowser> browser);
+
+    // Renderer process side: JS binding plus bookkeeping of in-flight calls
+    class BinaryIPCRenderer {
+    public:
+        BinaryIPCRenderer();
+
+        void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                              CefRefPtr<CefFrame> frame,
+                              CefRefPtr<CefV8Context> context);
+
+        // Drops the context's calls and cancels them in the browser process
+        void OnContextReleased(CefRefPtr<CefBrowser> browser,
+                               CefRefPtr<CefFrame> frame,
+                               CefRefPtr<CefV8Context> context);
+
+        // Returns true if |message| was a binary IPC reply
+        bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                      CefRefPtr<CefFrame> frame,
+                                      CefProcessId source_process,
+                                      CefRefPtr<CefProcessMessage> message);
+
+        // Called by the V8 binding; returns the promise handed back to JS
+        CefRefPtr<CefV8Value> SendCall(CefRefPtr<CefV8Context> context, int method_id,
+                                       const void* data, size_t size);
+
+    private:
+        struct PendingCall {
+            CefRefPtr<CefV8Context> context;
+            CefRefPtr<CefV8Value> promise;
+        };
+
+        std::map<int, PendingCall> pending_;
+        int next_request_id_;
+    };
+}
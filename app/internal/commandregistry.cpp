@@ -0,0 +1,69 @@
+#include "commandregistry.hpp"
+#include "../logger.hpp"
+
+namespace SimpleIPC {
+
+    CommandRegistry& CommandRegistry::GetInstance() {
+        static CommandRegistry instance;
+        return instance;
+    }
+
+    CommandRegistry::CommandRegistry() : slots_(), count_(0) {
+    }
+
+    Command* CommandRegistry::Insert(std::string_view name) {
+        if (name.size() > kMaxCommandLength) {
+            Logger::LogError("CommandRegistry: Name too long, cannot register " + std::string(name));
+            return nullptr;
+        }
+        uint64_t hash = HashCommand(name);
+        for (size_t i = 0; i < kCapacity; ++i) {
+            Command& slot = slots_[(hash + i) & (kCapacity - 1)];
+            if (slot.name.empty()) {
+                if (count_ >= kCapacity / 2) {
+                    break;
+                }
+                ++count_;
+                slot.hash = hash;
+                slot.name = name;
+                return &slot;
+            }
+            if (slot.hash == hash && slot.name == name) {
+                return &slot;
+            }
+        }
+        Logger::LogError("CommandRegistry: Table full, cannot register " + std::string(name));
+        return nullptr;
+    }
+
+    void CommandRegistry::Register(std::string_view name, CommandHandler handler) {
+        if (Command* command = Insert(name)) {
+            command->handler = handler;
+            command->async_handler = nullptr;
+        }
+    }
+
+    void CommandRegistry::RegisterAsync(std::string_view name, AsyncHandler handler) {
+        if (Command* command = Insert(name)) {
+            command->handler = nullptr;
+            command->async_handler = handler;
+        }
+    }
+
+    const Command* CommandRegistry::Find(std::string_view name) const {
+        if (name.empty()) {
+            return nullptr;
+        }
+        uint64_t hash = HashCommand(name);
+        for (size_t i = 0; i < kCapacity; ++i) {
+            const Command& slot = slots_[(hash + i) & (kCapacity - 1)];
+            if (slot.name.empty()) {
+                return nullptr;
+            }
+            if (slot.hash == hash && slot.name == name) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+}
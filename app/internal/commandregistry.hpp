@@ -0,0 +1,111 @@
+#pragma once
+
+#include "include/cef_browser.h"
+#include "include/cef_frame.h"
+#include "../worker_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Single dispatch table for everything the page can ask for through cefQuery:
+// window commands ("minimize_window") and IPC methods ("ipc_call:echo:hi").
+//
+// Names are hashed with FNV-1a (constexpr, so registrations of literals hash at
+// compile time) into a fixed open-addressed table. Lookups take a string_view
+// of the request and allocate nothing; requests arrive as UTF-16 (CefString) and
+// their ASCII prefixes and names are matched on that data in place, so only an
+// argument is ever converted to UTF-8. Modules register their own commands at
+// startup, before the first browser is created; the table is read-only after.
+namespace SimpleIPC {
+    constexpr uint64_t HashCommand(std::string_view name) {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : name) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Command names longer than this are rejected at registration
+    constexpr size_t kMaxCommandLength = 64;
+
+    inline bool StartsWithAscii(const char16_t* text, size_t length, std::string_view prefix) {
+        if (length < prefix.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            if (text[i] != static_cast<unsigned char>(prefix[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Narrow |length| UTF-16 units into |buffer|; false unless they are all ASCII
+    // and fit in |capacity|
+    inline bool NarrowAscii(const char16_t* text, size_t length, char* buffer, size_t capacity) {
+        if (length > capacity) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (text[i] >= 0x80) {
+                return false;
+            }
+            buffer[i] = static_cast<char>(text[i]);
+        }
+        return true;
+    }
+
+    // What a handler gets to see. |argument| views the request (the message of an
+    // ipc_call, empty for plain commands) and is only valid during the call.
+    struct CommandRequest {
+        CefRefPtr<CefBrowser> browser;      // Null for calls from the binary channel
+        CefRefPtr<CefFrame> frame;
+        std::string_view argument;
+    };
+
+    // UI thread. Fill |result|; on failure return false with the error in |result|.
+    typedef bool (*CommandHandler)(const CommandRequest& request, std::string& result);
+
+    // Worker pool (see IPCHandler::HandleCallAsync). |browser_id| identifies the
+    // calling browser, for events meant for it alone. Long-running handlers
+    // should poll |token|. Fill |output| (or |error| and return false).
+    typedef bool (*AsyncHandler)(const std::string& message, int browser_id, const CancelToken& token,
+                                 std::string& output, std::string& error);
+
+    struct Command {
+        uint64_t hash;
+        std::string_view name;              // Must outlive the registry (string literal)
+        CommandHandler handler;
+        AsyncHandler async_handler;         // Set instead of |handler| for async commands
+    };
+
+    class CommandRegistry {
+    public:
+        // Singleton access
+        static CommandRegistry& GetInstance();
+
+        // Startup only. Registering a name again replaces its handler.
+        void Register(std::string_view name, CommandHandler handler);
+        void RegisterAsync(std::string_view name, AsyncHandler handler);
+
+        // Any thread once startup is done; null if |name| is not registered
+        const Command* Find(std::string_view name) const;
+
+        size_t GetCount() const { return count_; }
+
+    private:
+        // Power of two, kept at most half full so probe chains stay short
+        static const size_t kCapacity = 128;
+
+        CommandRegistry();
+        CommandRegistry(const CommandRegistry&);
+        CommandRegistry& operator=(const CommandRegistry&);
+
+        Command* Insert(std::string_view name);
+
+        Command slots_[kCapacity];
+        size_t count_;
+    };
+}
@@ -0,0 +1,191 @@
+#include "eventbus.hpp"
+#include "commandregistry.hpp"
+#include "../logger.hpp"
+#include "include/cef_task.h"
+#include "include/wrapper/cef_helpers.h"
+#include <utility>
+
+namespace SimpleIPC {
+
+    namespace {
+        const char kSubscribePrefix[] = "subscribe:";
+        const size_t kSubscribePrefixLength = sizeof(kSubscribePrefix) - 1;
+
+        // One delivery per topic per frame at most
+        const int kFlushDelayMs = 16;
+
+        // A subscriber that cannot keep up loses the oldest events beyond this
+        const size_t kMaxPendingPerTopic = 4096;
+
+        class FlushTask : public CefTask {
+        public:
+            void Execute() override {
+                EventBus::GetInstance().Flush();
+            }
+
+        private:
+            IMPLEMENT_REFCOUNTING(FlushTask);
+        };
+    }
+
+    EventBus& EventBus::GetInstance() {
+        static EventBus instance;
+        return instance;
+    }
+
+    EventBus::EventBus() : flush_scheduled_(false) {
+    }
+
+    bool EventBus::Publish(const std::string& topic, const std::string& json,
+                           const std::string& coalesce_key) {
+        return Enqueue(0, topic, json, coalesce_key);
+    }
+
+    bool EventBus::Publish(int browser_id, const std::string& topic, const std::string& json,
+                           const std::string& coalesce_key) {
+        return browser_id != 0 && Enqueue(browser_id, topic, json, coalesce_key);
+    }
+
+    bool EventBus::Enqueue(int browser_id, const std::string& topic, const std::string& json,
+                           const std::string& coalesce_key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (subscriber_counts_.find(topic) == subscriber_counts_.end()) {
+                return false;
+            }
+            if (browser_id != 0) {
+                bool listening = false;
+                for (const auto& entry : subscriptions_) {
+                    if (entry.second.browser_id == browser_id && entry.second.topic == topic) {
+                        listening = true;
+                        break;
+                    }
+                }
+                if (!listening) {
+                    return false;
+                }
+            }
+
+            std::vector<PendingEvent>& events = pending_[topic];
+            if (!coalesce_key.empty()) {
+                for (PendingEvent& event : events) {
+                    if (event.browser_id == browser_id && event.coalesce_key == coalesce_key) {
+                        event.json = json;
+                        return true;
+                    }
+                }
+            }
+            if (events.size() >= kMaxPendingPerTopic) {
+                events.erase(events.begin());
+            }
+            events.push_back({ browser_id, coalesce_key, json });
+        }
+
+        if (!flush_scheduled_.exchange(true)) {
+            CefPostDelayedTask(TID_UI, new FlushTask(), kFlushDelayMs);
+        }
+        return true;
+    }
+
+    bool EventBus::HasSubscribers(const std::string& topic) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return subscriber_counts_.find(topic) != subscriber_counts_.end();
+    }
+
+    void EventBus::Flush() {
+        CEF_REQUIRE_UI_THREAD();
+        flush_scheduled_.store(false);
+
+        std::map<std::string, std::vector<PendingEvent>> pending;
+        std::vector<Subscription> subscriptions;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending.swap(pending_);
+            for (const auto& entry : subscriptions_) {
+                subscriptions.push_back(entry.second);
+            }
+        }
+
+        // Serialize each batch once per topic, however many subscribers it has;
+        // topics with targeted events get one batch per receiving browser
+        std::map<std::string, bool> targeted;
+        for (const auto& entry : pending) {
+            bool& any = targeted[entry.first];
+            for (const PendingEvent& event : entry.second) {
+                any = any || event.browser_id != 0;
+            }
+        }
+
+        std::map<std::pair<std::string, int>, std::string> batches;
+        for (const Subscription& subscription : subscriptions) {
+            auto events = pending.find(subscription.topic);
+            if (events == pending.end()) {
+                continue;
+            }
+            int receiver = targeted[subscription.topic] ? subscription.browser_id : 0;
+            auto it = batches.find(std::make_pair(subscription.topic, receiver));
+            if (it == batches.end()) {
+                std::string batch;
+                for (const PendingEvent& event : events->second) {
+                    if (event.browser_id == 0 || event.browser_id == receiver) {
+                        batch += batch.empty() ? "[" : ",";
+                        batch += event.json;
+                    }
+                }
+                batch += batch.empty() ? "" : "]";
+                it = batches.emplace(std::make_pair(subscription.topic, receiver), batch).first;
+            }
+            if (!it->second.empty()) {
+                subscription.callback->Success(it->second);
+            }
+        }
+    }
+
+    bool EventBus::OnQuery(CefRefPtr<CefBrowser> browser,
+                           CefRefPtr<CefFrame> frame,
+                           int64_t query_id,
+                           const CefString& request,
+                           bool persistent,
+                           CefRefPtr<CefMessageRouterBrowserSide::Callback> callback) {
+        CEF_REQUIRE_UI_THREAD();
+
+        // Every query the client declines passes here; convert only subscriptions
+        const char16_t* text = request.c_str();
+        size_t length = request.length();
+        if (!StartsWithAscii(text, length, kSubscribePrefix)) {
+            return false;
+        }
+
+        std::string topic = CefString(text + kSubscribePrefixLength, length - kSubscribePrefixLength, false).ToString();
+        if (!persistent || topic.empty()) {
+            callback->Failure(0, "subscribe needs a topic and a persistent query");
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_[SubscriptionKey(browser->GetIdentifier(), query_id)] = { topic, browser->GetIdentifier(), callback };
+        ++subscriber_counts_[topic];
+        Logger::LogVerbose("EventBus: Subscribed to " + topic + " (query " + std::to_string(query_id) + ")");
+        return true;
+    }
+
+    void EventBus::OnQueryCanceled(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefFrame> frame,
+                                   int64_t query_id) {
+        CEF_REQUIRE_UI_THREAD();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscriptions_.find(SubscriptionKey(browser->GetIdentifier(), query_id));
+        if (it == subscriptions_.end()) {
+            return;
+        }
+
+        auto count = subscriber_counts_.find(it->second.topic);
+        if (count != subscriber_counts_.end() && --count->second == 0) {
+            pending_.erase(count->first);
+            subscriber_counts_.erase(count);
+        }
+        Logger::LogVerbose("EventBus: Unsubscribed from " + it->second.topic);
+        subscriptions_.erase(it);
+    }
+}
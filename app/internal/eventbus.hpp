@@ -0,0 +1,86 @@
+#pragma once
+
+#include "include/wrapper/cef_message_router.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Native-to-web publish/subscribe bus on top of persistent cefQuery callbacks.
+//
+// The page subscribes once with nativeAPI.subscribe(topic, listener); every
+// delivery after that is a Success() on the same persistent query, so events
+// never compile a fresh JavaScript string. Events published from any thread are
+// batched per topic and flushed on the UI thread at most once per frame; events
+// sharing a coalesce key within a batch collapse to the newest one. Events that
+// answer one page's request (a search it started, a menu command in its window)
+// are published to the subscriptions of that browser only.
+//
+// Wire format of a delivery: JSON array of the event payloads, oldest first.
+namespace SimpleIPC {
+    class EventBus : public CefMessageRouterBrowserSide::Handler {
+    public:
+        // Singleton access
+        static EventBus& GetInstance();
+
+        // Any thread. |json| must be a complete JSON value. A non-empty
+        // |coalesce_key| replaces a pending event of the same topic and key (e.g.
+        // progress of one download). Returns false when nobody listens to |topic|.
+        bool Publish(const std::string& topic, const std::string& json,
+                     const std::string& coalesce_key = std::string());
+
+        // Any thread. As above, delivered only to subscriptions made by the
+        // browser with ID |browser_id|; false when it does not listen to |topic|.
+        bool Publish(int browser_id, const std::string& topic, const std::string& json,
+                     const std::string& coalesce_key = std::string());
+
+        bool HasSubscribers(const std::string& topic);
+
+        // CefMessageRouterBrowserSide::Handler methods ("subscribe:<topic>" queries)
+        bool OnQuery(CefRefPtr<CefBrowser> browser,
+                     CefRefPtr<CefFrame> frame,
+                     int64_t query_id,
+                     const CefString& request,
+                     bool persistent,
+                     CefRefPtr<CefMessageRouterBrowserSide::Callback> callback) override;
+
+        void OnQueryCanceled(CefRefPtr<CefBrowser> browser,
+                             CefRefPtr<CefFrame> frame,
+                             int64_t query_id) override;
+
+        // UI thread: deliver everything pending
+        void Flush();
+
+    private:
+        struct Subscription {
+            std::string topic;
+            int browser_id;
+            CefRefPtr<CefMessageRouterBrowserSide::Callback> callback;
+        };
+
+        // Query IDs come from each client's own message router, so they
+        // repeat across windows; the browser ID makes them unique
+        typedef std::pair<int, int64_t> SubscriptionKey;
+
+        struct PendingEvent {
+            int browser_id;                 // 0: every subscriber of the topic
+            std::string coalesce_key;
+            std::string json;
+        };
+
+        EventBus();
+        EventBus(const EventBus&);
+        EventBus& operator=(const EventBus&);
+
+        bool Enqueue(int browser_id, const std::string& topic, const std::string& json,
+                     const std::string& coalesce_key);
+
+        std::mutex mutex_;
+        std::map<SubscriptionKey, Subscription> subscriptions_;         // By browser and query ID
+        std::map<std::string, int> subscriber_counts_;                  // By topic
+        std::map<std::string, std::vector<PendingEvent>> pending_;      // By topic
+        std::atomic<bool> flush_scheduled_;
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// Method-ID table for the binary IPC channel. Shared by the browser process
+// (dispatch) and the renderer process (JS binding), so both sides agree on the
+// numbering without sending method names over the wire.
+namespace SimpleIPC {
+    // Process message names
+    constexpr const char kBinaryCallMessage[] = "SimpleIPC.Call";    // [request_id, method_id, payload]
+    constexpr const char kBinaryReplyMessage[] = "SimpleIPC.Reply";  // [request_id, success, payload | error]
+    constexpr const char kBinaryCancelMessage[] = "SimpleIPC.Cancel"; // [request_id]; no reply follows
+
+    // Argument positions in the messages
+    enum BinaryMessageArg {
+        ARG_REQUEST_ID = 0,
+        ARG_METHOD_ID = 1,   // Call only
+        ARG_SUCCESS = 1,     // Reply only
+        ARG_PAYLOAD = 2
+    };
+
+    // Stable method IDs; append new methods, never renumber
+    enum MethodId {
+        METHOD_INVALID = 0,
+        METHOD_PING = 1,
+        METHOD_GET_SYSTEM_INFO = 2,
+        METHOD_ECHO = 3,
+        METHOD_ECHO_BINARY = 4,
+        METHOD_LIST_DIRECTORY = 5,
+        METHOD_STAT = 6,
+        METHOD_READ_FILE = 7,
+        METHOD_READ_RANGE = 8,
+        METHOD_WORKSPACE_OPEN = 9,
+        METHOD_WORKSPACE_CHILDREN = 10,
+        METHOD_SEARCH = 11,
+        METHOD_SEARCH_CANCEL = 12
+    };
+
+    struct MethodInfo {
+        MethodId id;
+        const char* name;   // Name used by nativeAPI.call() and nativeAPI.invoke()
+    };
+
+    constexpr MethodInfo kMethods[] = {
+        { METHOD_PING, "ping" },
+        { METHOD_GET_SYSTEM_INFO, "getSystemInfo" },
+        { METHOD_ECHO, "echo" },
+        { METHOD_ECHO_BINARY, "echoBinary" },
+        { METHOD_LIST_DIRECTORY, "listDirectory" },
+        { METHOD_STAT, "stat" },
+        { METHOD_READ_FILE, "readFile" },
+        { METHOD_READ_RANGE, "readRange" },
+        { METHOD_WORKSPACE_OPEN, "workspaceOpen" },
+        { METHOD_WORKSPACE_CHILDREN, "workspaceChildren" },
+        { METHOD_SEARCH, "search" },
+        { METHOD_SEARCH_CANCEL, "searchCancel" }
+    };
+
+    constexpr size_t kMethodCount = sizeof(kMethods) / sizeof(kMethods[0]);
+
+    inline MethodId FindMethodId(const char* name) {
+        for (size_t i = 0; i < kMethodCount; ++i) {
+            if (std::strcmp(kMethods[i].name, name) == 0) {
+                return kMethods[i].id;
+            }
+        }
+        return METHOD_INVALID;
+    }
+
+    inline const char* FindMethodName(int id) {
+        for (size_t i = 0; i < kMethodCount; ++i) {
+            if (kMethods[i].id == id) {
+                return kMethods[i].name;
+            }
+        }
+        return nullptr;
+    }
+}
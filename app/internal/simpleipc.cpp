@@ -1,30 +1,157 @@
 #include "simpleipc.hpp"
 #include "include/cef_version.h"
+#include "include/cef_task.h"
+#include "include/wrapper/cef_helpers.h"
+#include <cstdio>
+#include <filesystem>
 #include <sstream>
 #include <chrono>
 #include <ctime>
 
 namespace SimpleIPC {
     
+    namespace {
+        // Delivers an async result back on the UI thread
+        class CompletionTask : public CefTask {
+        public:
+            CompletionTask(CompletionCallback done, CancelToken token, bool success, std::string result)
+                : done_(std::move(done)), token_(token), success_(success), result_(std::move(result)) {}
+            
+            void Execute() override {
+                // The query may have been cancelled while the worker was finishing
+                if (!token_.IsCancelled()) {
+                    done_(success_, result_);
+                }
+            }
+            
+        private:
+            CompletionCallback done_;
+            CancelToken token_;
+            bool success_;
+            std::string result_;
+            IMPLEMENT_REFCOUNTING(CompletionTask);
+        };
+    }
+    
+    std::string EscapeJson(std::string_view value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                escaped += buffer;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+    
     IPCHandler::IPCHandler() {
-        // Register default handlers
-        RegisterHandler("ping", HandlePing);
-        RegisterHandler("getSystemInfo", HandleGetSystemInfo);
-        RegisterHandler("echo", HandleEcho);
-    }
-    
-    std::string IPCHandler::HandleCall(const std::string& method, const std::string& message) {
-        auto it = handlers_.find(method);
-        if (it != handlers_.end()) {
-            // Call the handler directly without exception handling since CEF disables exceptions
-            return it->second(message);
-        } else {
-            return "Error: Unknown method: " + method;
+        // Register default binary handlers (string methods: RegisterDefaultMethods)
+        RegisterBinaryHandler(METHOD_ECHO_BINARY, HandleEchoBinary);
+    }
+    
+    void RegisterDefaultMethods() {
+        IPCHandler& ipc = IPCHandler::GetInstance();
+        ipc.RegisterHandler("ping", HandlePing);
+        ipc.RegisterHandler("getSystemInfo", HandleGetSystemInfo);
+        ipc.RegisterHandler("echo", HandleEcho);
+        ipc.RegisterAsyncHandler("listDirectory", HandleListDirectory);
+    }
+    
+    std::string IPCHandler::HandleCall(std::string_view method, std::string_view message) {
+        const Command* command = CommandRegistry::GetInstance().Find(method);
+        if (!command || !command->handler) {
+            return "Error: Unknown method: " + std::string(method);
         }
+        
+        // Call the handler directly without exception handling since CEF disables exceptions
+        CommandRequest request;
+        request.argument = message;
+        std::string result;
+        if (!command->handler(request, result)) {
+            return "Error: " + result;
+        }
+        return result;
     }
     
-    void IPCHandler::RegisterHandler(const std::string& method, MessageHandler handler) {
-        handlers_[method] = handler;
+    void IPCHandler::RegisterHandler(std::string_view method, CommandHandler handler) {
+        CommandRegistry::GetInstance().Register(method, handler);
+    }
+    
+    bool IPCHandler::HandleBinaryCall(int method_id, const uint8_t* data, size_t size,
+                                      std::vector<uint8_t>& output, std::string& error) {
+        auto it = binary_handlers_.find(method_id);
+        if (it != binary_handlers_.end()) {
+            return it->second(data, size, output, error);
+        }
+        
+        // Fall back to the string handler registered under the method's name
+        const char* name = FindMethodName(method_id);
+        const Command* command = name ? CommandRegistry::GetInstance().Find(name) : nullptr;
+        if (!command || !command->handler) {
+            error = "Unknown method ID: " + std::to_string(method_id);
+            return false;
+        }
+        CommandRequest request;
+        request.argument = std::string_view(reinterpret_cast<const char*>(data), size);
+        std::string result;
+        if (!command->handler(request, result)) {
+            error = result;
+            return false;
+        }
+        output.assign(result.begin(), result.end());
+        return true;
+    }
+    
+    void IPCHandler::RegisterBinaryHandler(MethodId method_id, BinaryHandler handler) {
+        binary_handlers_[method_id] = handler;
+    }
+    
+    void IPCHandler::RegisterAsyncHandler(std::string_view method, AsyncHandler handler) {
+        CommandRegistry::GetInstance().RegisterAsync(method, handler);
+    }
+    
+    bool IPCHandler::IsAsync(std::string_view method) const {
+        const Command* command = CommandRegistry::GetInstance().Find(method);
+        return command && command->async_handler;
+    }
+    
+    CancelToken IPCHandler::HandleCallAsync(std::string_view method, const std::string& message, int browser_id,
+                                            CompletionCallback done) {
+        CEF_REQUIRE_UI_THREAD();
+        
+        // Failures are reported through a posted task as well: callers file the
+        // returned token under the request only after this returns
+        CancelToken token;
+        const Command* command = CommandRegistry::GetInstance().Find(method);
+        if (!command || !command->async_handler) {
+            CefPostTask(TID_UI, new CompletionTask(done, token, false, "Unknown method: " + std::string(method)));
+            return token;
+        }
+        
+        AsyncHandler handler = command->async_handler;
+        bool submitted = WorkerPool::GetInstance().Submit([handler, message, browser_id, token, done]() {
+            if (token.IsCancelled()) {
+                return;
+            }
+            std::string output;
+            std::string error;
+            bool success = handler(message, browser_id, token, output, error);
+            if (token.IsCancelled()) {
+                return;
+            }
+            CefPostTask(TID_UI, new CompletionTask(done, token, success, success ? output : error));
+        });
+        if (!submitted) {
+            CefPostTask(TID_UI, new CompletionTask(done, token, false, "Worker pool is shut down"));
+        }
+        return token;
     }
     
     IPCHandler& IPCHandler::GetInstance() {
@@ -37,7 +164,8 @@ namespace SimpleIPC {
         
         // Inject JavaScript code to create the nativeAPI object
         std::string js_code = R"(
-            window.nativeAPI = {
+            // Keep members the renderer binding (invoke, methods) already installed
+            window.nativeAPI = Object.assign(window.nativeAPI || {}, {
                 call: function(method, message) {
                     // This will be handled by cefQuery in the browser process
                     return new Promise(function(resolve, reject) {
@@ -55,30 +183,130 @@ namespace SimpleIPC {
                             reject(new Error('CEF Query not available'));
                         }
                     });
+                },
+                // Push events from native code (see eventbus.hpp). Returns an unsubscribe function.
+                subscribe: function(topic, listener) {
+                    if (!window.cefQuery) {
+                        throw new Error('CEF Query not available');
+                    }
+                    var id = window.cefQuery({
+                        request: 'subscribe:' + topic,
+                        persistent: true,
+                        onSuccess: function(batch) {
+                            JSON.parse(batch).forEach(function(event) { listener(event); });
+                        },
+                        onFailure: function(error_code, error_message) {
+                            console.error('nativeAPI.subscribe(' + topic + '): ' + error_message);
+                        }
+                    });
+                    return function() { window.cefQueryCancel(id); };
+                },
+                // Stream a file over the binary channel (see FileService): onChunk(ArrayBuffer, offset)
+                // runs for each chunk in order, the next one already in flight. Resolves with the size.
+                readFileChunks: function(path, onChunk) {
+                    var api = window.nativeAPI;
+                    return api.invoke('stat', path).then(function(buffer) {
+                        var info = JSON.parse(new TextDecoder().decode(buffer));
+                        if (info.directory) {
+                            throw new Error(path + ' is a directory');
+                        }
+                        function read(offset) {
+                            return api.invoke('readRange', offset + ':' + info.chunkSize + ':' + path);
+                        }
+                        function consume(offset, pending) {
+                            return pending.then(function(chunk) {
+                                // An empty chunk before the end means the file shrank meanwhile
+                                if (chunk.byteLength === 0) {
+                                    return offset;
+                                }
+                                var next = offset + chunk.byteLength;
+                                var following = next < info.size ? read(next) : null;
+                                onChunk(chunk, offset);
+                                return following ? consume(next, following) : next;
+                            });
+                        }
+                        return info.size > 0 ? consume(0, read(0)) : 0;
+                    });
+                },
+                // Find in files (see WorkspaceSearch): onResults(results) runs for each batch of
+                // {path, line, column, text, textOffset}; resolves with the summary once the search
+                // is done or cancelled. Starting another search cancels this one.
+                search: function(query, flags, onResults) {
+                    var api = window.nativeAPI;
+                    return new Promise(function(resolve, reject) {
+                        var id = null;
+                        var early = [];
+                        function handle(event) {
+                            if (event.id !== id) {
+                                return;
+                            }
+                            if (event.results) {
+                                onResults(event.results);
+                            }
+                            if (event.done) {
+                                unsubscribe();
+                                resolve(event);
+                            }
+                        }
+                        // Subscribed first, so no batch is published before anyone listens
+                        var unsubscribe = api.subscribe('workspace.search', function(event) {
+                            if (id === null) {
+                                early.push(event);
+                            } else {
+                                handle(event);
+                            }
+                        });
+                        api.call('search', (flags || '') + ':' + query).then(function(response) {
+                            id = JSON.parse(response).id;
+                            early.splice(0).forEach(handle);
+                        }, function(error) {
+                            unsubscribe();
+                            reject(error);
+                        });
+                    });
+                },
+                // Tell the native side the UI is usable (see LoadingManager)
+                appReady: function() {
+                    if (window.cefQuery) {
+                        window.cefQuery({ request: 'app_ready', onSuccess: function() {}, onFailure: function() {} });
+                    }
                 }
-            };
+            });
+            
+            // Report the first contentful paint once per document
+            if (window.PerformanceObserver && window.cefQuery && !window.__nativePaintObserver) {
+                window.__nativePaintObserver = new PerformanceObserver(function(list) {
+                    list.getEntries().forEach(function(entry) {
+                        if (entry.name === 'first-contentful-paint') {
+                            window.__nativePaintObserver.disconnect();
+                            window.cefQuery({ request: 'first_paint', onSuccess: function() {}, onFailure: function() {} });
+                        }
+                    });
+                });
+                window.__nativePaintObserver.observe({ type: 'paint', buffered: true });
+            }
         )";
         
         frame->ExecuteJavaScript(js_code, frame->GetURL(), 0);
     }
     
-    std::string HandlePing(const std::string& message) {
+    bool HandlePing(const CommandRequest& request, std::string& result) {
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
         
         std::stringstream ss;
         ss << "Pong! Server time: " << std::ctime(&time_t);
-        std::string result = ss.str();
+        result = ss.str();
         
         // Remove trailing newline
         if (!result.empty() && result.back() == '\n') {
             result.pop_back();
         }
         
-        return result;
+        return true;
     }
     
-    std::string HandleGetSystemInfo(const std::string& message) {
+    bool HandleGetSystemInfo(const CommandRequest& request, std::string& result) {
         std::stringstream ss;
         ss << "{";
 #ifdef _WIN32
@@ -92,10 +320,51 @@ namespace SimpleIPC {
         ss << "\"timestamp\": \"" << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() << "\"";
         ss << "}";
         
-        return ss.str();
+        result = ss.str();
+        return true;
+    }
+    
+    bool HandleEcho(const CommandRequest& request, std::string& result) {
+        result = "Echo: ";
+        result.append(request.argument.data(), request.argument.size());
+        return true;
     }
     
-    std::string HandleEcho(const std::string& message) {
-        return "Echo: " + message;
+    bool HandleEchoBinary(const uint8_t* data, size_t size,
+                          std::vector<uint8_t>& output, std::string& error) {
+        output.assign(data, data + size);
+        return true;
+    }
+    
+    bool HandleListDirectory(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error) {
+        std::error_code ec;
+        std::filesystem::directory_iterator it(std::filesystem::u8path(message), ec), end;
+        if (ec) {
+            error = "Cannot list " + message + ": " + ec.message();
+            return false;
+        }
+        
+        // [{"name": "...", "directory": true}, ...]
+        output = "[";
+        bool first = true;
+        for (; !ec && it != end; it.increment(ec)) {
+            if (token.IsCancelled()) {
+                error = "Cancelled";
+                return false;
+            }
+            std::error_code type_ec;
+            bool directory = it->is_directory(type_ec);
+            output += first ? "" : ",";
+            output += "{\"name\": \"" + EscapeJson(it->path().filename().u8string()) + "\", ";
+            output += "\"directory\": " + std::string(directory ? "true" : "false") + "}";
+            first = false;
+        }
+        if (ec) {
+            error = "Cannot list " + message + ": " + ec.message();
+            return false;
+        }
+        output += "]";
+        return true;
     }
 }
\ No newline at end of file
@@ -2,37 +2,76 @@
 
 #include "include/cef_browser.h"
 #include "include/cef_frame.h"
+#include "ipcmethods.hpp"
+#include "commandregistry.hpp"
+#include "../worker_pool.hpp"
 #include <string>
+#include <string_view>
 #include <functional>
 #include <map>
+#include <vector>
+#include <cstdint>
 
 namespace SimpleIPC {
-    // Message handler callback type
-    using MessageHandler = std::function<std::string(const std::string&)>;
+    // Binary handler: |data| points into the incoming process message and is only
+    // valid during the call. Fill |output| (or |error| and return false).
+    using BinaryHandler = std::function<bool(const uint8_t* data, size_t size,
+                                             std::vector<uint8_t>& output, std::string& error)>;
     
-    // IPC Handler class for ExecuteJavaScript-based communication
+    // Result of an async call, delivered on the UI thread
+    using CompletionCallback = std::function<void(bool success, const std::string& result)>;
+    
+    // IPC Handler class for ExecuteJavaScript-based communication. String methods
+    // live in the shared CommandRegistry; this class adds the call conventions.
     class IPCHandler {
     public:
         IPCHandler();
         
         // Handle IPC call
-        std::string HandleCall(const std::string& method, const std::string& message);
+        std::string HandleCall(std::string_view method, std::string_view message);
+        
+        // Register a message handler (startup only)
+        void RegisterHandler(std::string_view method, CommandHandler handler);
+        
+        // Binary channel: methods are addressed by ID (see ipcmethods.hpp). Methods
+        // without a binary handler fall back to their string handler, with the
+        // payload taken as UTF-8.
+        bool HandleBinaryCall(int method_id, const uint8_t* data, size_t size,
+                              std::vector<uint8_t>& output, std::string& error);
+        void RegisterBinaryHandler(MethodId method_id, BinaryHandler handler);
         
-        // Register a message handler
-        void RegisterHandler(const std::string& method, MessageHandler handler);
+        // Handlers that may block (file system, child processes) register as async
+        void RegisterAsyncHandler(std::string_view method, AsyncHandler handler);
+        bool IsAsync(std::string_view method) const;
+        
+        // UI thread: run an async handler for |browser_id| on the worker pool. |done|
+        // runs on the UI thread when it finishes, unless the returned token was
+        // cancelled first.
+        CancelToken HandleCallAsync(std::string_view method, const std::string& message, int browser_id,
+                                    CompletionCallback done);
         
         // Get singleton instance
         static IPCHandler& GetInstance();
         
     private:
-        std::map<std::string, MessageHandler> handlers_;
+        std::map<int, BinaryHandler> binary_handlers_;
     };
     
+    // Register the built-in IPC methods with the CommandRegistry
+    void RegisterDefaultMethods();
+    
+    // Escape |value| for use inside a JSON string literal
+    std::string EscapeJson(std::string_view value);
+    
     // Initialize IPC system with ExecuteJavaScript
     void InitializeIPC(CefRefPtr<CefFrame> frame);
     
     // Test methods
-    std::string HandlePing(const std::string& message);
-    std::string HandleGetSystemInfo(const std::string& message);
-    std::string HandleEcho(const std::string& message);
+    bool HandlePing(const CommandRequest& request, std::string& result);
+    bool HandleGetSystemInfo(const CommandRequest& request, std::string& result);
+    bool HandleEcho(const CommandRequest& request, std::string& result);
+    bool HandleEchoBinary(const uint8_t* data, size_t size,
+                          std::vector<uint8_t>& output, std::string& error);
+    bool HandleListDirectory(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error);
 }
\ No newline at end of file
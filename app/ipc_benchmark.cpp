@@ -0,0 +1,257 @@
+#include "ipc_benchmark.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include "internal/commandregistry.hpp"
+#include "internal/eventbus.hpp"
+#include "include/views/cef_window.h"
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <string_view>
+
+// Global variables
+extern CefRefPtr<CefWindow> g_cef_window;
+
+namespace IPCBenchmark {
+
+    static const char* kPagePath = "/__ipc_benchmark.html";
+
+    // Test page. Everything runs sequentially so samples never overlap.
+    static const char kPageHtml[] = R"HTML(<!DOCTYPE html>
+<html>
+<head><meta charset="utf-8"><title>IPC benchmark</title></head>
+<body>
+<pre id="log"></pre>
+<script>
+(function() {
+    var SIZES = [16, 256, 4096, 65536, 1048576, 16777216];
+    var PUSH_COUNT = 1000;
+
+    function log(line) {
+        document.getElementById('log').textContent += line + '\n';
+    }
+
+    function query(request, persistent, onEvent) {
+        return new Promise(function(resolve, reject) {
+            var id = window.cefQuery({
+                request: request,
+                persistent: !!persistent,
+                onSuccess: function(response) { persistent ? onEvent(response) : resolve(response); },
+                onFailure: function(code, message) { reject(new Error(message)); }
+            });
+            if (persistent) {
+                resolve(id);
+            }
+        });
+    }
+
+    // About 32 MB moved per size, bounded to keep small sizes statistically useful
+    function iterations(size) {
+        return Math.max(5, Math.min(2000, Math.floor(32 * 1048576 / size)));
+    }
+
+    function percentile(sorted, p) {
+        return sorted[Math.min(sorted.length - 1, Math.floor(p / 100 * sorted.length))];
+    }
+
+    async function measure(size, send) {
+        for (var i = 0; i < 3; i++) {
+            await send();
+        }
+        var count = iterations(size);
+        var samples = [];
+        var start = performance.now();
+        for (var j = 0; j < count; j++) {
+            var t = performance.now();
+            await send();
+            samples.push(performance.now() - t);
+        }
+        var total = performance.now() - start;
+        samples.sort(function(a, b) { return a - b; });
+        return {
+            size: size,
+            iterations: count,
+            p50_ms: percentile(samples, 50),
+            p90_ms: percentile(samples, 90),
+            p99_ms: percentile(samples, 99),
+            max_ms: samples[samples.length - 1],
+            // Payload travels both ways
+            throughput_mb_s: (2 * size * count / 1048576) / (total / 1000)
+        };
+    }
+
+    async function benchQuery(size) {
+        var payload = 'x'.repeat(size);
+        var request = 'ipc_call:bench_echo:' + payload;
+        var response = await query(request);
+        if (response.length !== size) {
+            throw new Error('cefQuery echo returned ' + response.length + ' bytes, expected ' + size);
+        }
+        return measure(size, function() { return query(request); });
+    }
+
+    async function benchBinary(size) {
+        var payload = new Uint8Array(size);
+        var response = await window.nativeAPI.invoke('echoBinary', payload);
+        if (response.byteLength !== size) {
+            throw new Error('binary echo returned ' + response.byteLength + ' bytes, expected ' + size);
+        }
+        return measure(size, function() { return window.nativeAPI.invoke('echoBinary', payload); });
+    }
+
+    async function benchExecuteJavaScript() {
+        var received = 0;
+        var done;
+        var delivered = new Promise(function(resolve) { done = resolve; });
+        window.__benchPush = function() {
+            if (++received === PUSH_COUNT) {
+                done();
+            }
+        };
+        var start = performance.now();
+        var nativeMs = parseFloat(await query('ipc_call:bench_push:exec:' + PUSH_COUNT));
+        await delivered;
+        return { count: PUSH_COUNT, native_send_ms: nativeMs, delivered_ms: performance.now() - start };
+    }
+
+    async function benchEventBus() {
+        var received = 0;
+        var done;
+        var delivered = new Promise(function(resolve) { done = resolve; });
+        var subscription = await query('subscribe:bench.push', true, function(batch) {
+            received += JSON.parse(batch).length;
+            if (received === PUSH_COUNT) {
+                done();
+            }
+        });
+        var start = performance.now();
+        var nativeMs = parseFloat(await query('ipc_call:bench_push:bus:' + PUSH_COUNT));
+        await delivered;
+        var result = { count: PUSH_COUNT, native_send_ms: nativeMs, delivered_ms: performance.now() - start };
+        window.cefQueryCancel(subscription);
+        return result;
+    }
+
+    async function run() {
+        var results = { userAgent: navigator.userAgent, cefQuery: [], binary: [], push: {} };
+        for (var i = 0; i < SIZES.length; i++) {
+            results.cefQuery.push(await benchQuery(SIZES[i]));
+            log('cefQuery ' + JSON.stringify(results.cefQuery[i]));
+            results.binary.push(await benchBinary(SIZES[i]));
+            log('binary   ' + JSON.stringify(results.binary[i]));
+        }
+        results.push.executeJavaScript = await benchExecuteJavaScript();
+        results.push.eventBus = await benchEventBus();
+        log('push     ' + JSON.stringify(results.push));
+        return results;
+    }
+
+    window.addEventListener('load', function() {
+        run().catch(function(error) {
+            return { error: String(error) };
+        }).then(function(results) {
+            return query('ipc_call:bench_report:' + JSON.stringify(results, null, 2));
+        });
+    });
+})();
+</script>
+</body>
+</html>
+)HTML";
+
+    static bool g_enabled = false;
+    static std::string g_outputPath;
+    static ResourceUtil::PreloadedResource g_page;
+
+    static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // ipc_call:bench_echo:<payload> answers with the payload unchanged
+    static bool HandleBenchEcho(const SimpleIPC::CommandRequest& request, std::string& result) {
+        result.assign(request.argument.data(), request.argument.size());
+        return true;
+    }
+
+    // ipc_call:bench_push:<exec|bus>:<count> pushes |count| events to the page and
+    // answers with the milliseconds spent on the native side
+    static bool HandleBenchPush(const SimpleIPC::CommandRequest& request, std::string& result) {
+        std::string_view argument = request.argument;
+        size_t colon_pos = argument.find(':');
+        std::string_view mode = argument.substr(0, colon_pos);
+        int count = 0;
+        if (colon_pos != std::string_view::npos) {
+            std::from_chars(argument.data() + colon_pos + 1, argument.data() + argument.size(), count);
+        }
+        if (count <= 0 || (mode != "exec" && mode != "bus")) {
+            result = "Expected <exec|bus>:<count>";
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (mode == "exec") {
+            CefRefPtr<CefFrame> frame = request.frame;
+            CefString url = frame->GetURL();
+            for (int i = 0; i < count; ++i) {
+                frame->ExecuteJavaScript("window.__benchPush(" + std::to_string(i) + ");", url, 0);
+            }
+        } else {
+            SimpleIPC::EventBus& bus = SimpleIPC::EventBus::GetInstance();
+            for (int i = 0; i < count; ++i) {
+                bus.Publish("bench.push", std::to_string(i));
+            }
+        }
+        result = std::to_string(MillisecondsSince(start));
+        return true;
+    }
+
+    // ipc_call:bench_report:<json> stores the results and closes the app
+    static bool HandleBenchReport(const SimpleIPC::CommandRequest& request, std::string& result) {
+        {
+            std::ofstream file(g_outputPath, std::ios::binary | std::ios::trunc);
+            file.write(request.argument.data(), static_cast<std::streamsize>(request.argument.size()));
+            if (!file) {
+                Logger::LogError("IPCBenchmark: Failed to write " + g_outputPath);
+            } else {
+                Logger::LogMessage("IPCBenchmark: Results written to " + g_outputPath);
+            }
+        }
+
+        if (g_cef_window) {
+            g_cef_window->Close();
+        }
+        return true;
+    }
+
+    void Initialize(const std::string& output_path) {
+        g_enabled = true;
+        g_outputPath = output_path;
+
+        g_page.path = kPagePath;
+        g_page.data = ResourceUtil::ResourceSpan(reinterpret_cast<const uint8_t*>(kPageHtml), sizeof(kPageHtml) - 1);
+        g_page.originalSize = sizeof(kPageHtml) - 1;
+        g_page.encoding = ResourceUtil::ENCODING_IDENTITY;
+        g_page.mimeType = "text/html";
+        g_page.etag = "\"ipc-benchmark\"";
+        g_page.loaded = true;
+
+        SimpleIPC::CommandRegistry& registry = SimpleIPC::CommandRegistry::GetInstance();
+        registry.Register("bench_echo", HandleBenchEcho);
+        registry.Register("bench_push", HandleBenchPush);
+        registry.Register("bench_report", HandleBenchReport);
+
+        Logger::LogMessage("IPCBenchmark: Enabled, results go to " + g_outputPath);
+    }
+
+    bool IsEnabled() {
+        return g_enabled;
+    }
+
+    std::string GetPageUrl() {
+        return "miko://app" + std::string(kPagePath);
+    }
+
+    const ResourceUtil::PreloadedResource* GetPage(const std::string& path) {
+        return g_enabled && path == kPagePath ? &g_page : nullptr;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include "resourceutil.hpp"
+
+// IPC latency/throughput benchmark (--ipc-benchmark=<results.json>).
+//
+// Loads a self-contained test page from miko://app instead of the web app and
+// keeps the window hidden. The page measures cefQuery and binary-channel round
+// trips for payloads from 16 B to 16 MB (latency percentiles and throughput)
+// and the cost of native-to-page pushes via ExecuteJavaScript and the event
+// bus, then reports back; the results are written as JSON and the app exits.
+namespace IPCBenchmark {
+    // Enable benchmark mode and register the bench_* commands. Call before the
+    // browser is created.
+    void Initialize(const std::string& output_path);
+
+    bool IsEnabled();
+
+    // URL the browser should load in benchmark mode
+    std::string GetPageUrl();
+
+    // IO thread: the test page for |path|, nullptr for any other path
+    const ResourceUtil::PreloadedResource* GetPage(const std::string& path);
+}
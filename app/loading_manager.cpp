@@ -1,12 +1,70 @@
 #include "loading_manager.hpp"
+#include "client.hpp"
+#include "config.hpp"
 #include "logger.hpp"
+#include "settings.hpp"
+#include "startup_trace.hpp"
+#include "internal/commandregistry.hpp"
+#include "include/cef_task.h"
+#include "include/views/cef_label_button.h"
+#include "include/views/cef_panel.h"
 #include <sstream>
 
+// Shows the splash if the page is still not ready when the delay expires
+class ShowSplashTask : public CefTask {
+public:
+    void Execute() override { LoadingManager::GetInstance().ShowSplash(); }
+
+private:
+    IMPLEMENT_REFCOUNTING(ShowSplashTask);
+};
+
+// The splash title is a label button; it never reacts to clicks
+class SplashLabelDelegate : public CefButtonDelegate {
+public:
+    void OnButtonPressed(CefRefPtr<CefButton> button) override {}
+
+private:
+    IMPLEMENT_REFCOUNTING(SplashLabelDelegate);
+};
+
+// Global variables
+extern CefRefPtr<SimpleClient> g_client;
+
+// Readiness queries sent by the page (see SimpleIPC::InitializeIPC)
+namespace {
+    // Pooled spares and spawned windows run the same page and send the same
+    // queries; only the main window's main frame counts
+    bool IsMainWindowFrame(const SimpleIPC::CommandRequest& request) {
+        if (!request.browser || !request.frame || !request.frame->IsMain() || !g_client) {
+            return false;
+        }
+        CefRefPtr<CefBrowser> main_browser = g_client->GetFirstBrowser();
+        return main_browser && main_browser->IsSame(request.browser);
+    }
+
+    bool HandleAppReady(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (IsMainWindowFrame(request)) {
+            LoadingManager::GetInstance().OnAppReady();
+        }
+        return true;
+    }
+
+    bool HandleFirstPaint(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (IsMainWindowFrame(request)) {
+            LoadingManager::GetInstance().OnFirstPaint();
+        }
+        return true;
+    }
+}
+
 LoadingManager::LoadingManager() 
     : current_state_(INITIALIZING)
     , progress_(0.0f)
     , content_loaded_(false)
-    , window_shown_(false) {
+    , window_shown_(false)
+    , ready_signal_(READY_ON_FIRST_PAINT)
+    , splash_delay_ms_(-1) {
 }
 
 LoadingManager::~LoadingManager() {
@@ -53,7 +111,9 @@ void LoadingManager::SetState(LoadingState state, const std::string& message) {
     if (!message.empty()) {
         log_message += " - " + message;
     }
+    log_message += " (+" + std::to_string(static_cast<long long>(StartupTrace::GetElapsedMs())) + " ms)";
     Logger::LogMessage(log_message);
+    StartupTrace::Mark("State: " + state_name);
     
     // Auto-show window when ready
     if (state == READY && content_loaded_.load() && !window_shown_.load()) {
@@ -72,9 +132,23 @@ std::string LoadingManager::GetStateMessage() const {
 void LoadingManager::SetWindow(CefRefPtr<CefWindow> window) {
     window_ = window;
     Logger::LogMessage("LoadingManager: Window reference set");
+    
+    if (window_ && splash_delay_ms_ >= 0) {
+        CefPostDelayedTask(TID_UI, new ShowSplashTask(), splash_delay_ms_);
+    }
 }
 
 void LoadingManager::ShowWindowWhenReady() {
+    if (splash_ && GetState() == READY) {
+        // The window is already visible; uncover the page
+        splash_->Destroy();
+        splash_ = nullptr;
+        StartupTrace::Mark("SplashHidden");
+        StartupTrace::ScheduleFinish(3000);
+        Logger::LogMessage("LoadingManager: Splash removed - content ready");
+        return;
+    }
+    
     if (window_ && !window_shown_.load() && GetState() == READY) {
         Logger::LogMessage("LoadingManager: Showing window - all loading complete");
         
@@ -82,6 +156,10 @@ void LoadingManager::ShowWindowWhenReady() {
         window_->CenterWindow(CefSize(1200, 800));
         window_->Show();
         window_shown_.store(true);
+        StartupTrace::Mark("WindowShow");
+        
+        // Leave time for the first frames before the trace is written
+        StartupTrace::ScheduleFinish(3000);
         
         Logger::LogMessage("LoadingManager: Window is now visible");
     }
@@ -91,10 +169,83 @@ void LoadingManager::OnContentLoaded() {
     content_loaded_.store(true);
     Logger::LogMessage("LoadingManager: Content loaded");
     
-    // If we're already in READY state, show the window
-    if (GetState() == READY && !window_shown_.load()) {
-        ShowWindowWhenReady();
+    // Fallback for pages that never paint contentful content
+    if (ready_signal_ == READY_ON_FIRST_PAINT) {
+        MarkReady("Page loaded");
+    }
+}
+
+void LoadingManager::SetReadySignal(ReadySignal signal) {
+    ready_signal_ = signal;
+}
+
+void LoadingManager::OnFirstPaint() {
+    StartupTrace::Mark("FirstContentfulPaint");
+    Logger::LogMessage("LoadingManager: First contentful paint");
+    
+    if (ready_signal_ == READY_ON_FIRST_PAINT) {
+        MarkReady("First contentful paint");
+    }
+}
+
+void LoadingManager::OnAppReady() {
+    StartupTrace::Mark("AppReady");
+    Logger::LogMessage("LoadingManager: App reported ready");
+    MarkReady("App ready");
+}
+
+void LoadingManager::MarkReady(const std::string& reason) {
+    if (GetState() == READY) {
+        return;
+    }
+    SetState(READY, reason);
+    ShowWindowWhenReady();
+}
+
+void LoadingManager::SetSplashDelay(int delay_ms) {
+    splash_delay_ms_ = delay_ms;
+}
+
+// Hidden windows do not composite, so a page that takes long to become ready
+// is shown behind a native panel in the page's background colour instead.
+// The browser view keeps rendering underneath and the panel goes away on the
+// next readiness signal.
+void LoadingManager::ShowSplash() {
+    if (!window_ || window_shown_.load() || GetState() == READY || GetState() == ERROR_STATE) {
+        return;
     }
+    
+    CefRefPtr<CefPanel> panel = CefPanel::CreatePanel(nullptr);
+    panel->SetBackgroundColor(APP_BACKGROUND_COLOR);
+    CefBoxLayoutSettings layout;
+    layout.main_axis_alignment = CEF_AXIS_ALIGNMENT_CENTER;
+    layout.cross_axis_alignment = CEF_AXIS_ALIGNMENT_CENTER;
+    panel->SetToBoxLayout(layout);
+    
+    CefRefPtr<CefLabelButton> title = CefLabelButton::CreateLabelButton(new SplashLabelDelegate(), window_->GetTitle());
+    title->SetEnabledTextColors(APP_SPLASH_TEXT_COLOR);
+    title->SetBackgroundColor(APP_BACKGROUND_COLOR);
+    title->SetFontList("Arial, 20px");
+    title->SetFocusable(false);
+    panel->AddChildView(title);
+    
+    const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+    window_->CenterWindow(CefSize(config.window_width, config.window_height));
+    splash_ = window_->AddOverlayView(panel, CEF_DOCKING_MODE_CUSTOM, false);
+    CefRect bounds = window_->GetBounds();
+    splash_->SetBounds(CefRect(0, 0, bounds.width, bounds.height));
+    splash_->SetVisible(true);
+    
+    window_->Show();
+    window_shown_.store(true);
+    StartupTrace::Mark("SplashShow");
+    Logger::LogMessage("LoadingManager: Content not ready after " + std::to_string(splash_delay_ms_) + " ms, showing splash");
+}
+
+void LoadingManager::RegisterCommands() {
+    SimpleIPC::CommandRegistry& registry = SimpleIPC::CommandRegistry::GetInstance();
+    registry.Register("app_ready", HandleAppReady);
+    registry.Register("first_paint", HandleFirstPaint);
 }
 
 void LoadingManager::SetProgress(float progress) {
@@ -119,7 +270,7 @@ float LoadingManager::GetProgress() const {
 void LoadingManager::SetError(const std::string& error) {
     error_message_ = error;
     SetState(ERROR_STATE, error);
-    Logger::LogMessage("LoadingManager ERROR: " + error);
+    Logger::LogError("LoadingManager ERROR: " + error);
 }
 
 bool LoadingManager::HasError() const {
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <string>
 #include "include/views/cef_window.h"
+#include "include/views/cef_overlay_controller.h"
 
 // Loading state manager for Electron-like behavior
 class LoadingManager {
@@ -16,6 +17,12 @@ public:
         ERROR_STATE = 5
     };
 
+    // What counts as "ready" for showing the window
+    enum ReadySignal {
+        READY_ON_FIRST_PAINT = 0,   // First contentful paint, app-ready or load, whichever comes first
+        READY_ON_APP_READY = 1      // Only an explicit app_ready query from the page
+    };
+
     // Singleton access
     static LoadingManager& GetInstance();
     
@@ -29,6 +36,19 @@ public:
     void ShowWindowWhenReady();
     void OnContentLoaded();
     
+    // Readiness signals (UI thread). The window is shown on the first signal
+    // that the configured ReadySignal accepts.
+    void SetReadySignal(ReadySignal signal);
+    void OnFirstPaint();
+    void OnAppReady();
+    
+    // Show a native splash in the window if the page is not ready |delay_ms|
+    // after SetWindow(); negative disables it
+    void SetSplashDelay(int delay_ms);
+    
+    // Register the app_ready and first_paint queries with the CommandRegistry
+    static void RegisterCommands();
+    
     // Progress tracking
     void SetProgress(float progress); // 0.0 to 1.0
     float GetProgress() const;
@@ -44,6 +64,11 @@ private:
     LoadingManager(const LoadingManager&);
     LoadingManager& operator=(const LoadingManager&);
     
+    void MarkReady(const std::string& reason);
+    void ShowSplash();
+    
+    friend class ShowSplashTask;
+    
     std::atomic<int> current_state_;
     std::atomic<float> progress_;
     std::string state_message_;
@@ -51,4 +76,7 @@ private:
     CefRefPtr<CefWindow> window_;
     std::atomic<bool> content_loaded_;
     std::atomic<bool> window_shown_;
+    ReadySignal ready_signal_;
+    int splash_delay_ms_;
+    CefRefPtr<CefOverlayController> splash_;
 };
\ No newline at end of file
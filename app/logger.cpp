@@ -1,12 +1,337 @@
 #include "logger.hpp"
-#include <fstream>
-#include <iostream>
+#include "config.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace {
+    const char* kLogFileName = "swipeide.log";
+    const size_t kMaxLogFileSize = 5 * 1024 * 1024;  // Rotate after 5 MB
+    const int kMaxRotatedFiles = 3;                  // swipeide.log.1 .. .3
+
+    // Ring buffer capacity (power of two)
+    const size_t kQueueCapacity = 1024;
+
+    struct LogEntry {
+        std::chrono::system_clock::time_point time;
+        Logger::Level level;
+        std::string message;
+    };
+
+    // Bounded lock-free multi-producer / single-consumer queue. Every slot
+    // carries a sequence number, so producers claim slots with a single CAS and
+    // the consumer never has to take a lock.
+    class LogQueue {
+    public:
+        LogQueue() : enqueue_pos_(0), dequeue_pos_(0) {
+            for (size_t i = 0; i < kQueueCapacity; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Any thread; false when the queue is full
+        bool TryPush(LogEntry& entry) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            Slot* slot;
+            for (;;) {
+                slot = &slots_[pos & (kQueueCapacity - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            slot->entry = std::move(entry);
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Writer thread only
+        bool TryPop(LogEntry& entry) {
+            Slot& slot = slots_[dequeue_pos_ & (kQueueCapacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != dequeue_pos_ + 1) {
+                return false;
+            }
+            entry = std::move(slot.entry);
+            slot.sequence.store(dequeue_pos_ + kQueueCapacity, std::memory_order_release);
+            ++dequeue_pos_;
+            return true;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            LogEntry entry;
+        };
+
+        Slot slots_[kQueueCapacity];
+        std::atomic<size_t> enqueue_pos_;
+        size_t dequeue_pos_;
+    };
+
+    class LogWriter {
+    public:
+        // Intentionally leaked so logging during static destruction stays safe
+        static LogWriter& GetInstance() {
+            static LogWriter* instance = new LogWriter();
+            return *instance;
+        }
+
+        void Enqueue(Logger::Level level, const std::string& message) {
+            LogEntry entry;
+            entry.time = std::chrono::system_clock::now();
+            entry.level = level;
+            entry.message = message;
+            if (!queue_.TryPush(entry)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // Sequentially consistent with the writer's idle_ store and its
+            // pending check, so either it sees this entry or we see it idle
+            enqueued_.fetch_add(1);
+
+            // Only pay for a notification when the writer is actually asleep.
+            // Under the mutex: the writer holds it from going idle until it waits.
+            if (idle_.load()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                wake_cv_.notify_one();
+            }
+        }
+
+        void Start() {
+            std::lock_guard<std::mutex> lock(start_mutex_);
+            if (running_.load()) {
+                return;
+            }
+            static bool exit_hook_registered = false;
+            if (!exit_hook_registered) {
+                // Drain whatever is still buffered when the process exits normally
+                std::atexit(Logger::Shutdown);
+                exit_hook_registered = true;
+            }
+            running_.store(true, std::memory_order_release);
+            thread_ = std::thread(&LogWriter::Run, this);
+        }
+
+        void Flush() {
+            if (!running_.load(std::memory_order_acquire)) {
+                return;
+            }
+            uint64_t target = enqueued_.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock(mutex_);
+            flushed_cv_.wait(lock, [&]() {
+                return written_.load(std::memory_order_acquire) >= target ||
+                       !running_.load(std::memory_order_acquire);
+            });
+        }
+
+        void Shutdown() {
+            std::lock_guard<std::mutex> start_lock(start_mutex_);
+            if (!running_.exchange(false)) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                wake_cv_.notify_one();
+            }
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+    private:
+        LogWriter()
+            : running_(false), idle_(false), enqueued_(0), written_(0), dropped_(0),
+              file_(nullptr), file_size_(0) {
+        }
+
+        bool HasPending() {
+            return enqueued_.load() != written_.load();
+        }
+
+        void Run() {
+            for (;;) {
+                bool stopping = !running_.load(std::memory_order_acquire);
+                size_t count = DrainBatch();
+                if (count > 0) {
+                    continue;
+                }
+                if (stopping) {
+                    break;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                flushed_cv_.notify_all();
+                idle_.store(true);
+                wake_cv_.wait(lock, [this]() {
+                    return HasPending() || !running_.load(std::memory_order_acquire);
+                });
+                idle_.store(false, std::memory_order_release);
+            }
+
+            CloseFile();
+            std::lock_guard<std::mutex> lock(mutex_);
+            flushed_cv_.notify_all();
+        }
+
+        size_t DrainBatch() {
+            size_t count = 0;
+            LogEntry entry;
+            while (queue_.TryPop(entry)) {
+                Write(entry.time, entry.level, entry.message);
+                ++count;
+            }
+
+            uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                Write(std::chrono::system_clock::now(), Logger::LEVEL_ERROR,
+                      "Logger: dropped " + std::to_string(dropped) + " messages (buffer full)");
+            }
+
+            if (count > 0 && file_) {
+                fflush(file_);
+            }
+            written_.fetch_add(count);
+            return count;
+        }
+
+        void Write(std::chrono::system_clock::time_point time, Logger::Level level,
+                   const std::string& message) {
+            time_t seconds = std::chrono::system_clock::to_time_t(time);
+            int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                time.time_since_epoch()).count() % 1000);
+            tm local = {};
+#ifdef _WIN32
+            localtime_s(&local, &seconds);
+#else
+            localtime_r(&seconds, &local);
+#endif
+            static const char* kLevelNames[] = { "VERBOSE", "INFO", "ERROR" };
+            char prefix[48];
+            int prefix_length = snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%03d] [%s] ",
+                                         local.tm_hour, local.tm_min, local.tm_sec, millis,
+                                         kLevelNames[level]);
+
+            size_t line_length = static_cast<size_t>(prefix_length) + message.size() + 1;
+            if (!file_ || file_size_ + line_length > kMaxLogFileSize) {
+                Rotate();
+            }
+            if (!file_) {
+                return;
+            }
+
+            fwrite(prefix, 1, static_cast<size_t>(prefix_length), file_);
+            fwrite(message.data(), 1, message.size(), file_);
+            fputc('\n', file_);
+            file_size_ += line_length;
+        }
+
+        void Rotate() {
+            if (file_ && file_size_ > 0) {
+                CloseFile();
+                std::string base(kLogFileName);
+                std::remove((base + "." + std::to_string(kMaxRotatedFiles)).c_str());
+                for (int i = kMaxRotatedFiles - 1; i >= 1; --i) {
+                    std::rename((base + "." + std::to_string(i)).c_str(),
+                                (base + "." + std::to_string(i + 1)).c_str());
+                }
+                std::rename(kLogFileName, (base + ".1").c_str());
+            }
+            if (!file_) {
+                OpenFile();
+            }
+        }
+
+        void OpenFile() {
+            file_ = fopen(kLogFileName, "ab");
+            if (!file_) {
+                return;
+            }
+            fseek(file_, 0, SEEK_END);
+            long size = ftell(file_);
+            file_size_ = size > 0 ? static_cast<size_t>(size) : 0;
+        }
+
+        void CloseFile() {
+            if (file_) {
+                fclose(file_);
+                file_ = nullptr;
+            }
+            file_size_ = 0;
+        }
+
+        LogQueue queue_;
+        std::thread thread_;
+        std::mutex start_mutex_;
+        std::mutex mutex_;                      // Pairs with the condition variables only
+        std::condition_variable wake_cv_;
+        std::condition_variable flushed_cv_;
+        std::atomic<bool> running_;
+        std::atomic<bool> idle_;
+        std::atomic<uint64_t> enqueued_;
+        std::atomic<uint64_t> written_;
+        std::atomic<uint64_t> dropped_;
+
+        // Writer thread only
+        FILE* file_;
+        size_t file_size_;
+    };
+
+    std::atomic<int> g_level(LOG_LEVEL);
+}
 
 void Logger::LogMessage(const std::string& message) {
-    // Write to a log file instead of console
-    std::ofstream logFile("swipeide.log", std::ios::app);
-    if (logFile.is_open()) {
-        logFile << message << std::endl;
-        logFile.close();
+    Log(LEVEL_INFO, message);
+}
+
+void Logger::LogVerbose(const std::string& message) {
+    Log(LEVEL_VERBOSE, message);
+}
+
+void Logger::LogError(const std::string& message) {
+    Log(LEVEL_ERROR, message);
+}
+
+void Logger::Log(Level level, const std::string& message) {
+    if (!IsEnabled(level)) {
+        return;
     }
-}
\ No newline at end of file
+    LogWriter::GetInstance().Enqueue(level, message);
+}
+
+void Logger::SetLevel(Level level) {
+    g_level.store(level, std::memory_order_relaxed);
+}
+
+bool Logger::IsEnabled(Level level) {
+    return level >= g_level.load(std::memory_order_relaxed);
+}
+
+const char* Logger::GetFileName() {
+    return kLogFileName;
+}
+
+void Logger::Start() {
+    LogWriter::GetInstance().Start();
+}
+
+void Logger::Flush() {
+    LogWriter::GetInstance().Flush();
+}
+
+void Logger::Shutdown() {
+    LogWriter::GetInstance().Shutdown();
+}
@@ -1,7 +1,43 @@
 #pragma once
 #include <string>
 
+// Asynchronous file logger.
+//
+// Callers only move the message into a lock-free ring buffer; a background
+// writer thread keeps swipeide.log open, writes in batches and rotates the file
+// by size. When the buffer is full, messages are dropped (and counted) rather
+// than blocking the UI or IO thread.
+//
+// Only the browser process writes the file: the writer starts in Start(),
+// after CefExecuteProcess() has returned, so no sub-process (least of all the
+// zygote, whose forks would inherit a writer they do not have) owns a thread
+// or rotates the log. Messages logged before that wait in the buffer.
 class Logger {
 public:
-    static void LogMessage(const std::string& message);
-};
\ No newline at end of file
+    enum Level {
+        LEVEL_VERBOSE = 0,
+        LEVEL_INFO = 1,
+        LEVEL_ERROR = 2
+    };
+
+    static void LogMessage(const std::string& message);  // LEVEL_INFO
+    static void LogVerbose(const std::string& message);
+    static void LogError(const std::string& message);
+    static void Log(Level level, const std::string& message);
+
+    // Minimum level that is written; defaults to LOG_LEVEL from config.hpp
+    static void SetLevel(Level level);
+    static bool IsEnabled(Level level);
+
+    // The log file, relative to the working directory; rotated copies add .1 to .3
+    static const char* GetFileName();
+
+    // Browser process only: start the writer thread
+    static void Start();
+
+    // Block until everything logged so far is on disk; no-op before Start()
+    static void Flush();
+
+    // Drain the buffer and stop the writer thread
+    static void Shutdown();
+};
@@ -35,20 +35,37 @@
 #include "include/views/cef_browser_view.h"
 #include "include/views/cef_browser_view_delegate.h"
 #include "include/cef_image.h"
-#include <filesystem>
+#include "include/cef_command_line.h"
+#include "include/cef_task.h"
 #include <fstream>
 #include <chrono>
+#include <filesystem>
 
 // Local includes
 #include "config.hpp"
 #include "logger.hpp"
 #include "client.hpp"
 #include "app.hpp"
+#include "background_policy.hpp"
 #include "binaryresourceprovider.hpp"
+#include "browser_pool.hpp"
+#include "file_service.hpp"
+#include "file_watcher.hpp"
 #include "resourceutil.hpp"
+#include "settings.hpp"
+#include "startup_cache.hpp"
+#include "startup_trace.hpp"
+#include "trigram_index.hpp"
+#include "ipc_benchmark.hpp"
 #include "loading_manager.hpp"
+#include "memory_monitor.hpp"
+#include "message_pump.hpp"
+#include "worker_pool.hpp"
+#include "workspace_index.hpp"
+#include "workspace_search.hpp"
 #include "native_window_controls.hpp"
 #include "window_mode_manager.hpp"
+#include "internal/simpleipc.hpp"
 
 // Global variables
 CefRefPtr<SimpleClient> g_client;
@@ -70,14 +87,14 @@ HICON LoadApplicationIcon() {
     
     HINSTANCE hInstance = GetModuleHandle(NULL);
     if (!hInstance) {
-        Logger::LogMessage("Failed to get module handle for icon loading");
+        Logger::LogError("Failed to get module handle for icon loading");
         return NULL;
     }
     
     // Try to load icon from resource (ID 101 as defined in app.rc)
     g_app_icon = LoadIcon(hInstance, MAKEINTRESOURCE(101));
     if (!g_app_icon) {
-        Logger::LogMessage("Failed to load application icon from resource ID 101");
+        Logger::LogError("Failed to load application icon from resource ID 101");
         // Fallback to system default application icon
         g_app_icon = LoadIcon(NULL, IDI_APPLICATION);
     }
@@ -85,7 +102,7 @@ HICON LoadApplicationIcon() {
     if (g_app_icon) {
         Logger::LogMessage("Application icon loaded successfully");
     } else {
-        Logger::LogMessage("Failed to load any application icon");
+        Logger::LogError("Failed to load any application icon");
     }
     
     return g_app_icon;
@@ -96,13 +113,13 @@ HICON LoadApplicationIcon() {
 // Set taskbar icon with proper window class registration (Windows only)
 void SetPermanentTaskbarIcon(HWND hwnd) {
     if (!hwnd) {
-        Logger::LogMessage("Invalid window handle for taskbar icon");
+        Logger::LogError("Invalid window handle for taskbar icon");
         return;
     }
 
     HICON hIcon = LoadApplicationIcon();
     if (!hIcon) {
-        Logger::LogMessage("No icon available for taskbar");
+        Logger::LogError("No icon available for taskbar");
         return;
     }
     
@@ -138,7 +155,7 @@ void SetApplicationUserModelID(HWND hwnd) {
             if (SUCCEEDED(hr)) {
                 Logger::LogMessage("Application User Model ID set successfully");
             } else {
-                Logger::LogMessage("Failed to set Application User Model ID");
+                Logger::LogError("Failed to set Application User Model ID");
             }
         }
         FreeLibrary(hShell32);
@@ -156,14 +173,14 @@ CefRefPtr<CefImage> ConvertIconToCefImage(HICON hIcon) {
     // Get icon info to extract bitmap data
     ICONINFO iconInfo;
     if (!GetIconInfo(hIcon, &iconInfo)) {
-        Logger::LogMessage("Failed to get icon info for CEF conversion");
+        Logger::LogError("Failed to get icon info for CEF conversion");
         return nullptr;
     }
     
     // Get bitmap info for the color bitmap
     BITMAP bmp;
     if (!GetObject(iconInfo.hbmColor, sizeof(BITMAP), &bmp)) {
-        Logger::LogMessage("Failed to get bitmap object for CEF conversion");
+        Logger::LogError("Failed to get bitmap object for CEF conversion");
         DeleteObject(iconInfo.hbmColor);
         DeleteObject(iconInfo.hbmMask);
         return nullptr;
@@ -185,7 +202,7 @@ CefRefPtr<CefImage> ConvertIconToCefImage(HICON hIcon) {
     
     if (!GetDIBits(hdcMem, iconInfo.hbmColor, 0, bmp.bmHeight, bitmapData.data(), 
                    (BITMAPINFO*)&bi, DIB_RGB_COLORS)) {
-        Logger::LogMessage("Failed to get DIB bits for CEF conversion");
+        Logger::LogError("Failed to get DIB bits for CEF conversion");
         DeleteDC(hdcMem);
         ReleaseDC(NULL, hdc);
         DeleteObject(iconInfo.hbmColor);
@@ -197,7 +214,7 @@ CefRefPtr<CefImage> ConvertIconToCefImage(HICON hIcon) {
     CefRefPtr<CefImage> image = CefImage::CreateImage();
     if (!image->AddBitmap(1.0f, bmp.bmWidth, bmp.bmHeight, CEF_COLOR_TYPE_BGRA_8888, 
                          CEF_ALPHA_TYPE_PREMULTIPLIED, bitmapData.data(), bmp.bmWidth * 4)) {
-        Logger::LogMessage("Failed to create CefImage from bitmap data");
+        Logger::LogError("Failed to create CefImage from bitmap data");
         DeleteDC(hdcMem);
         ReleaseDC(NULL, hdc);
         DeleteObject(iconInfo.hbmColor);
@@ -255,7 +272,7 @@ public:
         // Get window handle
         HWND hwnd = window->GetWindowHandle();
         if (!hwnd) {
-            Logger::LogMessage("Failed to get window handle in OnWindowCreated");
+            Logger::LogError("Failed to get window handle in OnWindowCreated");
             return;
         }
         
@@ -276,21 +293,18 @@ public:
             // Set native Windows taskbar icon
             SetPermanentTaskbarIcon(hwnd);
         } else {
-            Logger::LogMessage("Failed to load application icon in OnWindowCreated");
+            Logger::LogError("Failed to load application icon in OnWindowCreated");
         }
 #else
         // Linux/Unix - basic window setup
         Logger::LogMessage("Window created on Linux platform");
 #endif
         
-        // Initialize window mode manager and force borderless mode
+        // Initialize window mode manager with the configured mode (IsFrameless
+        // already gave the window its frame)
         WindowModeManager::Initialize();
         WindowModeManager::RestoreWindowState(window);
         
-        // Force borderless mode
-        WindowModeManager::SetBorderlessMode(window);
-        Logger::LogMessage("Forced borderless mode on window creation");
-        
         // Temporarily disable native controls position setup
         // NativeWindowControls::SetControlsPosition(window, 0, 0, 0, 32);
         
@@ -299,8 +313,7 @@ public:
     
     // Use frameless window for borderless mode
     bool IsFrameless(CefRefPtr<CefWindow> window) override {
-        // Force borderless/frameless mode on all platforms
-        return true;
+        return AppConfig::IsBorderlessMode();
     }
     
     // Allow window to be resizable
@@ -308,9 +321,15 @@ public:
         return true;
     }
     
+    // Restoring a minimised window activates it; unfreeze it right away
+    void OnWindowActivationChanged(CefRefPtr<CefWindow> window, bool active) override {
+        BackgroundPolicy::GetInstance().OnWindowStateChanged();
+    }
+    
     // Set initial window size
     CefSize GetPreferredSize(CefRefPtr<CefView> view) override {
-        return CefSize(1200, 800);
+        const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+        return CefSize(config.window_width, config.window_height);
     }
     
     // Handle window close
@@ -327,6 +346,39 @@ private:
     IMPLEMENT_REFCOUNTING(CustomWindowDelegate);
 };
 
+// Show the window even if the page never signalled that it is ready
+static const int kLoadingTimeoutMs = 30000;
+
+void ShowWindowAfterTimeout() {
+    LoadingManager& loadingManager = LoadingManager::GetInstance();
+    if (!loadingManager.HasError() && loadingManager.GetState() != LoadingManager::READY) {
+        Logger::LogError("⚠ Loading timeout - showing window anyway");
+        loadingManager.SetState(LoadingManager::READY, "Timeout - forcing show");
+        loadingManager.ShowWindowWhenReady();
+    }
+}
+
+// Loading timeout when CEF runs its own message loop
+class LoadingTimeoutTask : public CefTask {
+public:
+    void Execute() override { ShowWindowAfterTimeout(); }
+
+private:
+    IMPLEMENT_REFCOUNTING(LoadingTimeoutTask);
+};
+
+// Longest wait for the other windows to close once the main one has
+static const int kShutdownTimeoutMs = 5000;
+
+// Stops CefRunMessageLoop() when closing the remaining windows hangs
+class QuitMessageLoopTask : public CefTask {
+public:
+    void Execute() override { CefQuitMessageLoop(); }
+
+private:
+    IMPLEMENT_REFCOUNTING(QuitMessageLoopTask);
+};
+
 // Handle events
 void HandleEvents() {
     // CEF handles all events through its message loop
@@ -336,9 +388,6 @@ void HandleEvents() {
 // Cross-platform main function
 #ifdef _WIN32
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-    // Pre-load application icon to ensure it's available
-    LoadApplicationIcon();
-    
     // Set Application User Model ID early in the process
     SetApplicationUserModelID(NULL);
     
@@ -350,6 +399,11 @@ int main(int argc, char* argv[]) {
     CefMainArgs main_args(argc, argv);
 #endif
 
+#ifdef _WIN32
+    StartupTrace::Initialize(__argc, __argv);
+#else
+    StartupTrace::Initialize(argc, argv);
+#endif
     Logger::LogMessage("Starting CEF application initialization");
     
     // Initialize loading manager
@@ -362,13 +416,53 @@ int main(int argc, char* argv[]) {
     
     // CEF sub-process check
     Logger::LogMessage("Checking for CEF sub-process");
-    int exit_code = CefExecuteProcess(main_args, app.get(), sandbox_info);
+    int exit_code;
+    {
+        StartupTrace::ScopedPhase phase("CefExecuteProcess");
+        exit_code = CefExecuteProcess(main_args, app.get(), sandbox_info);
+    }
     if (exit_code >= 0) {
-        Logger::LogMessage("CEF sub-process detected, exiting");
         return exit_code;
     }
+    Logger::Start();
     Logger::LogMessage("Main process continuing");
 
+    // Parsed here rather than through the global command line, which only
+    // exists after CefInitialize()
+    CefRefPtr<CefCommandLine> command_line = CefCommandLine::CreateCommandLine();
+#ifdef _WIN32
+    command_line->InitFromString(::GetCommandLineW());
+#else
+    command_line->InitFromArgv(argc, argv);
+#endif
+    
+    // Runtime settings (--settings=<file>, swipeide.conf by default); any
+    // setting can also be given as a switch, which takes precedence
+    std::string settings_path = Settings::kDefaultPath;
+    if (command_line->HasSwitch("settings")) {
+        settings_path = command_line->GetSwitchValue("settings").ToString();
+    }
+    {
+        StartupTrace::ScopedPhase phase("LoadSettings");
+        Settings::GetInstance().Load(settings_path, command_line);
+    }
+    const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+    Logger::SetLevel(static_cast<Logger::Level>(config.log_level));
+    WorkerPool::GetInstance().Configure(config.worker_threads);
+    // The cache and the log change all the time and must not feed the watcher
+    FileWatcher::GetInstance().Configure(config.watch_limit, config.watch_debounce_ms,
+        { config.cache_path, (std::filesystem::current_path() / Logger::GetFileName()).u8string() });
+    FileWatcher::GetInstance().Start();
+    TrigramIndex::GetInstance().Configure(config.search_index ? config.cache_path : std::string());
+    TrigramIndex::GetInstance().Start();
+    
+    // Optional dev bundle directory for hot-swapping resources (reload_resources query)
+    if (command_line->HasSwitch("dev-bundle-dir")) {
+        std::string dev_bundle_dir = command_line->GetSwitchValue("dev-bundle-dir").ToString();
+        ResourceUtil::SetDevBundleDirectory(dev_bundle_dir);
+        Logger::LogMessage("Dev bundle directory: " + dev_bundle_dir);
+    }
+
     std::string windowTitle = AppConfig::IsDebugMode() ? 
         "SwipeIDE - Development Mode" : "SwipeIDE - Release Mode";
 
@@ -376,26 +470,86 @@ int main(int argc, char* argv[]) {
     CefSettings settings;
     settings.no_sandbox = true;  // Disable sandboxing for development (avoids chrome-sandbox setup)
     settings.multi_threaded_message_loop = false;
+    // External: the main loop sleeps until CEF schedules work
+    settings.external_message_pump = config.message_loop == RuntimeConfig::MESSAGE_LOOP_EXTERNAL;
     settings.windowless_rendering_enabled = false;
-    settings.log_severity = LOGSEVERITY_DISABLE;  // Disable logging to reduce overhead
-    settings.remote_debugging_port = -1;  // Disable remote debugging
+    settings.log_severity = static_cast<cef_log_severity_t>(config.cef_log_severity);  // Disabled by default
+    settings.remote_debugging_port = config.remote_debugging_port;  // Disabled by default
     
     // Set absolute cache paths to avoid singleton warnings
-    std::filesystem::path cache_dir = std::filesystem::current_path() / "cache";
-    std::string cache_path = cache_dir.string();
-    CefString(&settings.cache_path).FromASCII(cache_path.c_str());
-    CefString(&settings.root_cache_path).FromASCII(cache_path.c_str());
+    std::string cache_path = config.cache_path;
+    CefString(&settings.cache_path).FromString(cache_path);
+    CefString(&settings.root_cache_path).FromString(cache_path);
     
     // Use empty subprocess path to let CEF handle it automatically
     CefString(&settings.browser_subprocess_path).FromASCII("");
 
+    // Create the pump before CefInitialize(), which may already schedule work
+    MessagePump& messagePump = MessagePump::GetInstance();
+
+    // Startup work that needs no CEF state runs on the worker pool while
+    // CefInitialize() spins up the GPU and network processes. Everything here
+    // is only read on the UI thread after startupTasks.Wait().
+    loadingManager.SetState(LoadingManager::PRELOADING_RESOURCES, "Loading application resources");
+    Logger::LogMessage("=== PRELOADING RESOURCES IN PARALLEL WITH CEF INITIALIZATION ===");
+    TaskGroup startupTasks;
+    bool use_startup_cache = config.startup_cache;
+    startupTasks.Submit([cache_path, use_startup_cache]() {
+        StartupTrace::ScopedPhase phase("PreloadResources");
+        ResourceUtil::InitializePreloadedResources();
+        // Startup profile for the embedded bundle (lives next to the Chromium cache)
+        if (use_startup_cache) {
+            StartupCache::Initialize(cache_path);
+        }
+    });
+    std::string benchmark_output;
+    if (command_line->HasSwitch("ipc-benchmark")) {
+        benchmark_output = command_line->GetSwitchValue("ipc-benchmark").ToString();
+        if (benchmark_output.empty()) {
+            benchmark_output = "ipc_benchmark.json";
+        }
+    }
+    startupTasks.Submit([benchmark_output]() {
+        StartupTrace::ScopedPhase phase("RegisterCommands");
+        // Everything the page can call through cefQuery, registered before any query arrives
+        SimpleIPC::RegisterDefaultMethods();
+        SimpleClient::RegisterCommands();
+        WindowModeManager::RegisterCommands();
+        LoadingManager::RegisterCommands();
+        MemoryMonitor::RegisterCommands();
+        BackgroundPolicy::RegisterCommands();
+        FileService::RegisterCommands();
+        WorkspaceIndex::RegisterCommands();
+        WorkspaceSearch::RegisterCommands();
+        FileWatcher::RegisterCommands();
+        // IPC benchmark mode: load the built-in test page into a window that is never shown
+        if (!benchmark_output.empty()) {
+            IPCBenchmark::Initialize(benchmark_output);
+        }
+    });
+#ifdef _WIN32
+    startupTasks.Submit([]() {
+        StartupTrace::ScopedPhase phase("LoadApplicationIcon");
+        LoadApplicationIcon();
+    });
+#endif
+
     Logger::LogMessage("Initializing CEF");
-    bool cef_init_result = CefInitialize(main_args, settings, app.get(), sandbox_info);
+    bool cef_init_result;
+    {
+        StartupTrace::ScopedPhase phase("CefInitialize");
+        cef_init_result = CefInitialize(main_args, settings, app.get(), sandbox_info);
+    }
     if (!cef_init_result) {
-        Logger::LogMessage("CEF initialization failed");
+        Logger::LogError("CEF initialization failed");
         return 1;
     }
     Logger::LogMessage("CEF initialized successfully");
+    
+    // Optional startup timeline (--startup-trace[=file], --startup-trace-cef adds CEF's own tracing)
+    if (StartupTrace::IsEnabled()) {
+        StartupTrace::Start(command_line->HasSwitch("startup-trace-cef"));
+    }
 
     // Initialize crash reporting if enabled
     if (CefCrashReportingEnabled()) {
@@ -410,11 +564,11 @@ int main(int argc, char* argv[]) {
 
     // Register scheme handler factory for miko:// protocol
     CefRegisterSchemeHandlerFactory("miko", "", new BinaryResourceProvider());
-
-    // PRELOAD RESOURCES BEFORE RENDERING
-    loadingManager.SetState(LoadingManager::PRELOADING_RESOURCES, "Loading application resources");
-    Logger::LogMessage("=== PRELOADING RESOURCES BEFORE RENDERING ===");
-    ResourceUtil::InitializePreloadedResources();
+    
+    {
+        StartupTrace::ScopedPhase phase("JoinStartupTasks");
+        startupTasks.Wait();
+    }
     
     // Get preload statistics
     ResourceUtil::PreloadStats stats = ResourceUtil::GetPreloadStats();
@@ -424,35 +578,54 @@ int main(int argc, char* argv[]) {
         Logger::LogMessage("  - Total resources: " + std::to_string(stats.totalResources));
         Logger::LogMessage("  - Loaded resources: " + std::to_string(stats.loadedResources));
         Logger::LogMessage("  - Total size: " + std::to_string(stats.totalBytes) + " bytes");
+        Logger::LogMessage("  - Uncompressed size: " + std::to_string(stats.uncompressedBytes) + " bytes");
     } else {
-        Logger::LogMessage("⚠ Warning: Resource preloading incomplete");
+        Logger::LogError("⚠ Warning: Resource preloading incomplete");
         Logger::LogMessage("  - Total resources: " + std::to_string(stats.totalResources));
         Logger::LogMessage("  - Loaded resources: " + std::to_string(stats.loadedResources));
         Logger::LogMessage("  - Total size: " + std::to_string(stats.totalBytes) + " bytes");
         loadingManager.SetError("Resource preloading failed");
         return 1;
     }
+    
     Logger::LogMessage("=== PRELOAD COMPLETE - CREATING WINDOW ===");
 
     // Create CEF views-based borderless window (HIDDEN initially)
     loadingManager.SetState(LoadingManager::CREATING_WINDOW, "Creating application window");
     
+    // Window readiness (wait-for-app-ready, splash-delay)
+    if (config.wait_for_app_ready) {
+        loadingManager.SetReadySignal(LoadingManager::READY_ON_APP_READY);
+    }
+    loadingManager.SetSplashDelay(config.splash_delay_ms);
+    
+    // Spare windows for SpawnNewWindow, memory budget and background freezing;
+    // the benchmark runs without spares or freezing
+    BrowserPool::GetInstance().Configure(IPCBenchmark::IsEnabled() ? 0 : config.browser_pool_size,
+                                         config.browser_pool_memory_cap_mb);
+    MemoryMonitor::GetInstance().Configure(config.window_memory_budget_mb, config.memory_threshold_mb, 15000);
+    BackgroundPolicy::GetInstance().Configure(IPCBenchmark::IsEnabled() ? 0 : config.freeze_hidden_after_s * 1000);
+    
     g_client = new SimpleClient();
-    std::string startupUrl = AppConfig::GetStartupUrl();
+    std::string startupUrl = IPCBenchmark::IsEnabled() ? IPCBenchmark::GetPageUrl() : AppConfig::GetStartupUrl();
     
     // Create browser view with hidden UI elements
     CefBrowserSettings browser_settings;
     
     // Configure browser settings with security restrictions
-     browser_settings.javascript_access_clipboard = STATE_DISABLED;  // Disable clipboard access for security
-     browser_settings.javascript_dom_paste = STATE_DISABLED;  // Disable DOM paste for security
-     browser_settings.local_storage = STATE_ENABLED;
+     browser_settings.javascript_access_clipboard = config.javascript_clipboard ? STATE_ENABLED : STATE_DISABLED;  // Disabled by default for security
+     browser_settings.javascript_dom_paste = config.javascript_clipboard ? STATE_ENABLED : STATE_DISABLED;
+     browser_settings.local_storage = config.local_storage ? STATE_ENABLED : STATE_DISABLED;
      browser_settings.javascript_close_windows = STATE_DISABLED;  // Prevent JavaScript from closing windows
+     browser_settings.background_color = APP_BACKGROUND_COLOR;  // Painted before the page, avoids a white flash
 
     // Create browser view delegate to hide UI elements
     CefRefPtr<CustomBrowserViewDelegate> browser_view_delegate = new CustomBrowserViewDelegate();
     
-    g_browser_view = CefBrowserView::CreateBrowserView(g_client, startupUrl, browser_settings, nullptr, nullptr, browser_view_delegate);
+    {
+        StartupTrace::ScopedPhase phase("CreateBrowserView");
+        g_browser_view = CefBrowserView::CreateBrowserView(g_client, startupUrl, browser_settings, nullptr, nullptr, browser_view_delegate);
+    }
     
     // Create window with custom delegate for borderless functionality
     CefRefPtr<CustomWindowDelegate> window_delegate = new CustomWindowDelegate();
@@ -463,9 +636,12 @@ int main(int argc, char* argv[]) {
     
     // Set window title
     g_cef_window->SetTitle(windowTitle);
+    g_cef_window->SetBackgroundColor(APP_BACKGROUND_COLOR);
     
     // Register window with loading manager (but DON'T show it yet)
-    loadingManager.SetWindow(g_cef_window);
+    if (!IPCBenchmark::IsEnabled()) {
+        loadingManager.SetWindow(g_cef_window);
+    }
     loadingManager.SetState(LoadingManager::LOADING_CONTENT, "Loading web content");
     
     // NOTE: Window will be shown automatically when content is loaded
@@ -484,42 +660,75 @@ int main(int argc, char* argv[]) {
     Logger::LogMessage("Mode: " + std::string(AppConfig::IsDebugMode() ? "DEBUG" : "RELEASE"));
     Logger::LogMessage("URL: " + startupUrl);
     Logger::LogMessage("Status: Window created but hidden until content loads");
+    if (config.remote_debugging_port > 0) {
+        Logger::LogMessage("Remote debugging: http://localhost:" + std::to_string(config.remote_debugging_port));
+    }
     if (AppConfig::IsDebugMode()) {
-        Logger::LogMessage("Remote debugging: http://localhost:9222");
         Logger::LogMessage("Make sure React dev server is running: cd webapp && bun run dev");
     }
     Logger::LogMessage("========================================================");
 
-    // Main loop with loading timeout
-    auto start_time = std::chrono::steady_clock::now();
-    const auto timeout_duration = std::chrono::seconds(30); // 30 second timeout
-    bool timeout_logged = false;
-    
-    while (g_running && g_cef_window && !g_cef_window->IsClosed()) {
-        HandleEvents();
-        CefDoMessageLoopWork();
-        
-        // Check for loading timeout
-        auto current_time = std::chrono::steady_clock::now();
-        auto elapsed = current_time - start_time;
+    // First spare once the main window has settled
+    BrowserPool::GetInstance().ScheduleRefill(5000);
+    MemoryMonitor::GetInstance().Start();
+    BackgroundPolicy::GetInstance().Start();
+
+    if (config.message_loop == RuntimeConfig::MESSAGE_LOOP_CEF) {
+        // CEF's own loop; returns once the main browser has closed
+        CefPostDelayedTask(TID_UI, new LoadingTimeoutTask(), kLoadingTimeoutMs);
+        CefRunMessageLoop();
+    } else {
+        // Main loop with loading timeout; sleeps until CEF work is due or input arrives
+        const auto timeout_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kLoadingTimeoutMs);
+        bool timeout_logged = false;
         
-        if (elapsed > timeout_duration && !loadingManager.HasError() && 
-            loadingManager.GetState() != LoadingManager::READY && !timeout_logged) {
-            Logger::LogMessage("⚠ Loading timeout - showing window anyway");
-            loadingManager.SetState(LoadingManager::READY, "Timeout - forcing show");
-            loadingManager.ShowWindowWhenReady();
-            timeout_logged = true;
+        while (g_running && g_cef_window && !g_cef_window->IsClosed()) {
+            HandleEvents();
+            
+            // Only wake for the loading timeout while it can still fire
+            if (messagePump.WaitForWork(timeout_logged ? MessagePump::Clock::time_point::max() : timeout_deadline)) {
+                messagePump.DoWork();
+            }
+            
+            // Check for loading timeout
+            if (!timeout_logged && std::chrono::steady_clock::now() >= timeout_deadline) {
+                timeout_logged = true;
+                ShowWindowAfterTimeout();
+            }
         }
-        
-#ifdef _WIN32
-        Sleep(1); // Small delay to prevent 100% CPU usage
-#else
-        usleep(1000); // 1ms delay on Linux
-#endif
     }
 
-    // Cleanup
+    // Close the spare and spawned windows. Window::Close() only starts closing,
+    // so keep the loop running until every browser has reached OnBeforeClose;
+    // CefShutdown() with browsers still open crashes.
+    BrowserPool::GetInstance().Shutdown();
+    if (SimpleClient::GetOpenBrowserCount() > 0) {
+        Logger::LogMessage("Waiting for " + std::to_string(SimpleClient::GetOpenBrowserCount()) +
+                           " browser(s) to close");
+        if (config.message_loop == RuntimeConfig::MESSAGE_LOOP_CEF) {
+            // SimpleClient::OnBeforeClose quits once the last one is gone
+            CefPostDelayedTask(TID_UI, new QuitMessageLoopTask(), kShutdownTimeoutMs);
+            CefRunMessageLoop();
+        } else {
+            const auto shutdown_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kShutdownTimeoutMs);
+            while (SimpleClient::GetOpenBrowserCount() > 0 && std::chrono::steady_clock::now() < shutdown_deadline) {
+                if (messagePump.WaitForWork(shutdown_deadline)) {
+                    messagePump.DoWork();
+                }
+            }
+        }
+        if (SimpleClient::GetOpenBrowserCount() > 0) {
+            Logger::LogError("Shutting down with " + std::to_string(SimpleClient::GetOpenBrowserCount()) +
+                             " browser(s) still open");
+        }
+    }
+
+    // Cleanup (workers first: their completions post to the UI thread)
+    FileWatcher::GetInstance().Shutdown();
+    TrigramIndex::GetInstance().Shutdown();
+    WorkerPool::GetInstance().Shutdown();
     CefShutdown();
+    Logger::Shutdown();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file.
+//
+// Pages are only read from disk when they are touched, so opening a large
+// file costs one system call and looking at a small part of it costs only
+// that part. Empty files open successfully with a null view.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Maps |path|, replacing any previous mapping. Returns false (and logs
+    // nothing; callers decide whether a missing file is an error) on failure.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return open_; }
+    const char* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    std::string_view GetView() const { return std::string_view(data_, size_); }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data_;
+    size_t size_;
+    bool open_;
+#ifdef _WIN32
+    void* mapping_;     // HANDLE of the file mapping object
+#endif
+};
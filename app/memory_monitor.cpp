@@ -0,0 +1,259 @@
+#include "memory_monitor.hpp"
+#include "logger.hpp"
+#include "internal/commandregistry.hpp"
+#include "include/cef_task.h"
+#include "include/cef_v8.h"
+#include "include/cef_values.h"
+#include "include/views/cef_browser_view.h"
+#include "include/views/cef_window.h"
+#include "include/wrapper/cef_helpers.h"
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <unistd.h>
+#else
+    #include <unistd.h>
+#endif
+
+// A trimmed window needs time to grow back before it is worth trimming again
+static const int64_t kMinTrimIntervalMs = 60000;
+
+static int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int CurrentProcessId() {
+#ifdef _WIN32
+    return static_cast<int>(GetCurrentProcessId());
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+class SampleTask : public CefTask {
+public:
+    void Execute() override { MemoryMonitor::GetInstance().Sample(); }
+
+private:
+    IMPLEMENT_REFCOUNTING(SampleTask);
+};
+
+namespace {
+    // get_memory_usage answers with the latest samples as JSON
+    bool HandleGetMemoryUsage(const SimpleIPC::CommandRequest& request, std::string& result) {
+        result = MemoryMonitor::GetInstance().GetUsageJson();
+        return true;
+    }
+}
+
+MemoryMonitor::MemoryMonitor()
+    : window_budget_mb_(0), app_threshold_mb_(0), interval_ms_(15000), started_(false) {
+}
+
+MemoryMonitor::~MemoryMonitor() {
+}
+
+MemoryMonitor& MemoryMonitor::GetInstance() {
+    static MemoryMonitor instance;
+    return instance;
+}
+
+void MemoryMonitor::Configure(size_t window_budget_mb, size_t app_threshold_mb, int interval_ms) {
+    window_budget_mb_ = window_budget_mb;
+    app_threshold_mb_ = app_threshold_mb;
+    interval_ms_ = interval_ms;
+    Logger::LogMessage("MemoryMonitor: Window budget " + std::to_string(window_budget_mb) + " MB, app threshold " +
+                       std::to_string(app_threshold_mb) + " MB");
+}
+
+void MemoryMonitor::Start() {
+    if (started_ || interval_ms_ <= 0) {
+        return;
+    }
+    started_ = true;
+    CefPostDelayedTask(TID_UI, new SampleTask(), interval_ms_);
+}
+
+void MemoryMonitor::AddBrowser(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+    BrowserUsage usage = { browser, 0, 0.0, 0.0, 0, 0 };
+    browsers_[browser->GetIdentifier()] = usage;
+}
+
+void MemoryMonitor::RemoveBrowser(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+    browsers_.erase(browser->GetIdentifier());
+}
+
+bool MemoryMonitor::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRefPtr<CefProcessMessage> message) {
+    if (message->GetName().ToString() != kUsageReplyMessage) {
+        return false;
+    }
+    auto it = browsers_.find(browser->GetIdentifier());
+    if (it == browsers_.end()) {
+        return true;
+    }
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    it->second.pid = args->GetInt(0);
+    it->second.rss_mb = args->GetDouble(1);
+    it->second.js_heap_mb = args->GetDouble(2);
+    return true;
+}
+
+// Decide on the previous round of samples, then ask for the next one
+void MemoryMonitor::Sample() {
+    Enforce();
+
+    for (auto& entry : browsers_) {
+        CefRefPtr<CefFrame> frame = entry.second.browser->GetMainFrame();
+        if (frame && frame->IsValid()) {
+            frame->SendProcessMessage(PID_RENDERER, CefProcessMessage::Create(kUsageRequestMessage));
+        }
+    }
+    CefPostDelayedTask(TID_UI, new SampleTask(), interval_ms_);
+}
+
+// With a shared renderer the process size says nothing about one window, so
+// only its JS heap counts against the budget
+double MemoryMonitor::GetWindowUsageMb(const BrowserUsage& usage) const {
+    for (const auto& entry : browsers_) {
+        if (&entry.second != &usage && entry.second.pid == usage.pid) {
+            return usage.js_heap_mb;
+        }
+    }
+    return usage.rss_mb;
+}
+
+// Browser process plus every renderer once (GPU and utility processes are not included)
+double MemoryMonitor::GetTotalMb() const {
+    double total = GetResidentBytes() / (1024.0 * 1024.0);
+    std::set<int> counted;
+    for (const auto& entry : browsers_) {
+        if (entry.second.pid != 0 && counted.insert(entry.second.pid).second) {
+            total += entry.second.rss_mb;
+        }
+    }
+    return total;
+}
+
+bool MemoryMonitor::IsForeground(CefRefPtr<CefBrowser> browser) {
+    CefRefPtr<CefBrowserView> browser_view = CefBrowserView::GetForBrowser(browser);
+    CefRefPtr<CefWindow> window = browser_view ? browser_view->GetWindow() : nullptr;
+    return window && window->IsVisible() && !window->IsMinimized() && window->IsActive();
+}
+
+void MemoryMonitor::Enforce() {
+    bool over_threshold = app_threshold_mb_ > 0 && GetTotalMb() > app_threshold_mb_;
+    int64_t now = NowMs();
+    for (auto& entry : browsers_) {
+        BrowserUsage& usage = entry.second;
+        if (usage.pid == 0 || IsForeground(usage.browser) || now - usage.last_trim_ms < kMinTrimIntervalMs) {
+            continue;
+        }
+        bool over_budget = window_budget_mb_ > 0 && GetWindowUsageMb(usage) > window_budget_mb_;
+        if (over_threshold || over_budget) {
+            usage.last_trim_ms = now;
+            Trim(usage);
+        }
+    }
+}
+
+// Same signal Chromium sends on OS memory pressure: Blink drops its memory
+// and font caches and V8 does a full, compacting GC
+void MemoryMonitor::Trim(BrowserUsage& usage) {
+    CefRefPtr<CefDictionaryValue> params = CefDictionaryValue::Create();
+    params->SetString("level", "critical");
+    usage.browser->GetHost()->ExecuteDevToolsMethod(0, "Memory.simulatePressureNotification", params);
+    ++usage.trims;
+    Logger::LogMessage("MemoryMonitor: Trimmed background browser " + std::to_string(usage.browser->GetIdentifier()) +
+                       " (window " + std::to_string(static_cast<int>(GetWindowUsageMb(usage))) + " MB)");
+}
+
+std::string MemoryMonitor::GetUsageJson() const {
+    std::ostringstream json;
+    json << "{\"browser_process_mb\":" << GetResidentBytes() / (1024.0 * 1024.0)
+         << ",\"total_mb\":" << GetTotalMb()
+         << ",\"window_budget_mb\":" << window_budget_mb_
+         << ",\"app_threshold_mb\":" << app_threshold_mb_
+         << ",\"browsers\":[";
+    bool first = true;
+    for (const auto& entry : browsers_) {
+        const BrowserUsage& usage = entry.second;
+        json << (first ? "" : ",")
+             << "{\"id\":" << entry.first
+             << ",\"pid\":" << usage.pid
+             << ",\"rss_mb\":" << usage.rss_mb
+             << ",\"js_heap_mb\":" << usage.js_heap_mb
+             << ",\"foreground\":" << (IsForeground(usage.browser) ? "true" : "false")
+             << ",\"trims\":" << usage.trims << "}";
+        first = false;
+    }
+    json << "]}";
+    return json.str();
+}
+
+bool MemoryMonitor::OnRendererMessage(CefRefPtr<CefFrame> frame, CefRefPtr<CefProcessMessage> message) {
+    if (message->GetName().ToString() != kUsageRequestMessage) {
+        return false;
+    }
+
+    // Precise with --enable-precise-memory-info, bucketed otherwise
+    double js_heap_bytes = 0.0;
+    CefRefPtr<CefV8Context> context = frame->GetV8Context();
+    if (context && context->IsValid()) {
+        CefRefPtr<CefV8Value> value;
+        CefRefPtr<CefV8Exception> exception;
+        if (context->Eval("performance.memory ? performance.memory.usedJSHeapSize : 0", CefString(), 0, value, exception) &&
+            value && (value->IsDouble() || value->IsInt() || value->IsUInt())) {
+            js_heap_bytes = value->GetDoubleValue();
+        }
+    }
+
+    CefRefPtr<CefProcessMessage> reply = CefProcessMessage::Create(kUsageReplyMessage);
+    CefRefPtr<CefListValue> args = reply->GetArgumentList();
+    args->SetInt(0, CurrentProcessId());
+    args->SetDouble(1, GetResidentBytes() / (1024.0 * 1024.0));
+    args->SetDouble(2, js_heap_bytes / (1024.0 * 1024.0));
+    frame->SendProcessMessage(PID_BROWSER, reply);
+    return true;
+}
+
+size_t MemoryMonitor::GetResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#else
+    // Second field of statm: resident pages
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    int fields = std::fscanf(statm, "%zu %zu", &total_pages, &resident_pages);
+    std::fclose(statm);
+    return fields == 2 ? resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+void MemoryMonitor::RegisterCommands() {
+    SimpleIPC::CommandRegistry::GetInstance().Register("get_memory_usage", HandleGetMemoryUsage);
+}
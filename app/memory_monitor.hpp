@@ -0,0 +1,77 @@
+#pragma once
+
+#include "include/cef_browser.h"
+#include "include/cef_process_message.h"
+#include <map>
+#include <string>
+
+// Memory budget for the IDE windows.
+//
+// Every browser's renderer reports its resident size and JS heap on request;
+// the browser process samples all browsers periodically, and when a window is
+// over its budget, or the app as a whole is over its threshold, the windows in
+// the background get a critical memory-pressure signal (Blink purges its
+// caches, V8 runs a full GC). The latest samples are available to the page
+// through the get_memory_usage query.
+class MemoryMonitor {
+public:
+    // Process message names
+    static constexpr const char* kUsageRequestMessage = "MemoryMonitor.Request";
+    static constexpr const char* kUsageReplyMessage = "MemoryMonitor.Reply";   // [pid, rss_mb, js_heap_mb]
+
+    // Singleton access
+    static MemoryMonitor& GetInstance();
+
+    // Budgets in MB; 0 disables the check
+    void Configure(size_t window_budget_mb, size_t app_threshold_mb, int interval_ms);
+
+    // UI thread: start periodic sampling
+    void Start();
+
+    // UI thread, from SimpleClient
+    void AddBrowser(CefRefPtr<CefBrowser> browser);
+    void RemoveBrowser(CefRefPtr<CefBrowser> browser);
+    bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRefPtr<CefProcessMessage> message);
+
+    // Renderer process: answer a kUsageRequestMessage
+    static bool OnRendererMessage(CefRefPtr<CefFrame> frame, CefRefPtr<CefProcessMessage> message);
+
+    // Resident set size of the calling process in bytes, 0 if unknown
+    static size_t GetResidentBytes();
+
+    // Register the get_memory_usage query with the CommandRegistry
+    static void RegisterCommands();
+
+    // JSON snapshot of the latest samples
+    std::string GetUsageJson() const;
+
+private:
+    struct BrowserUsage {
+        CefRefPtr<CefBrowser> browser;
+        int pid;
+        double rss_mb;
+        double js_heap_mb;
+        int64_t last_trim_ms;
+        int trims;
+    };
+
+    MemoryMonitor();
+    ~MemoryMonitor();
+    MemoryMonitor(const MemoryMonitor&);
+    MemoryMonitor& operator=(const MemoryMonitor&);
+
+    void Sample();
+    void Enforce();
+    double GetWindowUsageMb(const BrowserUsage& usage) const;
+    double GetTotalMb() const;
+    static bool IsForeground(CefRefPtr<CefBrowser> browser);
+    void Trim(BrowserUsage& usage);
+
+    friend class SampleTask;
+
+    std::map<int, BrowserUsage> browsers_;   // By browser identifier
+    size_t window_budget_mb_;
+    size_t app_threshold_mb_;
+    int interval_ms_;
+    bool started_;
+};
@@ -0,0 +1,185 @@
+#include "message_pump.hpp"
+#include "logger.hpp"
+#include "include/cef_app.h"
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <glib.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    const int64_t kNoWork = std::numeric_limits<int64_t>::max();
+
+    // Chromium does not schedule every piece of work it has, so an idle pump still
+    // runs CefDoMessageLoopWork() at this interval (same value as cefclient)
+    const int64_t kMaxTimerDelayMs = 1000 / 30;
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            MessagePump::Clock::now().time_since_epoch()).count();
+    }
+}
+
+#ifndef _WIN32
+// GLib source that becomes ready when CEF work is due. Its poll fd is the
+// eventfd other threads write to from ScheduleWork().
+struct MessagePumpSource {
+    static GPollFD poll_fd;
+
+    static gboolean Prepare(GSource* source, gint* timeout_ms) {
+        MessagePump& pump = MessagePump::GetInstance();
+        *timeout_ms = pump.TimeoutMs(pump.wait_deadline_);
+        return *timeout_ms == 0;
+    }
+
+    static gboolean Check(GSource* source) {
+        MessagePump& pump = MessagePump::GetInstance();
+        if (poll_fd.revents & G_IO_IN) {
+            // Drain the counter; the due time itself lives in due_time_
+            uint64_t value;
+            ssize_t ignored = read(pump.wakeup_fd_, &value, sizeof(value));
+            (void)ignored;
+        }
+        return pump.TimeoutMs(pump.wait_deadline_) == 0;
+    }
+
+    static gboolean Dispatch(GSource* source, GSourceFunc callback, gpointer user_data) {
+        MessagePump::GetInstance().work_due_.store(true);
+        return TRUE;
+    }
+};
+
+GPollFD MessagePumpSource::poll_fd;
+
+static GSourceFuncs g_work_source_funcs = {
+    MessagePumpSource::Prepare,
+    MessagePumpSource::Check,
+    MessagePumpSource::Dispatch,
+    nullptr,    // finalize
+    nullptr,    // closure_callback
+    nullptr     // closure_marshal
+};
+#endif
+
+MessagePump& MessagePump::GetInstance() {
+    static MessagePump instance;
+    return instance;
+}
+
+MessagePump::MessagePump()
+    : due_time_(kNoWork) {
+#ifdef _WIN32
+    // Auto-reset: one wake-up per SetEvent
+    wakeup_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!wakeup_event_) {
+        Logger::LogError("MessagePump: Failed to create wake-up event");
+    }
+#else
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        Logger::LogError("MessagePump: Failed to create eventfd");
+    }
+    wait_deadline_ = Clock::time_point::max();
+    work_due_.store(false);
+
+    MessagePumpSource::poll_fd.fd = wakeup_fd_;
+    MessagePumpSource::poll_fd.events = G_IO_IN;
+    MessagePumpSource::poll_fd.revents = 0;
+
+    // Attach to the default context so X11/Wayland sources wake the same wait
+    work_source_ = g_source_new(&g_work_source_funcs, sizeof(GSource));
+    g_source_add_poll(work_source_, &MessagePumpSource::poll_fd);
+    g_source_attach(work_source_, g_main_context_default());
+#endif
+}
+
+MessagePump::~MessagePump() {
+#ifdef _WIN32
+    if (wakeup_event_) {
+        CloseHandle(static_cast<HANDLE>(wakeup_event_));
+    }
+#else
+    g_source_destroy(work_source_);
+    g_source_unref(work_source_);
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+    }
+#endif
+}
+
+void MessagePump::ScheduleWork(int64_t delay_ms) {
+    int64_t delay_ns = std::max<int64_t>(delay_ms, 0) * 1000000;
+    due_time_.store(NowNs() + delay_ns);
+
+    // The waiting thread recomputes its timeout on every wake-up
+    Wakeup();
+}
+
+void MessagePump::Wakeup() {
+#ifdef _WIN32
+    SetEvent(static_cast<HANDLE>(wakeup_event_));
+#else
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeup_fd_, &one, sizeof(one));
+    (void)ignored;
+#endif
+}
+
+int MessagePump::TimeoutMs(Clock::time_point deadline) const {
+    int64_t due = due_time_.load();
+    if (deadline != Clock::time_point::max()) {
+        int64_t deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+        due = std::min(due, deadline_ns);
+    }
+    if (due == kNoWork) {
+        return -1;
+    }
+
+    int64_t remaining = due - NowNs();
+    if (remaining <= 0) {
+        return 0;
+    }
+    // Round up so the wait never ends just before the work is due
+    int64_t ms = (remaining + 999999) / 1000000;
+    return static_cast<int>(std::min<int64_t>(ms, std::numeric_limits<int>::max()));
+}
+
+bool MessagePump::WaitForWork(Clock::time_point deadline) {
+    if (TimeoutMs(deadline) == 0) {
+        return true;
+    }
+
+#ifdef _WIN32
+    int timeout = TimeoutMs(deadline);
+    HANDLE handle = static_cast<HANDLE>(wakeup_event_);
+    DWORD result = MsgWaitForMultipleObjectsEx(1, &handle,
+        timeout < 0 ? INFINITE : static_cast<DWORD>(timeout),
+        QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+    // Native messages are dispatched by CefDoMessageLoopWork()
+    return result == WAIT_OBJECT_0 + 1 || TimeoutMs(deadline) == 0;
+#else
+    // Blocks in poll() until a GLib source (ours, X11/Wayland, ...) is ready and
+    // dispatches it; returns without CEF work when only native events arrived
+    wait_deadline_ = deadline;
+    work_due_.store(false);
+    g_main_context_iteration(g_main_context_default(), TRUE);
+    wait_deadline_ = Clock::time_point::max();
+    return work_due_.exchange(false) || TimeoutMs(deadline) == 0;
+#endif
+}
+
+void MessagePump::DoWork() {
+    // Any request made while the work runs replaces this cleared value
+    due_time_.store(kNoWork);
+    CefDoMessageLoopWork();
+
+    int64_t expected = kNoWork;
+    due_time_.compare_exchange_strong(expected, NowNs() + kMaxTimerDelayMs * 1000000);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifndef _WIN32
+    typedef struct _GSource GSource;
+#endif
+
+// Event-driven external message pump for CEF (settings.external_message_pump).
+//
+// CEF reports pending work through OnScheduleMessagePumpWork(); the main thread
+// sleeps until that work is due instead of polling CefDoMessageLoopWork().
+// Windows waits on an event with MsgWaitForMultipleObjectsEx so native input
+// still wakes the loop. Linux waits in the default GLib context, which is where
+// Chromium's X11/Wayland event sources live, with an eventfd for wake-ups.
+class MessagePump {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Singleton access
+    static MessagePump& GetInstance();
+
+    // Any thread: CEF wants CefDoMessageLoopWork() after |delay_ms| (<= 0 means now).
+    // A new request replaces the pending one.
+    void ScheduleWork(int64_t delay_ms);
+
+    // Main thread: block until CEF work is due, native input arrives or |deadline|
+    // passes. Returns true when CefDoMessageLoopWork() should run.
+    bool WaitForWork(Clock::time_point deadline = Clock::time_point::max());
+
+    // Main thread: run one CefDoMessageLoopWork() iteration
+    void DoWork();
+
+private:
+    MessagePump();
+    ~MessagePump();
+    MessagePump(const MessagePump&);
+    MessagePump& operator=(const MessagePump&);
+
+    // Milliseconds until work is due: -1 when nothing is scheduled, 0 when due
+    int TimeoutMs(Clock::time_point deadline) const;
+    void Wakeup();
+
+#ifdef _WIN32
+    void* wakeup_event_;                // HANDLE of an auto-reset event
+#else
+    friend struct MessagePumpSource;
+    int wakeup_fd_;
+    GSource* work_source_;
+    Clock::time_point wait_deadline_;   // Deadline of the current WaitForWork()
+    std::atomic<bool> work_due_;
+#endif
+
+    // Steady-clock time (ns) at which CEF wants work done, kNoWork if none
+    std::atomic<int64_t> due_time_;
+};
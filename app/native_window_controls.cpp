@@ -24,7 +24,7 @@
 
 void NativeWindowControls::SetupNativeControls(CefRefPtr<CefWindow> window) {
     if (!window) {
-        Logger::LogMessage("NativeWindowControls: Invalid window reference");
+        Logger::LogError("NativeWindowControls: Invalid window reference");
         return;
     }
 
@@ -114,7 +114,7 @@ void NativeWindowControls::SetupWindowsControls(CefRefPtr<CefWindow> window) {
 #ifdef _WIN32
     HWND hwnd = window->GetWindowHandle();
     if (!hwnd) {
-        Logger::LogMessage("Windows: Failed to get window handle");
+        Logger::LogError("Windows: Failed to get window handle");
         return;
     }
 
@@ -134,7 +134,7 @@ void NativeWindowControls::SetupWindowsControls(CefRefPtr<CefWindow> window) {
     if (SUCCEEDED(hr)) {
         Logger::LogMessage("Windows: Successfully set up native controls with extended frame");
     } else {
-        Logger::LogMessage("Windows: Failed to extend frame into client area");
+        Logger::LogError("Windows: Failed to extend frame into client area");
     }
 
     // Apply changes
@@ -146,7 +146,7 @@ void NativeWindowControls::SetupMacOSControls(CefRefPtr<CefWindow> window) {
 #ifdef __APPLE__
     NSWindow* nsWindow = (__bridge NSWindow*)window->GetWindowHandle();
     if (!nsWindow) {
-        Logger::LogMessage("macOS: Failed to get NSWindow handle");
+        Logger::LogError("macOS: Failed to get NSWindow handle");
         return;
     }
 
@@ -175,7 +175,7 @@ void NativeWindowControls::SetupLinuxControls(CefRefPtr<CefWindow> window) {
 
     GtkWidget* gtkWindow = GTK_WIDGET(window->GetWindowHandle());
     if (!gtkWindow || !GTK_IS_WINDOW(gtkWindow)) {
-        Logger::LogMessage("Linux: Failed to get GTK window handle");
+        Logger::LogError("Linux: Failed to get GTK window handle");
         return;
     }
 
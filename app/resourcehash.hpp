@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hash functions shared by the generated webapp.cpp and ResourceUtil.
+// tools/utils/buildtobin.ts implements the exact same Hash32/Slot when it
+// builds the perfect-hash table, so both sides must stay in sync.
+namespace ResourceHash {
+    constexpr uint32_t kFnvOffset32 = 2166136261u;
+    constexpr uint32_t kFnvPrime32 = 16777619u;
+    constexpr uint64_t kFnvOffset64 = 14695981039346656037ull;
+    constexpr uint64_t kFnvPrime64 = 1099511628211ull;
+
+    // Seeded 32-bit FNV-1a over a byte range
+    constexpr uint32_t Hash32(const char* data, size_t length, uint32_t seed) {
+        uint32_t hash = kFnvOffset32 ^ seed;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= kFnvPrime32;
+        }
+        return hash;
+    }
+
+    // 64-bit FNV-1a, used for content hashes computed at runtime
+    constexpr uint64_t Hash64(const uint8_t* data, size_t length) {
+        uint64_t hash = kFnvOffset64;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= data[i];
+            hash *= kFnvPrime64;
+        }
+        return hash;
+    }
+
+    // Perfect-hash slot for a key: the first hash picks a bucket, the
+    // bucket's displacement seed picks a collision-free slot
+    constexpr uint32_t Slot(const char* key, size_t length,
+                            const uint32_t* seeds, uint32_t count) {
+        return count == 0 ? 0 :
+            Hash32(key, length, seeds[Hash32(key, length, 0) % count]) % count;
+    }
+}
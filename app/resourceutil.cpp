@@ -1,117 +1,194 @@
 #include "resourceutil.hpp"
 #include "webapp.hpp"
-#include <map>
+#include "resourcehash.hpp"
+#include <vector>
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <atomic>
 #include <mutex>
-#include "include/cef_stream.h"
+#include <cstdio>
 
 namespace ResourceUtil {
     
-    // Global preloaded resources storage
-    static std::map<std::string, PreloadedResource> g_preloadedResources;
-    static std::mutex g_resourceMutex;
-    static bool g_resourcesInitialized = false;
+    // Currently published bundle. Readers do a single acquire load, so IO-thread
+    // lookups never block. Published bundles are owned by g_publishedBundles and
+    // are never freed, which keeps every pointer a reader may still hold valid.
+    static std::atomic<const ResourceBundle*> g_bundle(nullptr);
+    static std::vector<std::unique_ptr<const ResourceBundle>> g_publishedBundles;
+    static std::mutex g_publishMutex; // Writers only
     
-    // Resource path to ID mapping (single HTML file with inlined assets)
-    static const std::map<std::string, int> resourceMap = {
-        {"/index.html", IDR_HTML_INDEX}
-    };
+    // Directory used by ReloadResources() for dev hot-swaps (set on the UI thread)
+    static std::string g_devBundleDirectory;
     
-    void InitializePreloadedResources() {
-        std::lock_guard<std::mutex> lock(g_resourceMutex);
-        
-        if (g_resourcesInitialized) {
-            return; // Already initialized
+    const PreloadedResource* ResourceBundle::Find(const std::string& path) const {
+        const PreloadedResource* resource = nullptr;
+        
+        if (embedded) {
+            // Perfect-hash slot in the generated table doubles as the index
+            const WebAppAsset* asset = FindWebAppAsset(path.data(), path.size());
+            if (asset) {
+                resource = &resources[asset - GetWebAppAssets()];
+            }
+        } else {
+            auto it = pathIndex.find(path);
+            if (it != pathIndex.end()) {
+                resource = &resources[it->second];
+            }
         }
         
-        // Initialize HTML resource (contains inlined CSS and JS)
-        PreloadedResource htmlResource;
-        const char* html_content = GetWebAppHTML();
-        unsigned int html_size = GetWebAppHTMLSize();
+        return (resource && resource->loaded) ? resource : nullptr;
+    }
+    
+    static std::string FormatEtag(uint64_t hash) {
+        char buffer[19];
+        snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(hash));
+        return buffer;
+    }
+    
+    static void ComputeStats(ResourceBundle& bundle) {
+        PreloadStats& stats = bundle.stats;
+        stats = {};
+        stats.totalResources = static_cast<int>(bundle.resources.size());
         
-        if (html_content && html_size > 0) {
-            htmlResource.data = std::vector<uint8_t>(html_content, html_content + html_size);
-            htmlResource.mimeType = GetMimeType("/index.html");
-            htmlResource.loaded = true;
-            g_preloadedResources["/index.html"] = std::move(htmlResource);
-            
-            // Log successful preload
-            std::string sizeStr = std::to_string(html_size);
-            // Note: We can't use Logger here as it might not be initialized yet
-            // Logger will be used in main.cpp after this function returns
-        } else {
-            // Log failure - resource not available
-            // Note: We can't use Logger here as it might not be initialized yet
+        for (const auto& resource : bundle.resources) {
+            if (resource.loaded) {
+                stats.loadedResources++;
+                stats.totalBytes += resource.data.size;
+                stats.uncompressedBytes += resource.originalSize;
+            }
         }
         
-        g_resourcesInitialized = true;
+        stats.allLoaded = (stats.loadedResources == stats.totalResources) && (stats.totalResources > 0);
     }
     
-    int GetResourceId(const std::string& path) {
-        auto it = resourceMap.find(path);
-        if (it != resourceMap.end()) {
-            return it->second;
+    static std::unique_ptr<ResourceBundle> CreateEmbeddedBundle() {
+        std::unique_ptr<ResourceBundle> bundle(new ResourceBundle());
+        bundle->embedded = true;
+        
+        // Register every asset of the embedded bundle (spans only, no copies)
+        const WebAppAsset* assets = GetWebAppAssets();
+        unsigned int count = GetWebAppAssetCount();
+        bundle->resources.resize(count);
+        
+        for (unsigned int i = 0; i < count; ++i) {
+            PreloadedResource& resource = bundle->resources[i];
+            resource.path = assets[i].path;
+            resource.data = ResourceSpan(assets[i].data, assets[i].size);
+            resource.originalSize = assets[i].original_size;
+            resource.encoding = assets[i].encoding == WEBAPP_ENCODING_BROTLI ?
+                ENCODING_BROTLI : ENCODING_IDENTITY;
+            resource.mimeType = GetMimeType(resource.path);
+            resource.etag = assets[i].etag;
+            resource.immutable = IsImmutablePath(resource.path);
+            resource.loaded = assets[i].data != nullptr;
         }
-        return -1; // Resource not found
+        
+        ComputeStats(*bundle);
+        return bundle;
     }
     
-    std::vector<uint8_t> LoadBinaryResource(int resource_id) {
-        // Ensure resources are initialized
-        if (!g_resourcesInitialized) {
-            InitializePreloadedResources();
+    static std::unique_ptr<ResourceBundle> CreateDirectoryBundle(const std::string& directory) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(directory, ec)) {
+            return nullptr;
         }
         
-        // Load HTML content from webapp.hpp
-        if (resource_id == IDR_HTML_INDEX) {
-            const char* html_content = GetWebAppHTML();
-            unsigned int html_size = GetWebAppHTMLSize();
+        std::unique_ptr<ResourceBundle> bundle(new ResourceBundle());
+        bundle->embedded = false;
+        
+        std::filesystem::recursive_directory_iterator it(directory, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            
+            std::ifstream file(it->path(), std::ios::binary);
+            if (!file) {
+                continue;
+            }
             
-            std::vector<uint8_t> data(html_content, html_content + html_size);
-            return data;
+            // Disk bundles own their bytes; the spans point into |storage|
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                                       std::istreambuf_iterator<char>());
+            bundle->storage.push_back(std::move(bytes));
+            const std::vector<uint8_t>& stored = bundle->storage.back();
+            
+            PreloadedResource resource;
+            resource.path = "/" + std::filesystem::relative(it->path(), directory, ec).generic_string();
+            resource.data = ResourceSpan(stored.data(), stored.size());
+            resource.originalSize = stored.size();
+            resource.encoding = ENCODING_IDENTITY;
+            resource.mimeType = GetMimeType(resource.path);
+            resource.etag = FormatEtag(ResourceHash::Hash64(stored.data(), stored.size()));
+            resource.immutable = IsImmutablePath(resource.path);
+            resource.loaded = true;
+            
+            bundle->pathIndex[resource.path] = bundle->resources.size();
+            bundle->resources.push_back(std::move(resource));
+        }
+        
+        ComputeStats(*bundle);
+        return bundle;
+    }
+    
+    static void PublishBundle(std::unique_ptr<ResourceBundle> bundle, bool only_if_empty) {
+        std::lock_guard<std::mutex> lock(g_publishMutex);
+        if (only_if_empty && g_bundle.load(std::memory_order_acquire)) {
+            return;
         }
         
-        // Return empty vector for unknown resources
-        return std::vector<uint8_t>();
+        g_bundle.store(bundle.get(), std::memory_order_release);
+        g_publishedBundles.push_back(std::move(bundle));
     }
     
-    const PreloadedResource* GetPreloadedResource(const std::string& path) {
-        std::lock_guard<std::mutex> lock(g_resourceMutex);
+    void InitializePreloadedResources() {
+        if (g_bundle.load(std::memory_order_acquire)) {
+            return; // Already initialized
+        }
         
-        // Ensure resources are initialized
-        if (!g_resourcesInitialized) {
+        // Publish the embedded bundle exactly once
+        PublishBundle(CreateEmbeddedBundle(), true);
+        // Note: We can't use Logger here as it might not be initialized yet
+        // Logger will be used in main.cpp after this function returns
+    }
+    
+    const ResourceBundle* GetResourceBundle() {
+        const ResourceBundle* bundle = g_bundle.load(std::memory_order_acquire);
+        if (!bundle) {
             InitializePreloadedResources();
+            bundle = g_bundle.load(std::memory_order_acquire);
+        }
+        return bundle;
+    }
+    
+    void SetDevBundleDirectory(const std::string& directory) {
+        g_devBundleDirectory = directory;
+    }
+    
+    bool ReloadResources() {
+        if (g_devBundleDirectory.empty()) {
+            return false;
         }
         
-        auto it = g_preloadedResources.find(path);
-        if (it != g_preloadedResources.end() && it->second.loaded) {
-            return &it->second;
+        std::unique_ptr<ResourceBundle> bundle = CreateDirectoryBundle(g_devBundleDirectory);
+        if (!bundle || !bundle->stats.allLoaded) {
+            return false;
         }
         
-        return nullptr;
+        // In-flight handlers keep reading the previous bundle, which stays alive
+        PublishBundle(std::move(bundle), false);
+        return true;
     }
     
     bool AreResourcesInitialized() {
-        std::lock_guard<std::mutex> lock(g_resourceMutex);
-        return g_resourcesInitialized;
+        return g_bundle.load(std::memory_order_acquire) != nullptr;
     }
     
     PreloadStats GetPreloadStats() {
-        std::lock_guard<std::mutex> lock(g_resourceMutex);
-        
-        PreloadStats stats = {};
-        stats.totalResources = static_cast<int>(g_preloadedResources.size());
-        stats.loadedResources = 0;
-        stats.totalBytes = 0;
-        
-        for (const auto& pair : g_preloadedResources) {
-            if (pair.second.loaded) {
-                stats.loadedResources++;
-                stats.totalBytes += pair.second.data.size();
-            }
-        }
-        
-        stats.allLoaded = (stats.loadedResources == stats.totalResources) && (stats.totalResources > 0);
-        return stats;
+        const ResourceBundle* bundle = g_bundle.load(std::memory_order_acquire);
+        return bundle ? bundle->stats : PreloadStats{};
     }
     
     std::string GetMimeType(const std::string& path) {
@@ -138,19 +215,32 @@ namespace ResourceUtil {
             return "image/jpeg";
         } else if (ends_with(lower_path, ".svg")) {
             return "image/svg+xml";
+        } else if (ends_with(lower_path, ".mjs")) {
+            return "application/javascript";
+        } else if (ends_with(lower_path, ".gif")) {
+            return "image/gif";
+        } else if (ends_with(lower_path, ".webp")) {
+            return "image/webp";
+        } else if (ends_with(lower_path, ".ico")) {
+            return "image/x-icon";
+        } else if (ends_with(lower_path, ".woff2")) {
+            return "font/woff2";
+        } else if (ends_with(lower_path, ".woff")) {
+            return "font/woff";
+        } else if (ends_with(lower_path, ".ttf")) {
+            return "font/ttf";
+        } else if (ends_with(lower_path, ".wasm")) {
+            return "application/wasm";
+        } else if (ends_with(lower_path, ".map")) {
+            return "application/json";
+        } else if (ends_with(lower_path, ".txt")) {
+            return "text/plain";
         }
         
         return "application/octet-stream";
     }
     
-    CefRefPtr<CefStreamReader> CreateResourceReader(const std::vector<uint8_t>& data) {
-        if (data.empty()) {
-            return nullptr;
-        }
-        
-        return CefStreamReader::CreateForData(
-            const_cast<void*>(static_cast<const void*>(data.data())), 
-            data.size()
-        );
+    bool IsImmutablePath(const std::string& path) {
+        return path.compare(0, 8, "/assets/") == 0;
     }
 }
\ No newline at end of file
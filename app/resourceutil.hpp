@@ -1,52 +1,88 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <map>
 #include <memory>
-#include "include/cef_stream.h"
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
 
 namespace ResourceUtil {
-    // Resource ID definitions (single HTML file with inlined CSS/JS)
-    enum ResourceId {
-        IDR_HTML_INDEX = 100
+    // Non-owning view over resource bytes that live in the embedded bundle
+    struct ResourceSpan {
+        const uint8_t* data;
+        size_t size;
+
+        ResourceSpan() : data(nullptr), size(0) {}
+        ResourceSpan(const uint8_t* d, size_t s) : data(d), size(s) {}
+
+        bool empty() const { return data == nullptr || size == 0; }
+    };
+
+    // How a resource's bytes are stored in the bundle
+    enum ResourceEncoding {
+        ENCODING_IDENTITY = 0,
+        ENCODING_BROTLI = 1
     };
-    
-    // Preloaded resource structure
+
+    // Preloaded resource structure (points into static bundle data, never copied)
     struct PreloadedResource {
-        std::vector<uint8_t> data;
+        std::string path;
+        ResourceSpan data;          // Stored bytes, possibly compressed
+        size_t originalSize;        // Size after decoding
+        ResourceEncoding encoding;
         std::string mimeType;
+        std::string etag;           // Quoted strong ETag derived from the content
+        bool immutable;             // Content-hashed file name, safe to cache forever
         bool loaded;
-        
-        PreloadedResource() : loaded(false) {}
+
+        PreloadedResource() : originalSize(0), encoding(ENCODING_IDENTITY), immutable(false), loaded(false) {}
     };
-    
-    // Initialize preloaded resources at startup
-    void InitializePreloadedResources();
-    
-    // Get resource ID from path
-    int GetResourceId(const std::string& path);
-    
-    // Load binary resource by ID (with preload support)
-    std::vector<uint8_t> LoadBinaryResource(int resource_id);
-    
-    // Get preloaded resource by path
-    const PreloadedResource* GetPreloadedResource(const std::string& path);
-    
-    // Get MIME type from file extension
-    std::string GetMimeType(const std::string& path);
-    
-    // Create CEF stream reader from resource data
-    CefRefPtr<CefStreamReader> CreateResourceReader(const std::vector<uint8_t>& data);
-    
-    // Check if resources are initialized
-    bool AreResourcesInitialized();
-    
+
     // Get preload statistics
     struct PreloadStats {
         int totalResources;
         int loadedResources;
-        size_t totalBytes;
+        size_t totalBytes;          // Bytes stored in the binary
+        size_t uncompressedBytes;   // Bytes served after decoding
         bool allLoaded;
     };
+
+    // Immutable set of resources. A bundle is never modified or freed after
+    // it is published, so readers only need the pointer, never a lock.
+    struct ResourceBundle {
+        std::vector<PreloadedResource> resources;
+        std::unordered_map<std::string, size_t> pathIndex;  // Disk bundles only
+        std::deque<std::vector<uint8_t>> storage;           // Owned bytes for disk bundles
+        PreloadStats stats;
+        bool embedded;
+
+        ResourceBundle() : stats(), embedded(false) {}
+
+        // Find a loaded resource by URL path, nullptr if unknown
+        const PreloadedResource* Find(const std::string& path) const;
+    };
+
+    // Build and publish the embedded bundle at startup (no-op once published)
+    void InitializePreloadedResources();
+
+    // Lock-free snapshot of the current bundle. The pointer stays valid for the
+    // lifetime of the process, even after a hot-swap publishes a newer bundle.
+    const ResourceBundle* GetResourceBundle();
+
+    // Dev reloads: remember a webapp/dist directory and hot-swap a bundle read from it.
+    // Every reload keeps the previous bundle resident, so this is not for production.
+    void SetDevBundleDirectory(const std::string& directory);
+    bool ReloadResources();
+
+    // Get MIME type from file extension
+    std::string GetMimeType(const std::string& path);
+
+    // Whether a path carries a content hash in its name (Vite emits these under /assets/)
+    bool IsImmutablePath(const std::string& path);
+
+    // Check if resources are initialized
+    bool AreResourcesInitialized();
+
     PreloadStats GetPreloadStats();
-}
\ No newline at end of file
+}
@@ -0,0 +1,737 @@
+#include "search_pattern.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SEARCH_PATTERN_SSE2 1
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+namespace {
+    // Instructions a pattern may compile to; {m,n} copies its operand
+    const size_t kMaxInstructions = 20000;
+    const int kMaxRepeat = 1000;
+
+    inline uint8_t ToLower(uint8_t c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<uint8_t>(c + ('a' - 'A')) : c;
+    }
+
+    inline uint8_t ToUpper(uint8_t c) {
+        return c >= 'a' && c <= 'z' ? static_cast<uint8_t>(c - ('a' - 'A')) : c;
+    }
+
+    inline bool IsWordByte(uint8_t c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+#ifdef SEARCH_PATTERN_SSE2
+    inline int CountTrailingZeros(uint32_t value) {
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return static_cast<int>(index);
+    #else
+        return __builtin_ctz(value);
+    #endif
+    }
+#endif
+
+    enum NodeType {
+        NODE_LITERAL,
+        NODE_ANY,
+        NODE_CLASS,
+        NODE_LINE_BEGIN,
+        NODE_LINE_END,
+        NODE_WORD_BOUNDARY,
+        NODE_NOT_WORD_BOUNDARY,
+        NODE_CONCAT,
+        NODE_ALTERNATE,
+        NODE_REPEAT
+    };
+
+    struct Node {
+        NodeType type;
+        uint8_t byte;           // NODE_LITERAL, folded when ignoring case
+        uint32_t klass;         // NODE_CLASS
+        int min;                // NODE_REPEAT; max -1 is unbounded
+        int max;
+        bool greedy;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    std::unique_ptr<Node> MakeNode(NodeType type) {
+        std::unique_ptr<Node> node(new Node());
+        node->type = type;
+        node->byte = 0;
+        node->klass = 0;
+        node->min = 0;
+        node->max = 0;
+        node->greedy = true;
+        return node;
+    }
+
+    // Longest run of bytes that every match contains, from the top-level
+    // sequence and the bodies of repeats that must run at least once
+    void CollectLiteral(const Node& node, std::string& run, std::string& best) {
+        auto finish = [&run, &best]() {
+            if (run.size() > best.size()) {
+                best = run;
+            }
+            run.clear();
+        };
+        switch (node.type) {
+        case NODE_LITERAL:
+            run += static_cast<char>(node.byte);
+            break;
+        case NODE_LINE_BEGIN:
+        case NODE_LINE_END:
+        case NODE_WORD_BOUNDARY:
+        case NODE_NOT_WORD_BOUNDARY:
+            break;      // Zero width, the bytes around stay adjacent
+        case NODE_CONCAT:
+            for (const std::unique_ptr<Node>& child : node.children) {
+                CollectLiteral(*child, run, best);
+            }
+            break;
+        case NODE_REPEAT:
+            finish();
+            if (node.min > 0) {
+                CollectLiteral(*node.children[0], run, best);
+                finish();
+            }
+            break;
+        default:
+            finish();
+            break;
+        }
+    }
+}
+
+// Recursive descent from the pattern to an AST, then to Pike VM instructions
+class RegexCompiler {
+public:
+    RegexCompiler(std::string_view pattern, SearchPattern& target)
+        : pattern_(pattern), position_(0), target_(target) {}
+
+    bool Compile(std::string& error) {
+        std::unique_ptr<Node> root = ParseAlternate();
+        if (root && position_ < pattern_.size()) {
+            Fail("Unmatched ')'");
+        }
+        if (!error_.empty()) {
+            error = error_ + " at offset " + std::to_string(position_);
+            return false;
+        }
+
+        std::string run;
+        std::string best;
+        CollectLiteral(*root, run, best);
+        target_.literal_ = run.size() > best.size() ? run : best;
+
+        Emit(*root);
+        if (target_.program_.size() > kMaxInstructions) {
+            error = "Pattern too complex";
+            return false;
+        }
+        EmitOp(SearchPattern::OP_MATCH);
+        return true;
+    }
+
+private:
+    bool AtEnd() const { return position_ >= pattern_.size(); }
+    char Peek() const { return pattern_[position_]; }
+
+    std::unique_ptr<Node> Fail(const std::string& error) {
+        if (error_.empty()) {
+            error_ = error;
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Node> ParseAlternate() {
+        std::unique_ptr<Node> first = ParseConcat();
+        if (!first || AtEnd() || Peek() != '|') {
+            return first;
+        }
+        std::unique_ptr<Node> alternate = MakeNode(NODE_ALTERNATE);
+        alternate->children.push_back(std::move(first));
+        while (!AtEnd() && Peek() == '|') {
+            ++position_;
+            std::unique_ptr<Node> next = ParseConcat();
+            if (!next) {
+                return nullptr;
+            }
+            alternate->children.push_back(std::move(next));
+        }
+        return alternate;
+    }
+
+    std::unique_ptr<Node> ParseConcat() {
+        std::unique_ptr<Node> concat = MakeNode(NODE_CONCAT);
+        while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+            std::unique_ptr<Node> item = ParseRepeat();
+            if (!item) {
+                return nullptr;
+            }
+            concat->children.push_back(std::move(item));
+        }
+        return concat;
+    }
+
+    // {m}, {m,} or {m,n}; anything else leaves '{' to be read as a literal
+    bool ParseBounds(int& min, int& max) {
+        size_t i = position_ + 1;
+        auto number = [this, &i](int& value) {
+            size_t start = i;
+            value = 0;
+            while (i < pattern_.size() && pattern_[i] >= '0' && pattern_[i] <= '9' && value <= kMaxRepeat) {
+                value = value * 10 + (pattern_[i++] - '0');
+            }
+            return i > start;
+        };
+        if (!number(min)) {
+            return false;
+        }
+        max = min;
+        if (i < pattern_.size() && pattern_[i] == ',') {
+            ++i;
+            if (!number(max)) {
+                max = -1;
+            }
+        }
+        if (i >= pattern_.size() || pattern_[i] != '}') {
+            return false;
+        }
+        position_ = i + 1;
+        return true;
+    }
+
+    std::unique_ptr<Node> ParseRepeat() {
+        std::unique_ptr<Node> atom = ParseAtom();
+        while (atom && !AtEnd()) {
+            int min = 0;
+            int max = -1;
+            char c = Peek();
+            if (c == '*' || c == '+' || c == '?') {
+                min = c == '+' ? 1 : 0;
+                max = c == '?' ? 1 : -1;
+                ++position_;
+            } else if (c != '{' || !ParseBounds(min, max)) {
+                break;
+            }
+            if (min > kMaxRepeat || max > kMaxRepeat) {
+                return Fail("Repeat count too large");
+            }
+            if (max >= 0 && max < min) {
+                return Fail("Bad repeat range");
+            }
+            std::unique_ptr<Node> repeat = MakeNode(NODE_REPEAT);
+            repeat->min = min;
+            repeat->max = max;
+            if (!AtEnd() && Peek() == '?') {
+                repeat->greedy = false;
+                ++position_;
+            }
+            repeat->children.push_back(std::move(atom));
+            atom = std::move(repeat);
+        }
+        return atom;
+    }
+
+    // \d \w \s and their negations
+    bool AddShorthand(char c, std::bitset<256>& set) {
+        std::bitset<256> shorthand;
+        switch (ToLower(static_cast<uint8_t>(c))) {
+        case 'd':
+            for (int b = '0'; b <= '9'; ++b) {
+                shorthand.set(b);
+            }
+            break;
+        case 'w':
+            for (int b = 0; b < 128; ++b) {
+                if (IsWordByte(static_cast<uint8_t>(b))) {
+                    shorthand.set(b);
+                }
+            }
+            break;
+        case 's':
+            for (char b : std::string_view(" \t\r\v\f")) {
+                shorthand.set(static_cast<uint8_t>(b));
+            }
+            break;
+        default:
+            return false;
+        }
+        set |= c >= 'A' && c <= 'Z' ? ~shorthand : shorthand;
+        return true;
+    }
+
+    uint8_t EscapedByte(char c) {
+        switch (c) {
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        default: return static_cast<uint8_t>(c);
+        }
+    }
+
+    std::unique_ptr<Node> MakeClass(std::bitset<256> set) {
+        if (target_.ignore_case_) {
+            for (int c = 'a'; c <= 'z'; ++c) {
+                if (set.test(c) || set.test(ToUpper(static_cast<uint8_t>(c)))) {
+                    set.set(c);
+                    set.set(ToUpper(static_cast<uint8_t>(c)));
+                }
+            }
+        }
+        set.reset('\n');
+        std::unique_ptr<Node> node = MakeNode(NODE_CLASS);
+        node->klass = static_cast<uint32_t>(target_.classes_.size());
+        target_.classes_.push_back(set);
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseClass() {
+        std::bitset<256> set;
+        bool negate = !AtEnd() && Peek() == '^';
+        if (negate) {
+            ++position_;
+        }
+        bool first = true;
+        while (!AtEnd() && (first || Peek() != ']')) {
+            first = false;
+            uint8_t low = static_cast<uint8_t>(pattern_[position_++]);
+            if (low == '\\') {
+                if (AtEnd()) {
+                    return Fail("Trailing backslash");
+                }
+                char escaped = pattern_[position_++];
+                if (AddShorthand(escaped, set)) {
+                    continue;
+                }
+                low = EscapedByte(escaped);
+            }
+            uint8_t high = low;
+            if (position_ + 1 < pattern_.size() && Peek() == '-' && pattern_[position_ + 1] != ']') {
+                high = static_cast<uint8_t>(pattern_[position_ + 1]);
+                position_ += 2;
+                if (high == '\\' && !AtEnd()) {
+                    high = EscapedByte(pattern_[position_++]);
+                }
+                if (high < low) {
+                    return Fail("Bad class range");
+                }
+            }
+            for (int c = low; c <= high; ++c) {
+                set.set(c);
+            }
+        }
+        if (AtEnd()) {
+            return Fail("Missing ']'");
+        }
+        ++position_;
+        return MakeClass(negate ? ~set : set);
+    }
+
+    std::unique_ptr<Node> ParseAtom() {
+        char c = pattern_[position_++];
+        switch (c) {
+        case '(': {
+            if (pattern_.substr(position_, 2) == "?:") {
+                position_ += 2;
+            }
+            std::unique_ptr<Node> group = ParseAlternate();
+            if (!group) {
+                return nullptr;
+            }
+            if (AtEnd() || Peek() != ')') {
+                return Fail("Missing ')'");
+            }
+            ++position_;
+            return group;
+        }
+        case '[':
+            return ParseClass();
+        case '.':
+            return MakeNode(NODE_ANY);
+        case '^':
+            return MakeNode(NODE_LINE_BEGIN);
+        case '$':
+            return MakeNode(NODE_LINE_END);
+        case '*':
+        case '+':
+        case '?':
+            --position_;
+            return Fail("Nothing to repeat");
+        case '\\': {
+            if (AtEnd()) {
+                return Fail("Trailing backslash");
+            }
+            char escaped = pattern_[position_++];
+            if (escaped == 'b') {
+                return MakeNode(NODE_WORD_BOUNDARY);
+            }
+            if (escaped == 'B') {
+                return MakeNode(NODE_NOT_WORD_BOUNDARY);
+            }
+            std::bitset<256> set;
+            if (AddShorthand(escaped, set)) {
+                return MakeClass(set);
+            }
+            c = static_cast<char>(EscapedByte(escaped));
+            break;
+        }
+        default:
+            break;
+        }
+        std::unique_ptr<Node> literal = MakeNode(NODE_LITERAL);
+        literal->byte = target_.ignore_case_ ? ToLower(static_cast<uint8_t>(c)) : static_cast<uint8_t>(c);
+        return literal;
+    }
+
+    uint32_t EmitOp(SearchPattern::Op op, uint8_t byte = 0, uint32_t x = 0, uint32_t y = 0) {
+        target_.program_.push_back({ op, byte, x, y });
+        return static_cast<uint32_t>(target_.program_.size() - 1);
+    }
+
+    uint32_t Next() const { return static_cast<uint32_t>(target_.program_.size()); }
+
+    void Emit(const Node& node) {
+        // Give up early on runaway copies; Compile() reports it
+        if (target_.program_.size() > kMaxInstructions) {
+            return;
+        }
+        std::vector<SearchPattern::Instruction>& program = target_.program_;
+        switch (node.type) {
+        case NODE_LITERAL:
+            EmitOp(SearchPattern::OP_BYTE, node.byte);
+            break;
+        case NODE_ANY:
+            EmitOp(SearchPattern::OP_ANY);
+            break;
+        case NODE_CLASS:
+            EmitOp(SearchPattern::OP_CLASS, 0, node.klass);
+            break;
+        case NODE_LINE_BEGIN:
+            EmitOp(SearchPattern::OP_LINE_BEGIN);
+            break;
+        case NODE_LINE_END:
+            EmitOp(SearchPattern::OP_LINE_END);
+            break;
+        case NODE_WORD_BOUNDARY:
+            EmitOp(SearchPattern::OP_WORD_BOUNDARY);
+            break;
+        case NODE_NOT_WORD_BOUNDARY:
+            EmitOp(SearchPattern::OP_NOT_WORD_BOUNDARY);
+            break;
+        case NODE_CONCAT:
+            for (const std::unique_ptr<Node>& child : node.children) {
+                Emit(*child);
+            }
+            break;
+        case NODE_ALTERNATE: {
+            std::vector<uint32_t> jumps;
+            for (size_t i = 0; i < node.children.size(); ++i) {
+                uint32_t split = 0;
+                bool last = i + 1 == node.children.size();
+                if (!last) {
+                    split = EmitOp(SearchPattern::OP_SPLIT, 0, Next() + 1);
+                }
+                Emit(*node.children[i]);
+                if (!last) {
+                    jumps.push_back(EmitOp(SearchPattern::OP_JUMP));
+                    program[split].y = Next();
+                }
+            }
+            for (uint32_t jump : jumps) {
+                program[jump].x = Next();
+            }
+            break;
+        }
+        case NODE_REPEAT: {
+            const Node& body = *node.children[0];
+            for (int i = 0; i < node.min; ++i) {
+                Emit(body);
+            }
+            if (node.max < 0) {
+                // loop: split body, exit; body; jump loop
+                uint32_t loop = EmitOp(SearchPattern::OP_SPLIT);
+                Emit(body);
+                EmitOp(SearchPattern::OP_JUMP, 0, loop);
+                Branch(loop, loop + 1, Next(), node.greedy);
+            } else {
+                // Nested optionals, each skipping to the end
+                std::vector<uint32_t> splits;
+                for (int i = node.min; i < node.max; ++i) {
+                    splits.push_back(EmitOp(SearchPattern::OP_SPLIT));
+                    Emit(body);
+                }
+                for (uint32_t split : splits) {
+                    Branch(split, split + 1, Next(), node.greedy);
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    // Greedy prefers entering the body
+    void Branch(uint32_t split, uint32_t body, uint32_t skip, bool greedy) {
+        if (split >= target_.program_.size()) {
+            return;
+        }
+        target_.program_[split].x = greedy ? body : skip;
+        target_.program_[split].y = greedy ? skip : body;
+    }
+
+    std::string_view pattern_;
+    size_t position_;
+    SearchPattern& target_;
+    std::string error_;
+};
+
+namespace {
+    struct VmThread {
+        uint32_t pc;
+        const char* start;
+    };
+
+    // Per worker, so matching a line allocates nothing once warmed up
+    struct VmState {
+        std::vector<VmThread> current;
+        std::vector<VmThread> next;
+        std::vector<VmThread> stack;
+        std::vector<uint32_t> marks;
+        uint32_t generation = 0;
+    };
+
+    thread_local VmState vm_state;
+}
+
+std::shared_ptr<const SearchPattern> SearchPattern::Compile(std::string_view pattern, bool regex, bool ignore_case,
+                                                            std::string& error) {
+    if (pattern.empty()) {
+        error = "Empty pattern";
+        return nullptr;
+    }
+    std::shared_ptr<SearchPattern> compiled(new SearchPattern());
+    compiled->regex_ = regex;
+    compiled->ignore_case_ = ignore_case;
+    if (!regex) {
+        compiled->literal_.assign(pattern.data(), pattern.size());
+        if (ignore_case) {
+            for (char& c : compiled->literal_) {
+                c = static_cast<char>(ToLower(static_cast<uint8_t>(c)));
+            }
+        }
+        return compiled;
+    }
+
+    RegexCompiler compiler(pattern, *compiled);
+    if (!compiler.Compile(error)) {
+        return nullptr;
+    }
+    return compiled;
+}
+
+bool SearchPattern::Verify(const char* at) const {
+    if (!ignore_case_) {
+        return std::memcmp(at, literal_.data(), literal_.size()) == 0;
+    }
+    for (size_t i = 0; i < literal_.size(); ++i) {
+        if (ToLower(static_cast<uint8_t>(at[i])) != static_cast<uint8_t>(literal_[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* SearchPattern::FindLiteral(const char* begin, const char* end) const {
+    size_t length = literal_.size();
+    if (static_cast<size_t>(end - begin) < length) {
+        return nullptr;
+    }
+    const uint8_t first = static_cast<uint8_t>(literal_[0]);
+    const uint8_t last = static_cast<uint8_t>(literal_[length - 1]);
+    if (length == 1 && !ignore_case_) {
+        return static_cast<const char*>(std::memchr(begin, first, end - begin));
+    }
+
+    const char* last_start = end - length;
+    const char* p = begin;
+#ifdef SEARCH_PATTERN_SSE2
+    // Both 16-byte loads must stay inside the buffer
+    const __m128i first_lower = _mm_set1_epi8(static_cast<char>(first));
+    const __m128i first_upper = _mm_set1_epi8(static_cast<char>(ignore_case_ ? ToUpper(first) : first));
+    const __m128i last_lower = _mm_set1_epi8(static_cast<char>(last));
+    const __m128i last_upper = _mm_set1_epi8(static_cast<char>(ignore_case_ ? ToUpper(last) : last));
+    for (; p + 15 <= last_start; p += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + length - 1));
+        __m128i hit_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lower), _mm_cmpeq_epi8(block_first, first_upper));
+        __m128i hit_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lower), _mm_cmpeq_epi8(block_last, last_upper));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(hit_first, hit_last)));
+        while (mask != 0) {
+            const char* candidate = p + CountTrailingZeros(mask);
+            if (Verify(candidate)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; p <= last_start; ++p) {
+        uint8_t c = static_cast<uint8_t>(*p);
+        if ((ignore_case_ ? ToLower(c) : c) == first && Verify(p)) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Pike VM: all threads advance in lockstep over the line, in priority order,
+// so the leftmost match wins and no input byte is looked at twice
+bool SearchPattern::MatchLine(const char* begin, const char* end, const char*& match) const {
+    VmState& state = vm_state;
+    if (state.marks.size() < program_.size()) {
+        state.marks.assign(program_.size(), 0);
+        state.generation = 0;
+    }
+    auto add_thread = [this, &state, begin, end](std::vector<VmThread>& list, uint32_t pc, const char* start,
+                                                 const char* position) {
+        state.stack.push_back({ pc, start });
+        while (!state.stack.empty()) {
+            VmThread thread = state.stack.back();
+            state.stack.pop_back();
+            if (state.marks[thread.pc] == state.generation) {
+                continue;
+            }
+            state.marks[thread.pc] = state.generation;
+            const Instruction& instruction = program_[thread.pc];
+            bool word_before = position > begin && IsWordByte(static_cast<uint8_t>(position[-1]));
+            bool word_after = position < end && IsWordByte(static_cast<uint8_t>(*position));
+            switch (instruction.op) {
+            case OP_JUMP:
+                state.stack.push_back({ instruction.x, thread.start });
+                break;
+            case OP_SPLIT:
+                // Pushed last, popped first: x has priority
+                state.stack.push_back({ instruction.y, thread.start });
+                state.stack.push_back({ instruction.x, thread.start });
+                break;
+            case OP_LINE_BEGIN:
+                if (position == begin) {
+                    state.stack.push_back({ thread.pc + 1, thread.start });
+                }
+                break;
+            case OP_LINE_END:
+                if (position == end) {
+                    state.stack.push_back({ thread.pc + 1, thread.start });
+                }
+                break;
+            case OP_WORD_BOUNDARY:
+            case OP_NOT_WORD_BOUNDARY:
+                if ((word_before != word_after) == (instruction.op == OP_WORD_BOUNDARY)) {
+                    state.stack.push_back({ thread.pc + 1, thread.start });
+                }
+                break;
+            default:
+                list.push_back(thread);
+                break;
+            }
+        }
+    };
+    auto next_generation = [&state]() {
+        if (++state.generation == 0) {
+            std::fill(state.marks.begin(), state.marks.end(), 0);
+            state.generation = 1;
+        }
+    };
+
+    bool matched = false;
+    state.current.clear();
+    next_generation();
+    for (const char* position = begin; position <= end; ++position) {
+        if (!matched) {
+            add_thread(state.current, 0, position, position);     // Lowest priority: starts further right
+        }
+        if (state.current.empty()) {
+            if (matched) {
+                break;
+            }
+            next_generation();      // The next start gets a fresh list
+            continue;
+        }
+
+        next_generation();
+        state.next.clear();
+        uint8_t c = position < end ? static_cast<uint8_t>(*position) : 0;
+        uint8_t folded = ignore_case_ ? ToLower(c) : c;
+        for (const VmThread& thread : state.current) {
+            const Instruction& instruction = program_[thread.pc];
+            bool advance = false;
+            switch (instruction.op) {
+            case OP_BYTE:
+                advance = position < end && folded == instruction.byte;
+                break;
+            case OP_ANY:
+                advance = position < end;
+                break;
+            case OP_CLASS:
+                advance = position < end && classes_[instruction.x].test(c);
+                break;
+            case OP_MATCH:
+                matched = true;
+                match = thread.start;
+                break;
+            default:
+                break;
+            }
+            if (instruction.op == OP_MATCH) {
+                break;          // Lower-priority threads lose
+            }
+            if (advance) {
+                add_thread(state.next, thread.pc + 1, thread.start, position + 1);
+            }
+        }
+        state.current.swap(state.next);
+    }
+    return matched;
+}
+
+bool SearchPattern::FindLine(const char* from, const char* end, const char*& line_begin, const char*& line_end,
+                             const char*& match) const {
+    const char* cursor = from;
+    while (cursor < end) {
+        const char* hit = cursor;
+        if (!literal_.empty()) {
+            hit = FindLiteral(cursor, end);
+            if (!hit) {
+                return false;
+            }
+        }
+        line_begin = hit;
+        while (line_begin > cursor && line_begin[-1] != '\n') {
+            --line_begin;
+        }
+        line_end = static_cast<const char*>(std::memchr(hit, '\n', end - hit));
+        if (!line_end) {
+            line_end = end;
+        }
+
+        if (!regex_) {
+            match = hit;
+            return true;
+        }
+        // CRLF files: '$' goes before the '\r'
+        const char* content_end = line_end > line_begin && line_end[-1] == '\r' ? line_end - 1 : line_end;
+        if (MatchLine(line_begin, content_end, match)) {
+            return true;
+        }
+        cursor = line_end + 1;
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compiled find-in-files pattern, matched one line at a time.
+//
+// Literals are found with an SSE2 scan that compares the first and last byte
+// of the needle at 16 positions at once and only verifies where both hit.
+// Regular expressions run on a small Pike VM (linear in the line length, no
+// backtracking blow-ups, no exceptions) behind the same scan for the longest
+// literal every match must contain, so most lines never reach the VM.
+//
+// Matching is bytewise: case folding covers ASCII, and '.' and classes match
+// one byte, never a newline. Regex syntax: '.', [...] and [^...] with ranges,
+// \d \w \s \D \W \S, \b \B, ^ $, (...) and (?:...), '|', and greedy or lazy
+// * + ? {m} {m,} {m,n}; any other escaped character is literal.
+class SearchPattern {
+public:
+    // Null with |error| set for an invalid pattern
+    static std::shared_ptr<const SearchPattern> Compile(std::string_view pattern, bool regex, bool ignore_case,
+                                                        std::string& error);
+
+    // First line at or after |from| (a line start in [begin, end)) with a
+    // match. |line_end| excludes the newline; |match| is where it starts.
+    bool FindLine(const char* from, const char* end, const char*& line_begin, const char*& line_end,
+                  const char*& match) const;
+
+    // Bytes every match contains, folded when ignoring case; may be empty
+    const std::string& GetRequiredLiteral() const { return literal_; }
+
+private:
+    enum Op : uint8_t {
+        OP_BYTE,
+        OP_ANY,
+        OP_CLASS,
+        OP_SPLIT,           // Continue at x, then y
+        OP_JUMP,
+        OP_LINE_BEGIN,
+        OP_LINE_END,
+        OP_WORD_BOUNDARY,
+        OP_NOT_WORD_BOUNDARY,
+        OP_MATCH
+    };
+
+    struct Instruction {
+        Op op;
+        uint8_t byte;
+        uint32_t x;         // OP_SPLIT, OP_JUMP; class index for OP_CLASS
+        uint32_t y;
+    };
+
+    friend class RegexCompiler;
+
+    SearchPattern() : regex_(false), ignore_case_(false) {}
+
+    const char* FindLiteral(const char* begin, const char* end) const;
+    bool Verify(const char* at) const;
+    bool MatchLine(const char* begin, const char* end, const char*& match) const;
+
+    bool regex_;
+    bool ignore_case_;
+    std::string literal_;               // Folded when ignoring case; empty: every line goes to the VM
+    std::vector<Instruction> program_;
+    std::vector<std::bitset<256>> classes_;
+};
@@ -0,0 +1,216 @@
+#include "settings.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+    const char* const kLogLevels[] = { "verbose", "info", "error" };
+    const char* const kCefLogSeverities[] = { "default", "verbose", "info", "warning", "error", "fatal", "disable" };
+    const int kCefLogSeverityValues[] = { LOGSEVERITY_DEFAULT, LOGSEVERITY_VERBOSE, LOGSEVERITY_INFO,
+                                          LOGSEVERITY_WARNING, LOGSEVERITY_ERROR, LOGSEVERITY_FATAL,
+                                          LOGSEVERITY_DISABLE };
+    const char* const kWindowModes[] = { "windowed", "borderless" };
+    const char* const kMessageLoops[] = { "external", "cef" };
+    const char* const kGpuModes[] = { "auto", "disabled", "software-compositing" };
+    const char* const kProcessModels[] = { "shared", "per-window" };
+    const char* const kBools[] = { "false", "true", "0", "1", "no", "yes", "off", "on" };
+
+    const int kMaxMegabytes = 1024 * 1024;
+
+    std::string_view Trim(std::string_view text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            return std::string_view();
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    std::string JoinChoices(const char* const* choices, int count) {
+        std::string joined;
+        for (int i = 0; i < count; ++i) {
+            joined += (i == 0 ? "" : i == count - 1 ? " or " : ", ");
+            joined += choices[i];
+        }
+        return joined;
+    }
+}
+
+Settings::Settings()
+    : indexed_(false), config_() {
+}
+
+Settings::~Settings() {
+}
+
+Settings& Settings::GetInstance() {
+    static Settings instance;
+    return instance;
+}
+
+// Splits the mapped file into key/value views; nothing is copied
+void Settings::IndexFile() {
+    indexed_ = true;
+    std::string_view text = file_.GetView();
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = Trim(text.substr(0, end));
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            Logger::LogError("Settings: Ignoring line without '=' in " + path_ + ": " + std::string(line));
+            continue;
+        }
+        std::string_view key = Trim(line.substr(0, equals));
+        std::string_view value = Trim(line.substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        entries_.emplace_back(key, value);
+    }
+}
+
+bool Settings::GetValue(std::string_view key, std::string& value) {
+    std::string name(key);
+    if (command_line_ && command_line_->HasSwitch(name)) {
+        value = command_line_->GetSwitchValue(name).ToString();
+        return true;
+    }
+
+    if (!indexed_) {
+        IndexFile();
+    }
+    // The last assignment in the file wins
+    for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+        if (it->first == key) {
+            value.assign(it->second.data(), it->second.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+void Settings::LogInvalid(const char* key, const std::string& value, const std::string& expected) {
+    Logger::LogError("Settings: Invalid " + std::string(key) + " '" + value + "', expected " + expected +
+                     "; using the default");
+}
+
+int Settings::GetInt(const char* key, int default_value, int min_value, int max_value) {
+    std::string value;
+    if (!GetValue(key, value)) {
+        return default_value;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno == ERANGE || parsed < min_value || parsed > max_value) {
+        LogInvalid(key, value, "an integer from " + std::to_string(min_value) + " to " + std::to_string(max_value));
+        return default_value;
+    }
+    return static_cast<int>(parsed);
+}
+
+// A bare --switch on the command line means true
+bool Settings::GetBool(const char* key, bool default_value) {
+    std::string value;
+    if (!GetValue(key, value)) {
+        return default_value;
+    }
+    if (value.empty()) {
+        return true;
+    }
+    const int count = sizeof(kBools) / sizeof(kBools[0]);
+    for (int i = 0; i < count; ++i) {
+        if (value == kBools[i]) {
+            return (i % 2) == 1;
+        }
+    }
+    LogInvalid(key, value, "true or false");
+    return default_value;
+}
+
+// Index of the value in |choices|
+int Settings::GetChoice(const char* key, int default_value, const char* const* choices, int count) {
+    std::string value;
+    if (!GetValue(key, value)) {
+        return default_value;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (value == choices[i]) {
+            return i;
+        }
+    }
+    LogInvalid(key, value, JoinChoices(choices, count));
+    return default_value;
+}
+
+void Settings::Load(const std::string& path, CefRefPtr<CefCommandLine> command_line) {
+    path_ = path;
+    command_line_ = command_line;
+    entries_.clear();
+    indexed_ = false;
+    if (file_.Open(path)) {
+        Logger::LogMessage("Settings: Using " + path + " (" + std::to_string(file_.GetSize()) + " bytes)");
+    } else {
+        Logger::LogMessage("Settings: No settings file at " + path + ", using defaults");
+    }
+
+    RuntimeConfig& config = config_;
+    const int severity_count = sizeof(kCefLogSeverities) / sizeof(kCefLogSeverities[0]);
+
+    config.log_level = GetChoice("log-level", LOG_LEVEL, kLogLevels, 3);
+    config.cef_log_severity = kCefLogSeverityValues[GetChoice("cef-log-severity", severity_count - 1,
+                                                              kCefLogSeverities, severity_count)];
+
+    config.window_width = GetInt("window-width", DEFAULT_WINDOW_WIDTH, MIN_WINDOW_WIDTH, 16384);
+    config.window_height = GetInt("window-height", DEFAULT_WINDOW_HEIGHT, MIN_WINDOW_HEIGHT, 16384);
+    config.borderless = GetChoice("window-mode", 1, kWindowModes, 2) == 1;
+    config.splash_delay_ms = GetInt("splash-delay", 500, -1, 60000);
+    config.wait_for_app_ready = GetBool("wait-for-app-ready", false);
+
+    config.message_loop = static_cast<RuntimeConfig::MessageLoop>(GetChoice("message-loop", 0, kMessageLoops, 2));
+    config.gpu = static_cast<RuntimeConfig::Gpu>(GetChoice("gpu", 0, kGpuModes, 3));
+    config.process_model = static_cast<RuntimeConfig::ProcessModel>(GetChoice("process-model", 0, kProcessModels, 2));
+    config.max_renderers = GetInt("max-renderers", 0, 0, 256);
+    config.disk_cache_size_mb = GetInt("disk-cache-size-mb", 0, 0, kMaxMegabytes);
+    config.remote_debugging_port = GetInt("remote-debugging-port", -1, -1, 65535);
+    config.startup_cache = GetBool("startup-cache", !AppConfig::IsDebugMode()) &&
+                           !(command_line && command_line->HasSwitch("disable-startup-cache"));
+    config.local_storage = GetBool("local-storage", true);
+    config.javascript_clipboard = GetBool("javascript-clipboard", false);
+
+    // CEF wants an absolute cache path; relative ones are taken from the working directory
+    std::string cache_path;
+    std::filesystem::path cache_dir = std::filesystem::current_path() / "cache";
+    if (GetValue("cache-path", cache_path) && !cache_path.empty()) {
+        cache_dir = std::filesystem::absolute(std::filesystem::u8path(cache_path));
+    }
+    config.cache_path = cache_dir.u8string();
+
+    config.worker_threads = GetInt("worker-threads", 0, 0, 256);
+    config.browser_pool_size = GetInt("browser-pool-size", 1, 0, 16);
+    config.browser_pool_memory_cap_mb = GetInt("browser-pool-memory-cap", 512, 0, kMaxMegabytes);
+    config.window_memory_budget_mb = GetInt("window-memory-budget", 512, 0, kMaxMegabytes);
+    config.memory_threshold_mb = GetInt("memory-threshold", 2048, 0, kMaxMegabytes);
+    config.freeze_hidden_after_s = GetInt("freeze-hidden-after", 60, 0, 24 * 3600);
+    config.watch_limit = GetInt("watch-limit", 0, 0, 64 * 1024 * 1024);
+    config.watch_debounce_ms = GetInt("watch-debounce", 100, 10, 10000);
+#ifdef __linux__
+    config.search_index = GetBool("search-index", true);
+#else
+    // Only the FileWatcher keeps the tree, and so the index, current (Linux)
+    config.search_index = GetBool("search-index", false);
+#endif
+
+    // Everything above is resolved now; the command line and the mapping are not needed anymore
+    command_line_ = nullptr;
+    entries_.clear();
+    file_.Close();
+}
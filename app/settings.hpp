@@ -0,0 +1,103 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "include/cef_command_line.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Deployment knobs, resolved and validated once at startup
+struct RuntimeConfig {
+    enum MessageLoop {
+        MESSAGE_LOOP_EXTERNAL,      // MessagePump drives CEF (default)
+        MESSAGE_LOOP_CEF            // CefRunMessageLoop()
+    };
+    enum Gpu {
+        GPU_AUTO,
+        GPU_DISABLED,               // --disable-gpu
+        GPU_SOFTWARE_COMPOSITING    // --disable-gpu-compositing
+    };
+    enum ProcessModel {
+        PROCESS_MODEL_SHARED,       // --process-per-site: one renderer for all windows (default)
+        PROCESS_MODEL_PER_WINDOW    // Chromium's default, one renderer per window
+    };
+
+    // Logging
+    int log_level;                  // Logger::Level
+    int cef_log_severity;           // cef_log_severity_t
+
+    // Window
+    int window_width;
+    int window_height;
+    bool borderless;
+    int splash_delay_ms;            // Negative disables the splash
+    bool wait_for_app_ready;
+
+    // Engine
+    MessageLoop message_loop;
+    Gpu gpu;
+    ProcessModel process_model;
+    int max_renderers;              // 0 leaves Chromium's limit
+    std::string cache_path;
+    int disk_cache_size_mb;         // 0 leaves Chromium's default
+    int remote_debugging_port;      // -1 disables
+    bool startup_cache;
+    bool local_storage;
+    bool javascript_clipboard;
+
+    // Pools and budgets (0 disables, except worker_threads: 0 = one per core)
+    int worker_threads;
+    int browser_pool_size;
+    int browser_pool_memory_cap_mb;
+    int window_memory_budget_mb;
+    int memory_threshold_mb;
+    int freeze_hidden_after_s;
+
+    // Workspace
+    int watch_limit;                // inotify watches; 0 = 90% of fs.inotify.max_user_watches
+    int watch_debounce_ms;
+    bool search_index;              // Trigram index of file contents under cache_path (default on Linux only)
+};
+
+// Runtime settings file.
+//
+// One "key = value" per line, '#' starts a comment; keys are the command-line
+// switch names, so --window-width=1600 overrides "window-width = 1400" in the
+// file, which overrides the built-in default. The file is memory-mapped and
+// only split into lines on the first lookup that the command line does not
+// answer. Load() validates everything up front; invalid values are logged and
+// replaced by their default, so the rest of the app reads GetConfig() as is.
+class Settings {
+public:
+    static constexpr const char* kDefaultPath = "swipeide.conf";
+
+    // Singleton access
+    static Settings& GetInstance();
+
+    // Main thread, before CefInitialize(). A missing file means defaults.
+    void Load(const std::string& path, CefRefPtr<CefCommandLine> command_line);
+
+    const RuntimeConfig& GetConfig() const { return config_; }
+
+private:
+    Settings();
+    ~Settings();
+    Settings(const Settings&);
+    Settings& operator=(const Settings&);
+
+    void IndexFile();
+    // Raw value of |key|, command line first
+    bool GetValue(std::string_view key, std::string& value);
+    int GetInt(const char* key, int default_value, int min_value, int max_value);
+    bool GetBool(const char* key, bool default_value);
+    int GetChoice(const char* key, int default_value, const char* const* choices, int count);
+    void LogInvalid(const char* key, const std::string& value, const std::string& expected);
+
+    MappedFile file_;
+    std::string path_;
+    bool indexed_;
+    std::vector<std::pair<std::string_view, std::string_view>> entries_;   // Views into file_
+    CefRefPtr<CefCommandLine> command_line_;
+    RuntimeConfig config_;
+};
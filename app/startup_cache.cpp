@@ -0,0 +1,193 @@
+#include "startup_cache.hpp"
+#include "webapp.hpp"
+#include "logger.hpp"
+#include "include/cef_task.h"
+#include <brotli/decode.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace StartupCache {
+
+    static const char* kProfileExtension = ".profile";
+
+    // Profile file for the embedded bundle (set once by Initialize)
+    static std::filesystem::path g_profilePath;
+    static bool g_warm = false;
+
+    // Rewritten entry document; built before the browser exists, read-only afterwards
+    static std::string g_warmIndexHtml;
+    static ResourceUtil::PreloadedResource g_warmIndex;
+
+    // Scripts requested while recording (IO thread writes, file thread reads)
+    static std::atomic<bool> g_recording(false);
+    static std::mutex g_recordMutex;
+    static std::vector<std::string> g_recorded;
+
+    static bool IsScriptChunk(const std::string& path) {
+        return path.compare(0, 8, "/assets/") == 0 &&
+               path.size() > 3 && path.compare(path.size() - 3, 3, ".js") == 0;
+    }
+
+    static bool DecodeResource(const ResourceUtil::PreloadedResource& resource, std::string& out) {
+        out.resize(resource.originalSize);
+        if (resource.encoding == ResourceUtil::ENCODING_IDENTITY) {
+            std::copy(resource.data.data, resource.data.data + resource.data.size, out.begin());
+            return true;
+        }
+
+        size_t decoded_size = out.size();
+        BrotliDecoderResult result = BrotliDecoderDecompress(
+            resource.data.size, resource.data.data, &decoded_size,
+            reinterpret_cast<uint8_t*>(&out[0]));
+        return result == BROTLI_DECODER_RESULT_SUCCESS && decoded_size == out.size();
+    }
+
+    static void BuildWarmIndex(const ResourceUtil::ResourceBundle* bundle,
+                               const std::vector<std::string>& scripts) {
+        const ResourceUtil::PreloadedResource* index = bundle->Find("/index.html");
+        std::string html;
+        if (!index || !DecodeResource(*index, html)) {
+            return;
+        }
+
+        size_t head_end = html.find("</head>");
+        if (head_end == std::string::npos) {
+            return;
+        }
+
+        // Vite already preloads static imports; only add what it does not reference
+        std::string links;
+        for (const std::string& script : scripts) {
+            if (bundle->Find(script) && html.find("\"" + script + "\"") == std::string::npos) {
+                links += "<link rel=\"modulepreload\" crossorigin href=\"" + script + "\">\n";
+            }
+        }
+        if (links.empty()) {
+            return;
+        }
+
+        g_warmIndexHtml = html.insert(head_end, links);
+        g_warmIndex = *index;
+        g_warmIndex.data = ResourceUtil::ResourceSpan(
+            reinterpret_cast<const uint8_t*>(g_warmIndexHtml.data()), g_warmIndexHtml.size());
+        g_warmIndex.originalSize = g_warmIndexHtml.size();
+        g_warmIndex.encoding = ResourceUtil::ENCODING_IDENTITY;
+        // Distinct validator so a cached plain index.html is never reused for it
+        if (g_warmIndex.etag.size() > 1) {
+            g_warmIndex.etag.insert(g_warmIndex.etag.size() - 1, "-warm");
+        }
+    }
+
+    void Initialize(const std::string& cache_path) {
+        const ResourceUtil::ResourceBundle* bundle = ResourceUtil::GetResourceBundle();
+        if (!bundle || !bundle->embedded) {
+            return;
+        }
+
+        std::error_code ec;
+        std::filesystem::path directory = std::filesystem::path(cache_path) / "startup";
+        std::filesystem::create_directories(directory, ec);
+        g_profilePath = directory / (std::string(GetWebAppBundleHash()) + kProfileExtension);
+
+        // Profiles recorded for previous bundles can never match again
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() == kProfileExtension && it->path() != g_profilePath) {
+                std::filesystem::remove(it->path(), ec);
+            }
+        }
+
+        std::ifstream file(g_profilePath);
+        if (!file) {
+            Logger::LogMessage("StartupCache: No profile for bundle " + std::string(GetWebAppBundleHash()) + ", recording");
+            g_recording.store(true);
+            return;
+        }
+
+        std::vector<std::string> scripts;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (IsScriptChunk(line)) {
+                scripts.push_back(line);
+            }
+        }
+
+        g_warm = true;
+        BuildWarmIndex(bundle, scripts);
+        Logger::LogMessage("StartupCache: Loaded profile with " + std::to_string(scripts.size()) +
+                           " startup chunks" + (g_warmIndexHtml.empty() ? "" : " (preloading)"));
+    }
+
+    void NoteRequest(const std::string& path) {
+        if (!g_recording.load(std::memory_order_relaxed) || !IsScriptChunk(path)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(g_recordMutex);
+        if (std::find(g_recorded.begin(), g_recorded.end(), path) == g_recorded.end()) {
+            g_recorded.push_back(path);
+        }
+    }
+
+    static void FinishRecording() {
+        if (!g_recording.exchange(false)) {
+            return;
+        }
+
+        std::vector<std::string> scripts;
+        {
+            std::lock_guard<std::mutex> lock(g_recordMutex);
+            scripts.swap(g_recorded);
+        }
+
+        // Write to a temporary file first so a crash never leaves a partial profile
+        std::filesystem::path temp_path = g_profilePath;
+        temp_path += ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::trunc);
+            for (const std::string& script : scripts) {
+                file << script << '\n';
+            }
+            if (!file) {
+                Logger::LogError("StartupCache: Failed to write profile");
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp_path, g_profilePath, ec);
+        if (ec) {
+            Logger::LogError("StartupCache: Failed to store profile: " + ec.message());
+            return;
+        }
+        Logger::LogMessage("StartupCache: Recorded " + std::to_string(scripts.size()) + " startup chunks");
+    }
+
+    class FinishRecordingTask : public CefTask {
+    public:
+        void Execute() override {
+            FinishRecording();
+        }
+
+    private:
+        IMPLEMENT_REFCOUNTING(FinishRecordingTask);
+    };
+
+    void ScheduleFinishRecording(int delay_ms) {
+        if (!g_recording.load()) {
+            return;
+        }
+        CefPostDelayedTask(TID_FILE_BACKGROUND, new FinishRecordingTask(), delay_ms);
+    }
+
+    const ResourceUtil::PreloadedResource* GetWarmIndex() {
+        return g_warmIndexHtml.empty() ? nullptr : &g_warmIndex;
+    }
+
+    bool IsWarm() {
+        return g_warm;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include "resourceutil.hpp"
+
+// Startup warm-up for the embedded bundle.
+//
+// The first launch of a bundle records which lazily imported chunks the page
+// fetches while starting up, and stores that profile under cache_path keyed by
+// the bundle hash. Later launches of the same bundle serve an index.html that
+// declares those chunks as modulepreload, so they are fetched and compiled in
+// parallel with the entry chunk instead of one dynamic import at a time.
+namespace StartupCache {
+    // Load (or start recording) the profile for the embedded bundle.
+    // Call once before the browser is created; profiles of other bundles are removed.
+    void Initialize(const std::string& cache_path);
+
+    // IO thread: note a resource served while the profile is being recorded
+    void NoteRequest(const std::string& path);
+
+    // Stop recording after |delay_ms| and persist the profile on the file thread
+    void ScheduleFinishRecording(int delay_ms);
+
+    // Entry document with the recorded modulepreload hints, nullptr if there is none
+    const ResourceUtil::PreloadedResource* GetWarmIndex();
+
+    // Whether a profile for the current bundle was found at startup
+    bool IsWarm();
+}
@@ -0,0 +1,259 @@
+#include "startup_trace.hpp"
+#include "logger.hpp"
+#include "include/cef_task.h"
+#include "include/cef_trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__APPLE__)
+    #include <pthread.h>
+    #include <unistd.h>
+#else
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace StartupTrace {
+
+    struct TraceEvent {
+        std::string name;
+        char phase;             // 'X' complete, 'i' instant
+        long long ts_us;
+        long long dur_us;
+        unsigned long long tid;
+    };
+
+    // Same clock as base::TimeTicks, so timestamps line up with CEF's trace
+    static long long NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // OS thread IDs, as used for Chromium's thread tracks
+    static unsigned long long CurrentThreadId() {
+#ifdef _WIN32
+        return GetCurrentThreadId();
+#elif defined(__APPLE__)
+        uint64_t tid = 0;
+        pthread_threadid_np(nullptr, &tid);
+        return tid;
+#else
+        return static_cast<unsigned long long>(syscall(SYS_gettid));
+#endif
+    }
+
+    static unsigned long long CurrentProcessId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<unsigned long long>(getpid());
+#endif
+    }
+
+    // Static initialization is the earliest point we control in the process
+    static const long long g_processStartUs = NowUs();
+    static const unsigned long long g_mainThreadId = CurrentThreadId();
+
+    static const char kDefaultOutputPath[] = "startup_trace.json";
+
+    static std::mutex g_mutex;
+    static std::vector<TraceEvent> g_events;
+
+    // Set by Initialize(); cleared when the trace is written
+    static std::atomic<bool> g_recording(false);
+    static std::string g_outputPath;
+
+    // Set by Start() on the UI thread
+    static bool g_started = false;
+    static bool g_includeCef = false;
+
+    static void Record(const std::string& name, char phase, long long ts_us, long long dur_us) {
+        if (!g_recording.load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_events.push_back({ name, phase, ts_us, dur_us, CurrentThreadId() });
+    }
+
+    void Initialize(int argc, char* argv[]) {
+        const char* path = std::getenv("SWIPEIDE_STARTUP_TRACE");
+        bool enabled = path != nullptr;
+        const char kSwitch[] = "--startup-trace";
+        const size_t kSwitchLength = sizeof(kSwitch) - 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strncmp(argv[i], kSwitch, kSwitchLength) != 0) {
+                continue;
+            }
+            if (argv[i][kSwitchLength] == '\0') {
+                enabled = true;
+            } else if (argv[i][kSwitchLength] == '=') {
+                enabled = true;
+                path = argv[i] + kSwitchLength + 1;
+            }
+        }
+        g_outputPath = path && *path ? path : kDefaultOutputPath;
+        g_recording.store(enabled);
+    }
+
+    bool IsEnabled() {
+        return g_recording.load(std::memory_order_relaxed);
+    }
+
+    void Mark(const std::string& name) {
+        Record(name, 'i', NowUs(), 0);
+    }
+
+    ScopedPhase::ScopedPhase(const char* name) : name_(name), start_us_(NowUs()) {
+    }
+
+    ScopedPhase::~ScopedPhase() {
+        Record(name_, 'X', start_us_, NowUs() - start_us_);
+    }
+
+    double GetElapsedMs() {
+        return (NowUs() - g_processStartUs) / 1000.0;
+    }
+
+    static std::string EscapeJson(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Our events as a comma-separated list of trace-event objects
+    static std::string SerializeEvents() {
+        std::vector<TraceEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            events = g_events;
+        }
+
+        unsigned long long pid = CurrentProcessId();
+        std::ostringstream out;
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << g_mainThreadId << ",\"args\":{\"name\":\"Browser\"}},\n";
+        out << "{\"name\":\"ProcessStart\",\"cat\":\"startup\",\"ph\":\"i\",\"s\":\"p\",\"pid\":" << pid
+            << ",\"tid\":" << g_mainThreadId << ",\"ts\":" << g_processStartUs << "}";
+        for (const TraceEvent& event : events) {
+            out << ",\n{\"name\":\"" << EscapeJson(event.name) << "\",\"cat\":\"startup\",\"ph\":\""
+                << event.phase << "\",\"pid\":" << pid << ",\"tid\":" << event.tid
+                << ",\"ts\":" << event.ts_us;
+            if (event.phase == 'X') {
+                out << ",\"dur\":" << event.dur_us;
+            } else {
+                out << ",\"s\":\"t\"";
+            }
+            out << "}";
+        }
+        return out.str();
+    }
+
+    // File thread: write our events, spliced into CEF's trace when there is one
+    static void WriteTrace(const std::string& cef_trace_path) {
+        std::string events = SerializeEvents();
+        std::string trace;
+        if (!cef_trace_path.empty()) {
+            std::ifstream cef_file(cef_trace_path, std::ios::binary);
+            std::stringstream buffer;
+            buffer << cef_file.rdbuf();
+            trace = buffer.str();
+            cef_file.close();
+            std::remove(cef_trace_path.c_str());
+
+            size_t key = trace.find("\"traceEvents\"");
+            size_t array = key == std::string::npos ? key : trace.find('[', key);
+            if (array != std::string::npos) {
+                size_t next = trace.find_first_not_of(" \t\r\n", array + 1);
+                bool empty = next != std::string::npos && trace[next] == ']';
+                trace.insert(array + 1, "\n" + events + (empty ? "\n" : ",\n"));
+            } else {
+                Logger::LogError("StartupTrace: Unexpected CEF trace format, writing startup events only");
+                trace.clear();
+            }
+        }
+        if (trace.empty()) {
+            trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" + events + "\n]}\n";
+        }
+
+        std::ofstream file(g_outputPath, std::ios::binary | std::ios::trunc);
+        file << trace;
+        if (!file) {
+            Logger::LogError("StartupTrace: Failed to write " + g_outputPath);
+            return;
+        }
+        Logger::LogMessage("StartupTrace: Trace written to " + g_outputPath);
+    }
+
+    class WriteTraceTask : public CefTask {
+    public:
+        explicit WriteTraceTask(const std::string& cef_trace_path) : cef_trace_path_(cef_trace_path) {}
+        void Execute() override { WriteTrace(cef_trace_path_); }
+
+    private:
+        std::string cef_trace_path_;
+        IMPLEMENT_REFCOUNTING(WriteTraceTask);
+    };
+
+    class EndTracingCallback : public CefEndTracingCallback {
+    public:
+        void OnEndTracingComplete(const CefString& tracing_file) override {
+            CefPostTask(TID_FILE_BACKGROUND, new WriteTraceTask(tracing_file.ToString()));
+        }
+
+    private:
+        IMPLEMENT_REFCOUNTING(EndTracingCallback);
+    };
+
+    static void Finish() {
+        if (!g_started || !g_recording.load()) {
+            return;
+        }
+        Mark("TraceEnd");
+        g_recording.store(false);
+
+        if (g_includeCef && CefEndTracing(g_outputPath + ".cef.json", new EndTracingCallback())) {
+            return;
+        }
+        CefPostTask(TID_FILE_BACKGROUND, new WriteTraceTask(std::string()));
+    }
+
+    class FinishTask : public CefTask {
+    public:
+        void Execute() override { Finish(); }
+
+    private:
+        IMPLEMENT_REFCOUNTING(FinishTask);
+    };
+
+    void Start(bool include_cef) {
+        if (!g_recording.load()) {
+            return;
+        }
+        g_started = true;
+        // Default categories; the callback is optional
+        g_includeCef = include_cef && CefBeginTracing("", nullptr);
+        Logger::LogMessage("StartupTrace: Recording to " + g_outputPath +
+                           (g_includeCef ? " (with CEF tracing)" : ""));
+    }
+
+    void ScheduleFinish(int delay_ms) {
+        if (!g_started) {
+            return;
+        }
+        CefPostDelayedTask(TID_UI, new FinishTask(), delay_ms);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+
+// Startup timeline tracer.
+//
+// Records monotonic timestamps for the startup phases (process start,
+// CefExecuteProcess, CefInitialize, resource preload, CreateBrowserView, page
+// load, window show) and exports them as Chrome trace-event JSON, which opens
+// in Perfetto or chrome://tracing. Whether to record is decided once, before
+// the first phase, from --startup-trace[=file] or the SWIPEIDE_STARTUP_TRACE
+// environment variable (its value is the file); otherwise, and after the trace
+// is written, marks and phases record nothing.
+//
+// Timestamps are taken from the same monotonic clock Chromium uses, so with
+// |include_cef| the events are merged into CEF's own trace (CefBeginTracing)
+// on the browser main thread's track.
+namespace StartupTrace {
+    // First thing in main(), before any mark or phase
+    void Initialize(int argc, char* argv[]);
+
+    bool IsEnabled();
+
+    // Instant event
+    void Mark(const std::string& name);
+
+    // Duration event covering the lifetime of the object
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(const char* name);
+        ~ScopedPhase();
+
+    private:
+        ScopedPhase(const ScopedPhase&);
+        ScopedPhase& operator=(const ScopedPhase&);
+
+        const char* name_;
+        long long start_us_;
+    };
+
+    // UI thread, after CefInitialize, when enabled: write the trace when the
+    // startup finishes, optionally together with CEF's own tracing
+    void Start(bool include_cef);
+
+    // UI thread: stop recording |delay_ms| from now and write the trace
+    void ScheduleFinish(int delay_ms);
+
+    // Milliseconds since the process started (for log lines)
+    double GetElapsedMs();
+}
@@ -0,0 +1,944 @@
+#include "trigram_index.hpp"
+#include "file_watcher.hpp"
+#include "logger.hpp"
+#include "mapped_file.hpp"
+#include "resourcehash.hpp"
+#include "workspace_index.hpp"
+#include "workspace_search.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define TRIGRAM_INDEX_SSE2 1
+#endif
+
+namespace {
+    const char kIndexDirectory[] = "search";
+    const char kIndexExtension[] = ".trigrams";
+    const uint32_t kMagic = 0x4D475254;         // "TRGM"
+    const uint32_t kVersion = 1;
+    const uint32_t kNoDocument = 0xFFFFFFFFu;
+    const size_t kGallopRatio = 32;             // Length ratio from which looking up beats merging
+    const size_t kVerifyRatio = 64;             // Reading that many more files beats decoding a list
+
+    // File layout. Offsets count from the start of the file and are 8-byte aligned.
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t document_count;
+        uint32_t trigram_count;
+        uint32_t root_length;                   // Workspace root, first in the paths
+        uint32_t reserved;
+        uint64_t documents_offset;              // DocumentEntry[document_count]
+        uint64_t order_offset;                  // uint32_t[document_count]: documents sorted by path
+        uint64_t trigrams_offset;               // TrigramEntry[trigram_count], sorted by trigram
+        uint64_t postings_offset;
+        uint64_t paths_offset;
+        uint64_t file_size;
+    };
+
+    struct DocumentEntry {
+        uint64_t size;                          // As in the tree when the file was read
+        int64_t modified;
+        uint32_t path_offset;                   // From paths_offset
+        uint32_t path_length;
+    };
+
+    struct TrigramEntry {
+        uint32_t trigram;
+        uint32_t count;                         // Documents in the list
+        uint64_t offset;                        // From postings_offset; a list ends where the next begins
+    };
+
+    // Document of an index file being written
+    struct DocumentInfo {
+        std::string path;
+        uint64_t size;
+        int64_t modified;
+    };
+
+    // Ascending document numbers, each stored as a varint of the gap to the previous one
+    struct PostingList {
+        std::string bytes;
+        uint32_t count = 0;
+        uint32_t last = 0;
+
+        void Append(uint32_t document) {
+            uint32_t delta = document - last;
+            last = document;
+            ++count;
+            while (delta >= 0x80) {
+                bytes.push_back(static_cast<char>(delta | 0x80));
+                delta >>= 7;
+            }
+            bytes.push_back(static_cast<char>(delta));
+        }
+    };
+
+    inline uint8_t ToLower(uint8_t c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<uint8_t>(c + ('a' - 'A')) : c;
+    }
+
+    inline uint64_t Align8(uint64_t value) {
+        return (value + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    inline bool IsIndexed(const WorkspaceTree& tree, uint32_t node) {
+        return !(tree.GetFlags(node) & (WorkspaceTree::FLAG_DIRECTORY | WorkspaceTree::FLAG_SYMLINK));
+    }
+
+    // One bit per trigram (2 MiB per worker), set while a file is extracted
+    std::vector<uint64_t>& SeenTrigrams() {
+        thread_local std::vector<uint64_t> seen(static_cast<size_t>(1) << 18);
+        return seen;
+    }
+
+    // Appends the trigrams of |data| not in |trigrams| yet, folded, none across
+    // a newline (matches never span lines); call once per chunk of whole lines
+    void AddTrigrams(const char* data, size_t size, std::vector<uint32_t>& trigrams) {
+        std::vector<uint64_t>& seen = SeenTrigrams();
+        uint32_t trigram = 0;
+        size_t run = 0;
+        for (size_t i = 0; i < size; ++i) {
+            uint8_t c = static_cast<uint8_t>(data[i]);
+            if (c == '\n') {
+                run = 0;
+                continue;
+            }
+            trigram = ((trigram << 8) | ToLower(c)) & 0xFFFFFF;
+            if (++run >= 3) {
+                uint64_t& word = seen[trigram >> 6];
+                uint64_t bit = static_cast<uint64_t>(1) << (trigram & 63);
+                if (!(word & bit)) {
+                    word |= bit;
+                    trigrams.push_back(trigram);
+                }
+            }
+        }
+    }
+
+    // Sorts the trigrams of a whole file and clears the bitmap for the next one
+    void FinishTrigrams(std::vector<uint32_t>& trigrams) {
+        std::vector<uint64_t>& seen = SeenTrigrams();
+        for (uint32_t found : trigrams) {
+            seen[found >> 6] = 0;
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+    }
+
+    // Same as AddTrigrams for a short query literal, without the bitmap
+    void LiteralTrigrams(const std::string& literal, std::vector<uint32_t>& trigrams) {
+        trigrams.clear();
+        for (size_t i = 0; i + 3 <= literal.size(); ++i) {
+            if (std::memchr(literal.data() + i, '\n', 3)) {
+                continue;
+            }
+            trigrams.push_back(static_cast<uint32_t>(ToLower(static_cast<uint8_t>(literal[i]))) << 16 |
+                               static_cast<uint32_t>(ToLower(static_cast<uint8_t>(literal[i + 1]))) << 8 |
+                               ToLower(static_cast<uint8_t>(literal[i + 2])));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    // False for a damaged list: truncated, not strictly ascending, or naming a
+    // document at or past |document_count|
+    bool DecodePostings(const uint8_t* data, const uint8_t* end, uint32_t count, uint32_t document_count,
+                        std::vector<uint32_t>& documents) {
+        documents.clear();
+        documents.reserve(count);
+        uint32_t document = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t delta = 0;
+            for (int shift = 0;; shift += 7) {
+                if (data == end || shift > 28) {
+                    return false;
+                }
+                uint8_t byte = *data++;
+                delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+            if ((i > 0 && delta == 0) || delta >= document_count - document) {
+                return false;
+            }
+            document += delta;
+            documents.push_back(document);
+        }
+        return true;
+    }
+
+    // |out| = |a| ∩ |b|, all sorted without duplicates
+    void Intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out) {
+        out.clear();
+        const std::vector<uint32_t>& shorter = a.size() <= b.size() ? a : b;
+        const std::vector<uint32_t>& longer = a.size() <= b.size() ? b : a;
+        if (shorter.size() * kGallopRatio < longer.size()) {
+            auto from = longer.begin();
+            for (uint32_t value : shorter) {
+                from = std::lower_bound(from, longer.end(), value);
+                if (from == longer.end()) {
+                    break;
+                }
+                if (*from == value) {
+                    out.push_back(value);
+                }
+            }
+            return;
+        }
+
+        size_t i = 0;
+        size_t j = 0;
+#ifdef TRIGRAM_INDEX_SSE2
+        // Compare a block of four from each list in all four rotations, then
+        // move past the block whose last value is smaller (or both)
+        while (i + 4 <= a.size() && j + 4 <= b.size()) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + j));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(hits));
+            for (int k = 0; mask != 0; ++k, mask >>= 1) {
+                if (mask & 1) {
+                    out.push_back(a[i + k]);
+                }
+            }
+            uint32_t a_last = a[i + 3];
+            uint32_t b_last = b[j + 3];
+            if (a_last <= b_last) {
+                i += 4;
+            }
+            if (b_last <= a_last) {
+                j += 4;
+            }
+        }
+#endif
+        while (i < a.size() && j < b.size()) {
+            if (a[i] < b[j]) {
+                ++i;
+            } else if (b[j] < a[i]) {
+                ++j;
+            } else {
+                out.push_back(a[i]);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    // Write an index file at |path| through a temporary file, so a crash never leaves a partial one
+    bool WriteIndexFile(const std::filesystem::path& path, const std::string& root,
+                        const std::vector<DocumentInfo>& documents,
+                        const std::unordered_map<uint32_t, PostingList>& postings, uint64_t& file_size) {
+        std::vector<uint32_t> order(documents.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&documents](uint32_t a, uint32_t b) {
+            return documents[a].path < documents[b].path;
+        });
+        std::vector<uint32_t> trigrams;
+        trigrams.reserve(postings.size());
+        uint64_t postings_size = 0;
+        for (const auto& entry : postings) {
+            trigrams.push_back(entry.first);
+            postings_size += entry.second.bytes.size();
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        uint64_t paths_size = root.size();
+        for (const DocumentInfo& document : documents) {
+            paths_size += document.path.size();
+        }
+        if (paths_size > 0xFFFFFFFFu) {
+            return false;
+        }
+
+        FileHeader header = {};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.document_count = static_cast<uint32_t>(documents.size());
+        header.trigram_count = static_cast<uint32_t>(trigrams.size());
+        header.root_length = static_cast<uint32_t>(root.size());
+        header.documents_offset = Align8(sizeof(FileHeader));
+        header.order_offset = header.documents_offset + documents.size() * sizeof(DocumentEntry);
+        header.trigrams_offset = Align8(header.order_offset + documents.size() * sizeof(uint32_t));
+        header.postings_offset = header.trigrams_offset + trigrams.size() * sizeof(TrigramEntry);
+        header.paths_offset = Align8(header.postings_offset + postings_size);
+        header.file_size = header.paths_offset + paths_size;
+
+        std::filesystem::path temp_path = path;
+        temp_path += ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            uint64_t position = 0;
+            auto write = [&file, &position](const void* data, size_t size) {
+                file.write(static_cast<const char*>(data), size);
+                position += size;
+            };
+            auto pad = [&file, &position](uint64_t offset) {
+                static const char zeros[8] = {};
+                file.write(zeros, offset - position);
+                position = offset;
+            };
+
+            write(&header, sizeof(header));
+            pad(header.documents_offset);
+            uint32_t path_offset = header.root_length;
+            for (const DocumentInfo& document : documents) {
+                DocumentEntry entry = { document.size, document.modified, path_offset,
+                                        static_cast<uint32_t>(document.path.size()) };
+                write(&entry, sizeof(entry));
+                path_offset += entry.path_length;
+            }
+            write(order.data(), order.size() * sizeof(uint32_t));
+            pad(header.trigrams_offset);
+            uint64_t list_offset = 0;
+            for (uint32_t trigram : trigrams) {
+                const PostingList& list = postings.at(trigram);
+                TrigramEntry entry = { trigram, list.count, list_offset };
+                write(&entry, sizeof(entry));
+                list_offset += list.bytes.size();
+            }
+            for (uint32_t trigram : trigrams) {
+                const std::string& bytes = postings.at(trigram).bytes;
+                write(bytes.data(), bytes.size());
+            }
+            pad(header.paths_offset);
+            write(root.data(), root.size());
+            for (const DocumentInfo& document : documents) {
+                write(document.path.data(), document.path.size());
+            }
+            if (!file.flush()) {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        if (ec) {
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+        file_size = header.file_size;
+        return true;
+    }
+}
+
+// Index file mapped into memory; read-only once loaded
+struct TrigramIndex::Segment {
+    MappedFile file;
+    const FileHeader* header = nullptr;
+    const DocumentEntry* documents = nullptr;
+    const uint32_t* order = nullptr;
+    const TrigramEntry* trigrams = nullptr;
+    const uint8_t* postings = nullptr;
+    const uint8_t* postings_end = nullptr;
+    const char* paths = nullptr;
+
+    // Null if the file is missing, of another version or root, or damaged
+    static std::shared_ptr<Segment> Load(const std::string& path, const std::string& root) {
+        std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+        if (!segment->file.Open(path) || segment->file.GetSize() < sizeof(FileHeader)) {
+            return nullptr;
+        }
+        const char* data = segment->file.GetData();
+        const uint64_t size = segment->file.GetSize();
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+        auto fits = [size](uint64_t offset, uint64_t bytes) {
+            return offset <= size && bytes <= size - offset;
+        };
+        if (header->magic != kMagic || header->version != kVersion || header->file_size != size ||
+            header->documents_offset < sizeof(FileHeader) || header->documents_offset % 8 != 0 ||
+            header->trigrams_offset % 8 != 0 ||
+            !fits(header->documents_offset, static_cast<uint64_t>(header->document_count) * sizeof(DocumentEntry)) ||
+            header->order_offset != header->documents_offset + header->document_count * sizeof(DocumentEntry) ||
+            !fits(header->order_offset, static_cast<uint64_t>(header->document_count) * sizeof(uint32_t)) ||
+            header->trigrams_offset < header->order_offset + header->document_count * sizeof(uint32_t) ||
+            !fits(header->trigrams_offset, static_cast<uint64_t>(header->trigram_count) * sizeof(TrigramEntry)) ||
+            header->postings_offset != header->trigrams_offset + header->trigram_count * sizeof(TrigramEntry) ||
+            header->paths_offset < header->postings_offset || !fits(header->paths_offset, header->root_length) ||
+            std::string_view(data + header->paths_offset, header->root_length) != root) {
+            return nullptr;
+        }
+
+        segment->header = header;
+        segment->documents = reinterpret_cast<const DocumentEntry*>(data + header->documents_offset);
+        segment->order = reinterpret_cast<const uint32_t*>(data + header->order_offset);
+        segment->trigrams = reinterpret_cast<const TrigramEntry*>(data + header->trigrams_offset);
+        segment->postings = reinterpret_cast<const uint8_t*>(data + header->postings_offset);
+        segment->postings_end = reinterpret_cast<const uint8_t*>(data + header->paths_offset);
+        segment->paths = data + header->paths_offset;
+
+        // The tables are checked once here, so lookups need no bounds checks
+        const uint64_t paths_size = size - header->paths_offset;
+        for (uint32_t i = 0; i < header->document_count; ++i) {
+            const DocumentEntry& document = segment->documents[i];
+            if (document.path_offset > paths_size || document.path_length > paths_size - document.path_offset ||
+                segment->order[i] >= header->document_count) {
+                return nullptr;
+            }
+        }
+        const uint64_t postings_size = header->paths_offset - header->postings_offset;
+        for (uint32_t i = 0; i < header->trigram_count; ++i) {
+            if (segment->trigrams[i].offset > postings_size ||
+                (i > 0 && (segment->trigrams[i].trigram <= segment->trigrams[i - 1].trigram ||
+                           segment->trigrams[i].offset < segment->trigrams[i - 1].offset))) {
+                return nullptr;
+            }
+        }
+        // And every posting list, so no document number indexes past the tables
+        std::vector<uint32_t> documents;
+        for (uint32_t i = 0; i < header->trigram_count; ++i) {
+            if (!segment->Decode(segment->trigrams[i], documents)) {
+                Logger::LogError("TrigramIndex: " + path + " is damaged, rebuilding");
+                return nullptr;
+            }
+        }
+        return segment;
+    }
+
+    uint32_t GetDocumentCount() const { return header->document_count; }
+
+    std::string_view GetPath(uint32_t document) const {
+        return std::string_view(paths + documents[document].path_offset, documents[document].path_length);
+    }
+
+    // Position in |order| of the first document whose path is not below |path|
+    const uint32_t* LowerBound(std::string_view path) const {
+        return std::lower_bound(order, order + header->document_count, path,
+                                [this](uint32_t document, std::string_view value) { return GetPath(document) < value; });
+    }
+
+    uint32_t Find(std::string_view path) const {
+        const uint32_t* it = LowerBound(path);
+        return it != order + header->document_count && GetPath(*it) == path ? *it : kNoDocument;
+    }
+
+    const TrigramEntry* FindTrigram(uint32_t trigram) const {
+        const TrigramEntry* end = trigrams + header->trigram_count;
+        const TrigramEntry* it = std::lower_bound(trigrams, end, trigram,
+                                                  [](const TrigramEntry& entry, uint32_t value) { return entry.trigram < value; });
+        return it != end && it->trigram == trigram ? it : nullptr;
+    }
+
+    // False if the list is damaged; |documents| are then not to be used
+    bool Decode(const TrigramEntry& entry, std::vector<uint32_t>& documents) const {
+        const TrigramEntry* next = &entry + 1;
+        const uint8_t* end = next < trigrams + header->trigram_count ? postings + next->offset : postings_end;
+        return DecodePostings(postings + entry.offset, end, entry.count, header->document_count, documents);
+    }
+};
+
+// File re-read since the index file was written
+struct TrigramIndex::Document {
+    uint64_t size;
+    int64_t modified;
+    std::vector<uint32_t> trigrams;             // Sorted; empty for binary files
+};
+
+struct TrigramIndex::Update {
+    std::string root;
+    std::shared_ptr<const WorkspaceTree> tree;
+    bool reset;
+    std::set<std::string> paths;                // Changed since the previous update
+    CancelToken token;
+    std::chrono::steady_clock::time_point started;
+
+    // The index as it will be once this update is applied
+    std::shared_ptr<const Segment> segment;
+    std::vector<uint8_t> removed;
+    std::map<std::string, std::shared_ptr<const Document>> overlay;
+    std::vector<uint32_t> stale;                // Nodes of |tree| to read
+    std::vector<uint8_t> seen;                  // Reset: segment documents still in the tree
+    bool rewrite;                               // Write a new index file instead of adding to the overlay
+
+    std::atomic<size_t> pending;                // Batches not finished, plus one until all are submitted
+    std::atomic<uint64_t> bytes;
+    std::mutex mutex;                           // Batches adding documents
+    std::vector<DocumentInfo> documents;        // Rewrite: the new file's documents by number
+    std::unordered_map<uint32_t, PostingList> postings;
+
+    // Whether |node| is indexed as it is in the tree; if not, mask what there is and queue it
+    void Check(uint32_t node) {
+        std::string path = tree->GetPath(node);
+        auto it = overlay.find(path);
+        if (it != overlay.end()) {
+            if (it->second->size == tree->GetSize(node) && it->second->modified == tree->GetModified(node)) {
+                return;
+            }
+            overlay.erase(it);
+        } else if (segment) {
+            uint32_t document = segment->Find(path);
+            if (document != kNoDocument && !seen.empty()) {
+                seen[document] = 1;
+            }
+            if (document != kNoDocument && !removed[document]) {
+                const DocumentEntry& entry = segment->documents[document];
+                if (entry.size == tree->GetSize(node) && entry.modified == tree->GetModified(node)) {
+                    return;
+                }
+                removed[document] = 1;
+            }
+        }
+        stale.push_back(node);
+    }
+
+    // |path| and everything below it are gone
+    void Forget(const std::string& path) {
+        std::string prefix = path + "/";
+        overlay.erase(path);
+        overlay.erase(overlay.lower_bound(prefix), overlay.lower_bound(path + "0"));    // '0' follows '/'
+        if (!segment) {
+            return;
+        }
+        uint32_t document = segment->Find(path);
+        if (document != kNoDocument) {
+            removed[document] = 1;
+        }
+        const uint32_t* end = segment->order + segment->GetDocumentCount();
+        for (const uint32_t* it = segment->LowerBound(prefix); it != end; ++it) {
+            if (segment->GetPath(*it).compare(0, prefix.size(), prefix) != 0) {
+                break;
+            }
+            removed[*it] = 1;
+        }
+    }
+};
+
+TrigramIndex::TrigramIndex()
+    : running_(false), stopped_(false), pending_reset_(false) {
+}
+
+TrigramIndex::~TrigramIndex() {
+}
+
+TrigramIndex& TrigramIndex::GetInstance() {
+    static TrigramIndex instance;
+    return instance;
+}
+
+void TrigramIndex::Configure(const std::string& cache_path) {
+    directory_.clear();
+    if (cache_path.empty()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::path directory = std::filesystem::u8path(cache_path) / kIndexDirectory;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        Logger::LogError("TrigramIndex: Cannot create " + directory.u8string() + ": " + ec.message());
+        return;
+    }
+    directory_ = directory.u8string();
+}
+
+void TrigramIndex::Start() {
+    if (directory_.empty()) {
+        Logger::LogMessage("TrigramIndex: Disabled, searches read every file");
+        return;
+    }
+    WorkspaceIndex::GetInstance().AddTreeCallback(
+        [](const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree, const TreeDiff& diff, bool reset) {
+            GetInstance().OnTreeChanged(root, tree, diff, reset);
+        });
+}
+
+void TrigramIndex::Shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    token_.Cancel();
+}
+
+std::string TrigramIndex::GetIndexPath(const std::string& root) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(
+        ResourceHash::Hash64(reinterpret_cast<const uint8_t*>(root.data()), root.size())));
+    return (std::filesystem::u8path(directory_) / (std::string(name) + kIndexExtension)).u8string();
+}
+
+// Worker that built |tree|, called once per tree in order
+void TrigramIndex::OnTreeChanged(const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree,
+                                 const TreeDiff& diff, bool reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_ || (!reset && root == failed_root_)) {
+        return;
+    }
+    if (reset) {
+        failed_root_.clear();
+        pending_root_ = root;
+        pending_reset_ = true;
+        pending_paths_.clear();
+    } else if (!pending_reset_) {
+        // Added directories come without their contents; the update walks them.
+        // Changed directories only changed their time.
+        for (uint32_t node : diff.added) {
+            pending_paths_.insert(tree->GetPath(node));
+        }
+        for (uint32_t node : diff.changed) {
+            if (!tree->IsDirectory(node)) {
+                pending_paths_.insert(tree->GetPath(node));
+            }
+        }
+        pending_paths_.insert(diff.removed.begin(), diff.removed.end());
+    }
+    pending_tree_ = tree;
+    if (!running_) {
+        StartUpdate();
+    }
+}
+
+// With mutex_ held
+void TrigramIndex::StartUpdate() {
+    std::shared_ptr<Update> update = std::make_shared<Update>();
+    update->root = pending_root_;
+    update->tree = pending_tree_;
+    update->reset = pending_reset_;
+    update->paths.swap(pending_paths_);
+    update->token = token_;
+    pending_tree_ = nullptr;
+    pending_reset_ = false;
+    running_ = WorkerPool::GetInstance().Submit([this, update]() { RunUpdate(update); });
+}
+
+// Worker thread; the only writer of the index state, so it reads that state without the lock
+void TrigramIndex::RunUpdate(std::shared_ptr<Update> update) {
+    update->started = std::chrono::steady_clock::now();
+    const WorkspaceTree& tree = *update->tree;
+    const std::string index_path = GetIndexPath(update->root);
+
+    if (update->reset || update->root != root_ || !segment_) {
+        // Start over from the file on disk: whatever the tree holds that the
+        // file does not (or holds differently) is read again
+        update->reset = true;
+        std::shared_ptr<Segment> segment = Segment::Load(index_path, update->root);
+        update->segment = segment;
+        if (segment) {
+            update->removed.assign(segment->GetDocumentCount(), 0);
+            update->seen.assign(segment->GetDocumentCount(), 0);
+            std::error_code ec;
+            std::filesystem::last_write_time(std::filesystem::u8path(index_path),
+                                             std::filesystem::file_time_type::clock::now(), ec);
+        }
+        for (uint32_t node = 0; node < tree.GetNodeCount(); ++node) {
+            if (IsIndexed(tree, node)) {
+                update->Check(node);
+            }
+        }
+        for (size_t document = 0; document < update->seen.size(); ++document) {
+            if (!update->seen[document]) {
+                update->removed[document] = 1;
+            }
+        }
+
+        // Indexes of workspaces that have not been opened for a while
+        std::error_code ec;
+        auto cutoff = std::filesystem::file_time_type::clock::now() - std::chrono::hours(24 * kUnusedDays);
+        for (std::filesystem::directory_iterator it(std::filesystem::u8path(directory_), ec), end;
+             !ec && it != end; it.increment(ec)) {
+            std::error_code time_ec;
+            std::filesystem::path extension = it->path().extension();
+            if ((extension == kIndexExtension || extension == ".tmp") && it->last_write_time(time_ec) < cutoff &&
+                !time_ec) {
+                std::filesystem::remove(it->path(), time_ec);
+            }
+        }
+    } else {
+        update->segment = segment_;
+        update->removed = removed_;
+        update->overlay = overlay_;
+        for (const std::string& path : update->paths) {
+            uint32_t node = tree.Find(path);
+            if (node == WorkspaceTree::kNotFound) {
+                update->Forget(path);
+            } else if (!tree.IsDirectory(node)) {
+                if (IsIndexed(tree, node)) {
+                    update->Check(node);
+                }
+            } else {
+                // Files of an added directory, breadth first
+                std::vector<uint32_t> directories(1, node);
+                while (!directories.empty()) {
+                    uint32_t directory = directories.back();
+                    directories.pop_back();
+                    uint32_t first = tree.GetFirstChild(directory);
+                    for (uint32_t child = first; child < first + tree.GetChildCount(directory); ++child) {
+                        if (tree.IsDirectory(child)) {
+                            directories.push_back(child);
+                        } else if (IsIndexed(tree, child)) {
+                            update->Check(child);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Past the overlay limit, or with most of the file masked, write a new file
+    size_t removed = std::count(update->removed.begin(), update->removed.end(), 1);
+    update->rewrite = !update->segment || update->overlay.size() + update->stale.size() > kMaxOverlayFiles ||
+                      removed > update->removed.size() / 2;
+    if (update->rewrite && update->segment) {
+        // Surviving documents keep their order under new numbers, followed by the overlay
+        const Segment& segment = *update->segment;
+        std::vector<uint32_t> renumbered(segment.GetDocumentCount(), kNoDocument);
+        for (uint32_t document = 0; document < segment.GetDocumentCount(); ++document) {
+            if (!update->removed[document]) {
+                renumbered[document] = static_cast<uint32_t>(update->documents.size());
+                const DocumentEntry& entry = segment.documents[document];
+                update->documents.push_back({ std::string(segment.GetPath(document)), entry.size, entry.modified });
+            }
+        }
+        bool valid = true;
+        std::vector<uint32_t> list;
+        for (uint32_t i = 0; i < segment.header->trigram_count && valid; ++i) {
+            if (update->token.IsCancelled()) {
+                return;
+            }
+            valid = segment.Decode(segment.trigrams[i], list);
+            if (!valid) {
+                break;
+            }
+            PostingList* postings = nullptr;
+            for (uint32_t document : list) {
+                if (renumbered[document] != kNoDocument) {
+                    if (!postings) {
+                        postings = &update->postings[segment.trigrams[i].trigram];
+                    }
+                    postings->Append(renumbered[document]);
+                }
+            }
+        }
+        if (!valid) {
+            // Damaged posting list: index every file again
+            Logger::LogError("TrigramIndex: " + index_path + " is damaged, rebuilding");
+            update->documents.clear();
+            update->postings.clear();
+            update->overlay.clear();
+            update->stale.clear();
+            for (uint32_t node = 0; node < tree.GetNodeCount(); ++node) {
+                if (IsIndexed(tree, node)) {
+                    update->stale.push_back(node);
+                }
+            }
+        }
+    }
+    if (update->rewrite) {
+        for (const auto& entry : update->overlay) {
+            uint32_t number = static_cast<uint32_t>(update->documents.size());
+            update->documents.push_back({ entry.first, entry.second->size, entry.second->modified });
+            for (uint32_t trigram : entry.second->trigrams) {
+                update->postings[trigram].Append(number);
+            }
+        }
+        update->overlay.clear();
+        update->segment = nullptr;
+        update->removed.clear();
+    }
+
+    // Same batching as WorkspaceSearch: neighbouring files, cut by size
+    std::vector<std::vector<uint32_t>> batches(1);
+    uint64_t batch_bytes = 0;
+    for (uint32_t node : update->stale) {
+        if (batch_bytes >= kBatchBytes || batches.back().size() >= kMaxBatchFiles) {
+            batches.emplace_back();
+            batch_bytes = 0;
+        }
+        batches.back().push_back(node);
+        batch_bytes += tree.GetSize(node);
+    }
+    if (batches.back().empty()) {
+        batches.pop_back();
+    }
+    update->pending.store(batches.size() + 1);
+    update->bytes.store(0);
+    for (std::vector<uint32_t>& batch : batches) {
+        if (!WorkerPool::GetInstance().Submit([this, update, batch]() { ReadFiles(update, batch); })) {
+            FinishBatch(update);
+        }
+    }
+    FinishBatch(update);
+}
+
+// Worker thread
+void TrigramIndex::ReadFiles(std::shared_ptr<Update> update, std::vector<uint32_t> nodes) {
+    thread_local std::vector<char> buffer;     // Per worker, reused across batches (see TextReader)
+    const WorkspaceTree& tree = *update->tree;
+    std::vector<std::pair<std::string, std::shared_ptr<Document>>> documents;
+    documents.reserve(nodes.size());
+    for (uint32_t node : nodes) {
+        if (update->token.IsCancelled()) {
+            break;
+        }
+        std::shared_ptr<Document> document = std::make_shared<Document>();
+        document->size = tree.GetSize(node);
+        document->modified = tree.GetModified(node);
+        std::string path = tree.GetPath(node);
+        // Files that vanished (or shrank) are indexed as read until the tree catches up
+        WorkspaceSearch::TextReader reader;
+        if (reader.Open(update->root + "/" + path, buffer)) {
+            const char* data;
+            size_t size;
+            while (reader.Next(data, size)) {
+                AddTrigrams(data, size, document->trigrams);
+                update->bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+            FinishTrigrams(document->trigrams);
+        }
+        documents.emplace_back(std::move(path), std::move(document));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(update->mutex);
+        for (auto& entry : documents) {
+            if (update->rewrite) {
+                uint32_t number = static_cast<uint32_t>(update->documents.size());
+                update->documents.push_back({ std::move(entry.first), entry.second->size, entry.second->modified });
+                for (uint32_t trigram : entry.second->trigrams) {
+                    update->postings[trigram].Append(number);
+                }
+            } else {
+                update->overlay[std::move(entry.first)] = std::move(entry.second);
+            }
+        }
+    }
+    FinishBatch(update);
+}
+
+void TrigramIndex::FinishBatch(const std::shared_ptr<Update>& update) {
+    if (update->pending.fetch_sub(1) != 1 || update->token.IsCancelled()) {
+        return;
+    }
+
+    uint64_t file_size = 0;
+    if (update->rewrite) {
+        // The mapping of the old file goes first: Windows cannot replace a mapped file
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tree_ = nullptr;
+            segment_ = nullptr;
+            removed_.clear();
+            overlay_.clear();
+        }
+        std::string index_path = GetIndexPath(update->root);
+        bool written = WriteIndexFile(std::filesystem::u8path(index_path), update->root, update->documents,
+                                      update->postings, file_size);
+        update->postings.clear();
+        update->segment = written ? Segment::Load(index_path, update->root) : nullptr;
+        if (update->segment) {
+            update->removed.assign(update->segment->GetDocumentCount(), 0);
+        } else {
+            Logger::LogError("TrigramIndex: Failed to write " + index_path);
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - update->started);
+    std::string summary = "TrigramIndex: Read " + std::to_string(update->stale.size()) + " files (" +
+                          std::to_string(update->bytes.load() / (1024 * 1024)) + " MB) in " +
+                          std::to_string(elapsed.count()) + " ms";
+    if (update->reset && !update->rewrite && update->segment) {
+        summary += "; loaded " + std::to_string(update->segment->GetDocumentCount()) + " files from " +
+                   GetIndexPath(update->root) + ", " + std::to_string(update->overlay.size()) + " in the overlay";
+    } else if (update->rewrite && update->segment) {
+        summary += "; wrote " + std::to_string(update->segment->GetDocumentCount()) + " files, " +
+                   std::to_string(update->segment->header->trigram_count) + " trigrams (" +
+                   std::to_string(file_size / (1024 * 1024)) + " MB)";
+    } else if (update->segment) {
+        summary += "; " + std::to_string(update->overlay.size()) + " files in the overlay";
+    }
+    if (update->reset || update->rewrite) {
+        Logger::LogMessage(summary);
+    } else {
+        Logger::LogVerbose(summary);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    root_ = update->root;
+    tree_ = update->segment ? update->tree : nullptr;
+    segment_ = update->segment;
+    removed_.swap(update->removed);
+    overlay_.swap(update->overlay);
+    running_ = false;
+    if (!segment_ && !pending_reset_) {
+        // Not retried on every change, only when the workspace is opened again
+        failed_root_ = update->root;
+        pending_tree_ = nullptr;
+        pending_paths_.clear();
+    }
+    if (pending_tree_ && !stopped_) {
+        StartUpdate();
+    }
+}
+
+bool TrigramIndex::Query(const std::shared_ptr<const WorkspaceTree>& tree, const SearchPattern& pattern,
+                         std::vector<std::string>& candidates) const {
+    std::vector<uint32_t> trigrams;
+    LiteralTrigrams(pattern.GetRequiredLiteral(), trigrams);
+    if (trigrams.empty()) {
+        return false;
+    }
+
+    // Without a watch on every directory, the tree itself can miss edits made
+    // outside the app, and the index would rule out files that match by now
+    if (!FileWatcher::GetInstance().IsWatchingAll()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!tree || tree != tree_ || !segment_) {
+        return false;
+    }
+    candidates.clear();
+
+    // Rarest trigrams first; one that no document has rules out the whole file
+    std::vector<const TrigramEntry*> entries;
+    for (uint32_t trigram : trigrams) {
+        const TrigramEntry* entry = segment_->FindTrigram(trigram);
+        if (!entry) {
+            entries.clear();
+            break;
+        }
+        entries.push_back(entry);
+    }
+    if (!entries.empty()) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const TrigramEntry* a, const TrigramEntry* b) { return a->count < b->count; });
+        std::vector<uint32_t> documents;
+        std::vector<uint32_t> list;
+        std::vector<uint32_t> both;
+        if (!segment_->Decode(*entries[0], documents)) {
+            return false;
+        }
+        for (size_t i = 1; i < entries.size() && i < kMaxQueryLists && !documents.empty(); ++i) {
+            if (entries[i]->count > documents.size() * kVerifyRatio) {
+                break;
+            }
+            if (!segment_->Decode(*entries[i], list)) {
+                return false;
+            }
+            Intersect(documents, list, both);
+            documents.swap(both);
+        }
+        for (uint32_t document : documents) {
+            if (!removed_[document]) {
+                candidates.emplace_back(segment_->GetPath(document));
+            }
+        }
+    }
+
+    for (const auto& entry : overlay_) {
+        const std::vector<uint32_t>& contained = entry.second->trigrams;
+        if (std::includes(contained.begin(), contained.end(), trigrams.begin(), trigrams.end())) {
+            candidates.push_back(entry.first);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "search_pattern.hpp"
+#include "workspace_tree.hpp"
+#include "worker_pool.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Persistent trigram index of the workspace's file contents, so a search only
+// reads the files that can match.
+//
+// Every file is reduced to the set of byte trigrams on its lines, with ASCII
+// folded to lower case so one index serves both case modes. The index is one
+// file per workspace root under <cache_path>/search: the documents (path,
+// size, time) and, per trigram, the sorted document numbers that contain it,
+// delta- and varint-compressed. It is memory-mapped when the workspace opens,
+// so only the posting lists a query touches are ever read from disk.
+//
+// A query takes the trigrams of the literal every match must contain and
+// intersects their posting lists (SSE2 four by four, or binary search when one
+// list is much shorter); WorkspaceSearch still verifies every candidate line.
+//
+// The index follows the WorkspaceIndex tree. Files whose size or time differ
+// from what was indexed, on open or in a tree diff, are re-read into an
+// in-memory overlay that masks their old entries. An update that would grow
+// the overlay past kMaxOverlayFiles rewrites the index file instead. Until
+// the index has caught up with the newest tree, and whenever the FileWatcher
+// does not cover every directory of it (the tree may then be stale itself),
+// Query() declines and searches read every file.
+class TrigramIndex {
+public:
+    static constexpr size_t kMaxOverlayFiles = 4096;
+    static constexpr size_t kBatchBytes = 8 * 1024 * 1024;
+    static constexpr size_t kMaxBatchFiles = 512;
+    static constexpr size_t kMaxQueryLists = 8;         // Posting lists intersected per query
+    static constexpr int kUnusedDays = 30;              // Index files of roots not opened since are removed
+
+    // Singleton access
+    static TrigramIndex& GetInstance();
+
+    // Before Start(). Index files go to |cache_path|/search; empty disables the index.
+    void Configure(const std::string& cache_path);
+
+    // Follow WorkspaceIndex; call before the first workspace is opened
+    void Start();
+
+    // Abandon the running update (the file on disk stays valid) and stop
+    void Shutdown();
+
+    // Any thread. Relative paths of the files in |tree| that may contain a
+    // match of |pattern|. False when the index cannot answer: it is disabled or
+    // behind |tree|, the watcher does not cover the whole tree, or the pattern
+    // has no required literal of 3+ bytes.
+    bool Query(const std::shared_ptr<const WorkspaceTree>& tree, const SearchPattern& pattern,
+               std::vector<std::string>& candidates) const;
+
+private:
+    struct Segment;
+    struct Document;
+    struct Update;
+
+    TrigramIndex();
+    ~TrigramIndex();
+    TrigramIndex(const TrigramIndex&);
+    TrigramIndex& operator=(const TrigramIndex&);
+
+    void OnTreeChanged(const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree,
+                       const TreeDiff& diff, bool reset);
+    void StartUpdate();
+    void RunUpdate(std::shared_ptr<Update> update);
+    void ReadFiles(std::shared_ptr<Update> update, std::vector<uint32_t> nodes);
+    void FinishBatch(const std::shared_ptr<Update>& update);
+    std::string GetIndexPath(const std::string& root) const;
+
+    std::string directory_;                     // Empty: disabled
+
+    mutable std::mutex mutex_;
+    bool running_;                              // Update in progress
+    bool stopped_;
+    CancelToken token_;
+    std::string failed_root_;                   // Index file could not be written; wait for a reopen
+
+    // Changes not yet handed to an update
+    std::string pending_root_;
+    std::shared_ptr<const WorkspaceTree> pending_tree_;
+    bool pending_reset_;
+    std::set<std::string> pending_paths_;       // Files and added directories, relative to the root
+
+    // Written by the update in progress only, under mutex_; it reads them without
+    std::string root_;
+    std::shared_ptr<const WorkspaceTree> tree_; // Tree the index has caught up with
+    std::shared_ptr<const Segment> segment_;
+    std::vector<uint8_t> removed_;              // Per segment document: deleted or masked by the overlay
+    std::map<std::string, std::shared_ptr<const Document>> overlay_;
+};
@@ -1,14 +1,32 @@
 #pragma once
+#include <cstddef>
 
-// Auto-generated binary resources from webapp/dist/index.html (single-file with inlined CSS/JS)
+// Auto-generated binary resources from webapp/dist (one entry per asset)
 // Do not edit this file manually
 
-// HTML resource functions (contains inlined CSS and JS)
-const char* GetWebAppHTML();
-unsigned int GetWebAppHTMLSize();
+// How an asset's bytes are stored in the binary
+enum WebAppEncoding {
+    WEBAPP_ENCODING_IDENTITY = 0,
+    WEBAPP_ENCODING_BROTLI = 1
+};
 
-// Placeholder functions for compatibility (not used with single-file build)
-const char* GetWebAppCSS();
-unsigned int GetWebAppCSSSize();
-const char* GetWebAppJS();
-unsigned int GetWebAppJSSize();
+// Embedded asset, addressed by its URL path under miko://app
+struct WebAppAsset {
+    const char* path;
+    const unsigned char* data;
+    unsigned int size;           // Stored (possibly compressed) size
+    unsigned int original_size;  // Size after decoding
+    WebAppEncoding encoding;
+    const char* etag;            // Quoted strong ETag (content hash)
+};
+
+// Look up an asset by URL path through the build-time perfect-hash table.
+// Returns nullptr when the path is not part of the bundle.
+const WebAppAsset* FindWebAppAsset(const char* path, size_t length);
+
+// All embedded assets, indexed by perfect-hash slot
+const WebAppAsset* GetWebAppAssets();
+unsigned int GetWebAppAssetCount();
+
+// Content hash of the whole bundle; changes whenever any asset changes
+const char* GetWebAppBundleHash();
@@ -1,6 +1,8 @@
 #include "window_mode_manager.hpp"
 #include "logger.hpp"
 #include "config.hpp"
+#include "settings.hpp"
+#include "internal/commandregistry.hpp"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -19,23 +21,25 @@
     #endif
 #endif
 
-// Static member initialization - FORCE BORDERLESS MODE
+// Global variables
+extern CefRefPtr<CefWindow> g_cef_window;
+
+// Static member initialization
 WindowMode WindowModeManager::current_mode_ = WindowMode::BORDERLESS;
 bool WindowModeManager::initialized_ = false;
 
 void WindowModeManager::Initialize() {
     if (initialized_) return;
     
-    // Force borderless mode - ignore config
-    current_mode_ = WindowMode::BORDERLESS;
+    current_mode_ = AppConfig::GetWindowMode();
     
     initialized_ = true;
-    Logger::LogMessage("WindowModeManager: Initialized with FORCED borderless mode");
+    Logger::LogMessage("WindowModeManager: Initialized with " + AppConfig::GetWindowModeString() + " mode");
 }
 
 void WindowModeManager::ApplyWindowMode(CefRefPtr<CefWindow> window, WindowMode mode) {
     if (!window) {
-        Logger::LogMessage("WindowModeManager: Invalid window reference");
+        Logger::LogError("WindowModeManager: Invalid window reference");
         return;
     }
 
@@ -101,7 +105,7 @@ void WindowModeManager::ApplyWindowsMode(CefRefPtr<CefWindow> window, WindowMode
 #ifdef _WIN32
     HWND hwnd = window->GetWindowHandle();
     if (!hwnd || !IsWindow(hwnd)) {
-        Logger::LogMessage("Windows: Invalid window handle");
+        Logger::LogError("Windows: Invalid window handle");
         return;
     }
 
@@ -113,7 +117,7 @@ void WindowModeManager::ApplyWindowsMode(CefRefPtr<CefWindow> window, WindowMode
     LONG exStyle = GetWindowLong(hwnd, GWL_EXSTYLE);
 
     if (style == 0 || exStyle == 0) {
-        Logger::LogMessage("Windows: Failed to get window styles");
+        Logger::LogError("Windows: Failed to get window styles");
         return;
     }
 
@@ -126,7 +130,7 @@ void WindowModeManager::ApplyWindowsMode(CefRefPtr<CefWindow> window, WindowMode
         MARGINS margins = {0, 0, 0, 0};
         HRESULT hr = DwmExtendFrameIntoClientArea(hwnd, &margins);
         if (FAILED(hr)) {
-            Logger::LogMessage("Windows: Failed to reset DWM frame extension");
+            Logger::LogError("Windows: Failed to reset DWM frame extension");
         }
         
         Logger::LogMessage("Windows: Applied windowed mode");
@@ -139,19 +143,19 @@ void WindowModeManager::ApplyWindowsMode(CefRefPtr<CefWindow> window, WindowMode
         MARGINS margins = {0, 0, 32, 0}; // 32px title bar height
         HRESULT hr = DwmExtendFrameIntoClientArea(hwnd, &margins);
         if (FAILED(hr)) {
-            Logger::LogMessage("Windows: Failed to extend DWM frame");
+            Logger::LogError("Windows: Failed to extend DWM frame");
         }
         
         Logger::LogMessage("Windows: Applied borderless mode");
     }
 
     if (SetWindowLong(hwnd, GWL_STYLE, style) == 0) {
-        Logger::LogMessage("Windows: Failed to set window style");
+        Logger::LogError("Windows: Failed to set window style");
         return;
     }
     
     if (SetWindowLong(hwnd, GWL_EXSTYLE, exStyle) == 0) {
-        Logger::LogMessage("Windows: Failed to set extended window style");
+        Logger::LogError("Windows: Failed to set extended window style");
         return;
     }
     
@@ -159,7 +163,7 @@ void WindowModeManager::ApplyWindowsMode(CefRefPtr<CefWindow> window, WindowMode
     if (!SetWindowPos(hwnd, NULL, rect.left, rect.top, 
                      rect.right - rect.left, rect.bottom - rect.top,
                      SWP_NOZORDER | SWP_FRAMECHANGED)) {
-        Logger::LogMessage("Windows: Failed to apply window position changes");
+        Logger::LogError("Windows: Failed to apply window position changes");
     }
 #endif
 }
@@ -168,7 +172,7 @@ void WindowModeManager::ApplyMacOSMode(CefRefPtr<CefWindow> window, WindowMode m
 #ifdef __APPLE__
     NSWindow* nsWindow = (__bridge NSWindow*)window->GetWindowHandle();
     if (!nsWindow) {
-        Logger::LogMessage("macOS: Failed to get NSWindow handle");
+        Logger::LogError("macOS: Failed to get NSWindow handle");
         return;
     }
 
@@ -205,7 +209,7 @@ void WindowModeManager::ApplyLinuxMode(CefRefPtr<CefWindow> window, WindowMode m
     // Try to get the native window handle
     CefWindowHandle handle = window->GetWindowHandle();
     if (!handle) {
-        Logger::LogMessage("Linux: Failed to get window handle");
+        Logger::LogError("Linux: Failed to get window handle");
         return;
     }
 
@@ -227,7 +231,7 @@ void WindowModeManager::ApplyLinuxMode(CefRefPtr<CefWindow> window, WindowMode m
     // X11-based approach as fallback
     Display* display = XOpenDisplay(NULL);
     if (!display) {
-        Logger::LogMessage("Linux: Failed to open X11 display");
+        Logger::LogError("Linux: Failed to open X11 display");
         return;
     }
 
@@ -268,7 +272,8 @@ void WindowModeManager::RestoreWindowState(CefRefPtr<CefWindow> window) {
     if (!window) return;
     
     // Set default window size and position
-    CefRect bounds(100, 100, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+    const RuntimeConfig& config = Settings::GetInstance().GetConfig();
+    CefRect bounds(100, 100, config.window_width, config.window_height);
     window->SetBounds(bounds);
     
     Logger::LogMessage("WindowModeManager: Applied default window state");
@@ -282,4 +287,54 @@ bool WindowModeManager::CanToggleMode() {
 #else
     return true;
 #endif
-}
\ No newline at end of file
+}
+
+// Window mode commands sent by the page through cefQuery
+namespace {
+    bool HandleToggleWindowMode(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (!g_cef_window || !WindowModeManager::CanToggleMode()) {
+            result = "Cannot toggle window mode";
+            return false;
+        }
+        WindowModeManager::ToggleWindowMode(g_cef_window);
+        result = WindowModeManager::GetModeString();
+        return true;
+    }
+
+    bool HandleGetWindowMode(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (!g_cef_window) {
+            result = "No window available";
+            return false;
+        }
+        result = WindowModeManager::GetModeString();
+        return true;
+    }
+
+    bool HandleSetWindowedMode(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (!g_cef_window) {
+            result = "No window available";
+            return false;
+        }
+        WindowModeManager::SetWindowedMode(g_cef_window);
+        result = "windowed";
+        return true;
+    }
+
+    bool HandleSetBorderlessMode(const SimpleIPC::CommandRequest& request, std::string& result) {
+        if (!g_cef_window) {
+            result = "No window available";
+            return false;
+        }
+        WindowModeManager::SetBorderlessMode(g_cef_window);
+        result = "borderless";
+        return true;
+    }
+}
+
+void WindowModeManager::RegisterCommands() {
+    SimpleIPC::CommandRegistry& registry = SimpleIPC::CommandRegistry::GetInstance();
+    registry.Register("toggle_window_mode", HandleToggleWindowMode);
+    registry.Register("get_window_mode", HandleGetWindowMode);
+    registry.Register("set_windowed_mode", HandleSetWindowedMode);
+    registry.Register("set_borderless_mode", HandleSetBorderlessMode);
+}
@@ -23,6 +23,9 @@ public:
     static std::string GetModeString();
     static bool CanToggleMode();
     
+    // Register the window mode commands with the CommandRegistry
+    static void RegisterCommands();
+    
     // State persistence
     static void SaveWindowState(CefRefPtr<CefWindow> window);
     static void RestoreWindowState(CefRefPtr<CefWindow> window);
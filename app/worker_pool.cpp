@@ -0,0 +1,154 @@
+#include "worker_pool.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+namespace {
+    // Index of the current worker in its pool, kNotAWorker on other threads
+    const size_t kNotAWorker = static_cast<size_t>(-1);
+    thread_local size_t t_worker_index = kNotAWorker;
+
+    size_t DefaultThreadCount() {
+        // Leave a core for the UI thread; CEF's own threads mostly sleep
+        unsigned int cores = std::thread::hardware_concurrency();
+        return std::max<size_t>(2, cores > 1 ? cores - 1 : 1);
+    }
+}
+
+WorkerPool& WorkerPool::GetInstance() {
+    static WorkerPool instance;
+    return instance;
+}
+
+WorkerPool::WorkerPool()
+    : configured_threads_(0), running_(false), next_worker_(0), queued_(0) {
+}
+
+WorkerPool::~WorkerPool() {
+    Shutdown();
+}
+
+void WorkerPool::Configure(size_t thread_count) {
+    configured_threads_ = thread_count;
+}
+
+void WorkerPool::Start() {
+    size_t count = configured_threads_ > 0 ? configured_threads_ : DefaultThreadCount();
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    running_.store(true, std::memory_order_release);
+    for (size_t i = 0; i < count; ++i) {
+        workers_[i]->thread = std::thread(&WorkerPool::Run, this, i);
+    }
+    Logger::LogMessage("WorkerPool: Started " + std::to_string(count) + " threads");
+}
+
+bool WorkerPool::Submit(Task task) {
+    std::call_once(start_once_, &WorkerPool::Start, this);
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    size_t target = t_worker_index;
+    if (target == kNotAWorker || target >= workers_.size()) {
+        target = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+        workers_[target]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking the sleep mutex orders this against a worker checking queued_
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+    return true;
+}
+
+bool WorkerPool::PopLocal(size_t index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkerPool::Steal(size_t thief, Task& task) {
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim = *workers_[(thief + offset) % workers_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkerPool::Run(size_t index) {
+    t_worker_index = index;
+    while (running_.load(std::memory_order_acquire)) {
+        Task task;
+        if (PopLocal(index, task) || Steal(index, task)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        // try_lock in Steal() can miss work, so a non-zero count means retry
+        sleep_cv_.wait(lock, [this]() {
+            return queued_.load(std::memory_order_acquire) > 0 ||
+                   !running_.load(std::memory_order_acquire);
+        });
+    }
+}
+
+void WorkerPool::Shutdown() {
+    // A pool that never started must not start afterwards
+    std::call_once(start_once_, []() {});
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+        sleep_cv_.notify_all();
+    }
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    for (auto& worker : workers_) {
+        queued_.fetch_sub(worker->tasks.size(), std::memory_order_relaxed);
+        worker->tasks.clear();
+    }
+}
+
+void TaskGroup::Submit(WorkerPool::Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    auto run = [this, task]() {
+        task();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) {
+            done_cv_.notify_all();
+        }
+    };
+    if (!WorkerPool::GetInstance().Submit(run)) {
+        run();  // Pool already shut down
+    }
+}
+
+void TaskGroup::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Shared cancellation flag handed to work items. Copies refer to the same flag.
+class CancelToken {
+public:
+    CancelToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() const { flag_->store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const { return flag_->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+// Work-stealing thread pool for work that must not run on the CEF UI thread
+// (file system access, process spawning, hashing...).
+//
+// Every worker owns a deque: it pushes and pops its own work at the back and
+// idle workers steal from the front of the others, so short tasks spawned by a
+// busy worker stay cache-local while long ones still spread across the pool.
+// Threads start on first use.
+class WorkerPool {
+public:
+    typedef std::function<void()> Task;
+
+    // Singleton access
+    static WorkerPool& GetInstance();
+
+    // Thread count for when the pool starts; 0 (the default) is one per core
+    // minus one for the UI thread. No effect once a task has been submitted.
+    void Configure(size_t thread_count);
+
+    // Any thread. Tasks submitted from a worker go to that worker's own deque.
+    // Returns false (and drops |task|) once the pool is shut down.
+    bool Submit(Task task);
+
+    // Stop accepting work, drop queued tasks and join the workers. Running tasks
+    // finish first, so long tasks should poll their CancelToken.
+    void Shutdown();
+
+    size_t GetThreadCount() const { return workers_.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    WorkerPool();
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    void Start();
+    void Run(size_t index);
+    bool PopLocal(size_t index, Task& task);
+    bool Steal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t configured_threads_;
+    std::once_flag start_once_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> next_worker_;   // Round-robin target for outside submissions
+    std::atomic<size_t> queued_;        // Tasks sitting in any deque
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+};
+
+// Set of pool tasks that can be waited on together
+class TaskGroup {
+public:
+    TaskGroup() : pending_(0) {}
+    ~TaskGroup() { Wait(); }
+
+    void Submit(WorkerPool::Task task);
+
+    // Block until every task submitted so far has finished. Not from a pool
+    // thread: the tasks may be queued behind the caller.
+    void Wait();
+
+private:
+    TaskGroup(const TaskGroup&);
+    TaskGroup& operator=(const TaskGroup&);
+
+    std::mutex mutex_;
+    std::condition_variable done_cv_;
+    size_t pending_;
+};
@@ -0,0 +1,540 @@
+#include "workspace_index.hpp"
+#include "file_reader.hpp"
+#include "logger.hpp"
+#include "internal/eventbus.hpp"
+#include "internal/simpleipc.hpp"
+#include <filesystem>
+
+#ifdef __linux__
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+struct WorkspaceIndex::Scan {
+    std::string root;
+    std::set<std::string> directories;      // Subtrees being read
+    std::set<std::string> refreshed;        // Directories whose own entries are being read
+    std::shared_ptr<const WorkspaceTree> base;  // Tree the scan started from
+    bool reset;                             // First scan of a newly opened workspace
+    CancelToken token;
+    std::atomic<size_t> pending;            // Directories not finished yet
+    std::mutex mutex;
+    std::vector<DirectoryListing> listings;
+    std::chrono::steady_clock::time_point started;
+};
+
+namespace {
+    const char kTreeTopic[] = "workspace.tree";
+
+#ifdef __linux__
+    // Record layout of getdents64(2)
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    // Entries of |path| without ".", ".." or a per-entry open; files get an
+    // fstatat for size and time, directories need nothing more
+    bool ReadDirectory(const std::string& path, std::vector<DirectoryListing::Entry>& entries) {
+        int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        alignas(8) char buffer[32 * 1024];
+        for (;;) {
+            long count = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+            if (count <= 0) {
+                break;
+            }
+            for (long offset = 0; offset < count;) {
+                const LinuxDirent64* dirent = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+                offset += dirent->d_reclen;
+                const char* name = dirent->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+
+                DirectoryListing::Entry entry = { name, 0, 0, 0 };
+                unsigned char type = dirent->d_type;
+                if (type == DT_DIR) {
+                    entry.flags = WorkspaceTree::FLAG_DIRECTORY;
+                } else {
+                    struct stat st;
+                    if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                        type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_REG;
+                        entry.size = static_cast<uint64_t>(st.st_size);
+                        entry.modified = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+                    }
+                    entry.flags = type == DT_DIR ? WorkspaceTree::FLAG_DIRECTORY :
+                                  type == DT_LNK ? WorkspaceTree::FLAG_SYMLINK : 0;
+                }
+                entries.push_back(std::move(entry));
+            }
+        }
+        close(fd);
+        return true;
+    }
+#else
+    bool ReadDirectory(const std::string& path, std::vector<DirectoryListing::Entry>& entries) {
+        std::error_code ec;
+        std::filesystem::directory_iterator it(std::filesystem::u8path(path), ec), end;
+        if (ec) {
+            return false;
+        }
+        for (; !ec && it != end; it.increment(ec)) {
+            std::error_code entry_ec;
+            DirectoryListing::Entry entry = { it->path().filename().u8string(), 0, 0, 0 };
+            if (it->is_symlink(entry_ec)) {
+                entry.flags = WorkspaceTree::FLAG_SYMLINK;
+            } else if (it->is_directory(entry_ec)) {
+                entry.flags = WorkspaceTree::FLAG_DIRECTORY;
+            } else {
+                entry.size = it->file_size(entry_ec);
+                entry.modified = it->last_write_time(entry_ec).time_since_epoch().count();
+            }
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    }
+#endif
+
+    // Nearest directory |tree| knows about at or above |path|; new and deleted
+    // entries show up in their parent's listing
+    std::string FindDirectory(const WorkspaceTree& tree, std::string path) {
+        for (;;) {
+            uint32_t node = tree.Find(path);
+            if (path.empty() || (node != WorkspaceTree::kNotFound && tree.IsDirectory(node))) {
+                return path;
+            }
+            size_t slash = path.rfind('/');
+            path = slash == std::string::npos ? std::string() : path.substr(0, slash);
+        }
+    }
+
+    bool InSubtree(const std::set<std::string>& directories, const std::string& path) {
+        if (directories.count(std::string()) || directories.count(path)) {
+            return true;
+        }
+        for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            if (directories.count(path.substr(0, slash))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TrimPath(std::string& path) {
+        while (!path.empty() && path.back() == '/') {
+            path.pop_back();
+        }
+    }
+
+    // |path| and everything below it, unless an ancestor is already in |directories|
+    void AddSubtree(std::set<std::string>& directories, const std::string& path) {
+        if (InSubtree(directories, path)) {
+            return;
+        }
+        if (path.empty()) {
+            directories.clear();
+        } else {
+            std::string prefix = path + "/";
+            auto it = directories.lower_bound(prefix);
+            while (it != directories.end() && it->compare(0, prefix.size(), prefix) == 0) {
+                it = directories.erase(it);
+            }
+        }
+        directories.insert(path);
+    }
+
+    // Largest .gitignore that is read; the rest of a bigger one is ignored
+    const size_t kMaxIgnoreFileBytes = 1024 * 1024;
+
+    // Contents of |directory|/.gitignore. Read with positioned reads like the
+    // searched files, so one that is truncated meanwhile cannot fault the
+    // process (the watcher reaches this through LoadRulesFor).
+    bool ReadIgnoreFile(const std::string& directory, std::string& text) {
+        FileReader file;
+        if (!file.Open(directory + "/.gitignore")) {
+            return false;
+        }
+        uint64_t size = file.GetSize();
+        text.resize(size < kMaxIgnoreFileBytes ? static_cast<size_t>(size) : kMaxIgnoreFileBytes);
+        size_t read = 0;
+        if (!file.Read(0, &text[0], text.size(), read)) {
+            return false;
+        }
+        text.resize(read);
+        return true;
+    }
+
+    std::string EntryJson(const WorkspaceTree& tree, uint32_t node) {
+        return "{\"path\": \"" + SimpleIPC::EscapeJson(tree.GetPath(node)) + "\", \"directory\": " +
+               (tree.IsDirectory(node) ? "true" : "false") + ", \"size\": " + std::to_string(tree.GetSize(node)) + "}";
+    }
+}
+
+WorkspaceIndex::WorkspaceIndex()
+    : generation_(0) {
+}
+
+WorkspaceIndex::~WorkspaceIndex() {
+}
+
+WorkspaceIndex& WorkspaceIndex::GetInstance() {
+    static WorkspaceIndex instance;
+    return instance;
+}
+
+bool WorkspaceIndex::Open(const std::string& root, std::string& error) {
+    std::error_code ec;
+    std::filesystem::path path = std::filesystem::absolute(std::filesystem::u8path(root), ec).lexically_normal();
+    if (ec || !std::filesystem::is_directory(path, ec)) {
+        error = "Not a directory: " + root;
+        return false;
+    }
+    std::string normalized = path.generic_u8string();
+    if (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (scan_) {
+        scan_->token.Cancel();
+        scan_ = nullptr;
+    }
+    root_ = normalized;
+    tree_ = std::make_shared<WorkspaceTree>();
+    queued_.clear();
+    queued_refresh_.clear();
+    ++generation_;
+    Logger::LogMessage("WorkspaceIndex: Opening " + root_);
+    StartScan(std::set<std::string>{ std::string() }, std::set<std::string>(), true);
+    return true;
+}
+
+void WorkspaceIndex::Rescan(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_.empty()) {
+        return;
+    }
+
+    for (std::string path : paths) {
+        TrimPath(path);
+        queued_.insert(path);
+    }
+    if (!scan_) {
+        StartQueuedScan();
+    }
+}
+
+void WorkspaceIndex::Refresh(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_.empty()) {
+        return;
+    }
+
+    for (std::string path : paths) {
+        TrimPath(path);
+        queued_refresh_.insert(path);
+    }
+    if (!scan_) {
+        StartQueuedScan();
+    }
+}
+
+void WorkspaceIndex::AddTreeCallback(TreeCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_.push_back(std::move(callback));
+}
+
+// With mutex_ held. Paths are resolved against the newest tree only now, so
+// changes reported during a long scan rescan what that scan produced.
+void WorkspaceIndex::StartQueuedScan() {
+    std::set<std::string> directories;
+    for (const std::string& path : queued_) {
+        AddSubtree(directories, FindDirectory(*tree_, path));
+    }
+    std::set<std::string> refreshed;
+    for (const std::string& path : queued_refresh_) {
+        std::string directory = FindDirectory(*tree_, path);
+        if (!InSubtree(directories, directory)) {
+            refreshed.insert(directory);
+        }
+    }
+    queued_.clear();
+    queued_refresh_.clear();
+    StartScan(directories, refreshed, false);
+}
+
+// With mutex_ held
+void WorkspaceIndex::StartScan(const std::set<std::string>& directories, const std::set<std::string>& refreshed, bool reset) {
+    if (directories.empty() && refreshed.empty()) {
+        return;
+    }
+    std::shared_ptr<Scan> scan = std::make_shared<Scan>();
+    scan->root = root_;
+    scan->directories = directories;
+    scan->refreshed = refreshed;
+    scan->base = tree_;
+    scan->reset = reset;
+    scan->pending.store(directories.size() + refreshed.size());
+    scan->started = std::chrono::steady_clock::now();
+    scan_ = scan;
+
+    auto submit = [this, &scan](const std::string& directory, bool recursive) {
+        std::shared_ptr<const IgnoreRules> rules = LoadRulesFor(scan->root, directory);
+        if (!WorkerPool::GetInstance().Submit([this, scan, directory, rules, recursive]() {
+                ScanDirectory(scan, directory, rules, recursive); })) {
+            scan->pending.fetch_sub(1);     // Shutting down; the scan never finishes
+        }
+    };
+    for (const std::string& directory : directories) {
+        submit(directory, true);
+    }
+    for (const std::string& directory : refreshed) {
+        submit(directory, false);
+    }
+}
+
+// .gitignore files of the directories above |directory|, which a rescan of a
+// subtree does not walk through (and the watcher does not read at all)
+std::shared_ptr<const IgnoreRules> WorkspaceIndex::LoadRulesFor(const std::string& root, const std::string& directory) {
+    std::shared_ptr<const IgnoreRules> rules;
+    if (directory.empty()) {
+        return rules;
+    }
+    std::string ancestor;
+    for (size_t slash = 0; slash != std::string::npos;) {
+        std::string text;
+        if (ReadIgnoreFile(ancestor.empty() ? root : root + "/" + ancestor, text)) {
+            rules = IgnoreRules::Parse(rules, ancestor, text);
+        }
+        slash = directory.find('/', ancestor.empty() ? 0 : ancestor.size() + 1);
+        if (slash != std::string::npos) {
+            ancestor = directory.substr(0, slash);
+        }
+    }
+    return rules;
+}
+
+// Worker thread, one task per directory. A non-recursive read still descends
+// into subdirectories the base tree does not have yet.
+void WorkspaceIndex::ScanDirectory(std::shared_ptr<Scan> scan, std::string path, std::shared_ptr<const IgnoreRules> rules,
+                                   bool recursive) {
+    if (!scan->token.IsCancelled()) {
+        std::string full = path.empty() ? scan->root : scan->root + "/" + path;
+        std::string prefix = path.empty() ? std::string() : path + "/";
+        DirectoryListing listing;
+        listing.path = path;
+
+        std::vector<DirectoryListing::Entry> entries;
+        if (ReadDirectory(full, entries)) {
+            // A .gitignore applies to its own siblings too
+            for (const DirectoryListing::Entry& entry : entries) {
+                if (entry.name == ".gitignore" && !(entry.flags & WorkspaceTree::FLAG_DIRECTORY)) {
+                    std::string text;
+                    if (ReadIgnoreFile(full, text)) {
+                        rules = IgnoreRules::Parse(rules, path, text);
+                    }
+                    break;
+                }
+            }
+
+            listing.entries.reserve(entries.size());
+            for (DirectoryListing::Entry& entry : entries) {
+                bool directory = (entry.flags & WorkspaceTree::FLAG_DIRECTORY) != 0;
+                std::string child = prefix + entry.name;
+                if ((directory && entry.name == ".git") || (rules && rules->IsIgnored(child, directory))) {
+                    continue;
+                }
+                if (directory && !recursive) {
+                    uint32_t node = scan->base->Find(child);
+                    directory = node == WorkspaceTree::kNotFound || !scan->base->IsDirectory(node);
+                }
+                if (directory) {
+                    // Lands on this worker's own deque; idle workers steal it
+                    scan->pending.fetch_add(1);
+                    if (!WorkerPool::GetInstance().Submit([this, scan, child, rules]() { ScanDirectory(scan, child, rules, true); })) {
+                        FinishDirectory(scan);
+                    }
+                }
+                listing.entries.push_back(std::move(entry));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(scan->mutex);
+        scan->listings.push_back(std::move(listing));
+    }
+    FinishDirectory(scan);
+}
+
+void WorkspaceIndex::FinishDirectory(const std::shared_ptr<Scan>& scan) {
+    if (scan->pending.fetch_sub(1) == 1) {
+        FinishScan(scan);
+    }
+}
+
+// Worker thread that read the last directory
+void WorkspaceIndex::FinishScan(const std::shared_ptr<Scan>& scan) {
+    std::shared_ptr<const WorkspaceTree> old_tree;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (scan != scan_ || scan->token.IsCancelled()) {
+            return;
+        }
+        old_tree = tree_;
+    }
+
+    // Scans are serialised, so nothing replaces |old_tree| meanwhile except Open()
+    std::shared_ptr<const WorkspaceTree> tree = WorkspaceTree::Build(*old_tree, scan->directories, scan->refreshed,
+                                                                     scan->listings);
+    TreeDiff diff;
+    for (int pass = 0; pass < 2; ++pass) {
+        const std::set<std::string>& directories = pass == 0 ? scan->directories : scan->refreshed;
+        for (const std::string& directory : directories) {
+            uint32_t old_node = old_tree->Find(directory);
+            uint32_t new_node = tree->Find(directory);
+            if (old_node != WorkspaceTree::kNotFound && new_node != WorkspaceTree::kNotFound) {
+                DiffTrees(*old_tree, old_node, *tree, new_node, diff, pass == 0);
+            }
+        }
+    }
+
+    uint64_t generation;
+    std::vector<TreeCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (scan != scan_) {
+            return;
+        }
+        tree_ = tree;
+        generation = ++generation_;
+        callbacks = callbacks_;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - scan->started);
+    std::string summary = "WorkspaceIndex: Read " + std::to_string(scan->listings.size()) + " directories in " +
+                          std::to_string(elapsed.count()) + " ms; tree has " + std::to_string(tree->GetFileCount()) +
+                          " files in " + std::to_string(tree->GetDirectoryCount()) + " directories (" +
+                          std::to_string(tree->GetMemoryBytes() / 1024) + " KB), " + std::to_string(diff.GetSize()) +
+                          " changes";
+    // Refreshes follow every burst of file changes
+    if (scan->reset) {
+        Logger::LogMessage(summary);
+    } else {
+        Logger::LogVerbose(summary);
+    }
+
+    PublishDiff(*tree, diff, generation, scan->reset);
+    for (const TreeCallback& callback : callbacks) {
+        callback(scan->root, tree, diff, scan->reset);
+    }
+
+    // The next scan starts only now, so callbacks see the trees in order
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (scan == scan_) {
+        scan_ = nullptr;
+        if (!queued_.empty() || !queued_refresh_.empty()) {
+            StartQueuedScan();
+        }
+    }
+}
+
+void WorkspaceIndex::PublishDiff(const WorkspaceTree& tree, const TreeDiff& diff, uint64_t generation, bool reset) {
+    if (diff.GetSize() == 0 && !reset) {
+        return;
+    }
+
+    // Split so no single delivery grows with the size of the change
+    size_t added = 0;
+    size_t changed = 0;
+    size_t removed = 0;
+    do {
+        std::string json = "{\"generation\": " + std::to_string(generation) +
+                           ", \"reset\": " + (reset ? "true" : "false") + ", \"added\": [";
+        size_t budget = kMaxDiffEntries;
+        for (bool first = true; added < diff.added.size() && budget > 0; ++added, --budget, first = false) {
+            json += (first ? "" : ",") + EntryJson(tree, diff.added[added]);
+        }
+        json += "], \"changed\": [";
+        for (bool first = true; changed < diff.changed.size() && budget > 0; ++changed, --budget, first = false) {
+            json += (first ? "" : ",") + EntryJson(tree, diff.changed[changed]);
+        }
+        json += "], \"removed\": [";
+        for (bool first = true; removed < diff.removed.size() && budget > 0; ++removed, --budget, first = false) {
+            json += std::string(first ? "" : ",") + "\"" + SimpleIPC::EscapeJson(diff.removed[removed]) + "\"";
+        }
+        json += "]}";
+        SimpleIPC::EventBus::GetInstance().Publish(kTreeTopic, json);
+        reset = false;
+    } while (added < diff.added.size() || changed < diff.changed.size() || removed < diff.removed.size());
+}
+
+std::shared_ptr<const WorkspaceTree> WorkspaceIndex::GetTree(uint64_t* generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation) {
+        *generation = generation_;
+    }
+    return tree_;
+}
+
+std::string WorkspaceIndex::GetRoot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return root_;
+}
+
+uint64_t WorkspaceIndex::GetGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+bool WorkspaceIndex::HandleOpen(const std::string& message, int browser_id, const CancelToken& token,
+                                std::string& output, std::string& error) {
+    WorkspaceIndex& index = GetInstance();
+    if (!index.Open(message, error)) {
+        return false;
+    }
+    output = "{\"root\": \"" + SimpleIPC::EscapeJson(index.GetRoot()) + "\", \"generation\": " +
+             std::to_string(index.GetGeneration()) + "}";
+    return true;
+}
+
+bool WorkspaceIndex::HandleChildren(const std::string& message, int browser_id, const CancelToken& token,
+                                    std::string& output, std::string& error) {
+    uint64_t generation = 0;
+    std::shared_ptr<const WorkspaceTree> tree = GetInstance().GetTree(&generation);
+    if (!tree) {
+        error = "No workspace open";
+        return false;
+    }
+    uint32_t node = tree->Find(message);
+    if (node == WorkspaceTree::kNotFound || !tree->IsDirectory(node)) {
+        error = "Not a directory in the workspace: " + message;
+        return false;
+    }
+
+    output = "{\"generation\": " + std::to_string(generation) + ", \"path\": \"" +
+             SimpleIPC::EscapeJson(tree->GetPath(node)) + "\", \"children\": [";
+    uint32_t first = tree->GetFirstChild(node);
+    uint32_t end = first + tree->GetChildCount(node);
+    for (uint32_t child = first; child < end; ++child) {
+        output += child == first ? "" : ",";
+        output += "{\"name\": \"" + SimpleIPC::EscapeJson(tree->GetName(child)) + "\", \"directory\": " +
+                  (tree->IsDirectory(child) ? "true" : "false") + ", \"size\": " + std::to_string(tree->GetSize(child)) + "}";
+    }
+    output += "]}";
+    return true;
+}
+
+void WorkspaceIndex::RegisterCommands() {
+    SimpleIPC::IPCHandler& ipc = SimpleIPC::IPCHandler::GetInstance();
+    ipc.RegisterAsyncHandler("workspaceOpen", HandleOpen);
+    ipc.RegisterAsyncHandler("workspaceChildren", HandleChildren);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "gitignore.hpp"
+#include "workspace_tree.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Native index of the open workspace's file tree.
+//
+// Directories are read in parallel on the worker pool: every directory is a
+// task that queues its subdirectories on the same worker, and idle workers
+// steal them, so wide and deep trees both keep all cores busy. On Linux the
+// entries come straight from getdents64. .gitignore files are honoured (and
+// .git is always skipped); symlinks are listed but not followed.
+//
+// The page lists directories on demand and receives changes as diffs:
+//
+//   workspaceOpen      root path        -> starts indexing, {"root", "generation"}
+//   workspaceChildren  relative path    -> {"generation", "path", "children": [{"name", "directory", "size"}]}
+//   topic "workspace.tree"              -> {"generation", "reset", "added": [{"path", "directory", "size"}],
+//                                           "changed": [...], "removed": [paths]}
+//
+// Only one scan runs at a time; rescans requested meanwhile are merged into
+// the next one.
+class WorkspaceIndex {
+public:
+    // Called on the worker that built each new tree, one tree at a time in
+    // generation order; |reset| for the first tree of a newly opened root
+    using TreeCallback = std::function<void(const std::string& root, const std::shared_ptr<const WorkspaceTree>& tree,
+                                            const TreeDiff& diff, bool reset)>;
+
+    // Largest number of entries in one workspace.tree event
+    static const size_t kMaxDiffEntries = 2000;
+
+    // Singleton access
+    static WorkspaceIndex& GetInstance();
+
+    // Any thread. Index |root| from scratch, replacing any open workspace.
+    bool Open(const std::string& root, std::string& error);
+
+    // Any thread. Re-read the directories at |paths| (relative to the root);
+    // paths that are not directories in the tree rescan their parent.
+    void Rescan(const std::vector<std::string>& paths);
+
+    // Any thread. Re-read only the entries of the directories at |paths|;
+    // subdirectories keep their contents unless they are new. Meant for
+    // change notifications, where a rescan of the whole subtree is wasted.
+    void Refresh(const std::vector<std::string>& paths);
+
+    // Before the first Open()
+    void AddTreeCallback(TreeCallback callback);
+
+    // Any thread; null until a workspace is open. |generation| (optional)
+    // receives the generation of the returned tree.
+    std::shared_ptr<const WorkspaceTree> GetTree(uint64_t* generation = nullptr) const;
+    std::string GetRoot() const;
+    uint64_t GetGeneration() const;
+
+    // Any thread. The .gitignore rules of the directories above |path|
+    // (relative to |root|), which decide whether |path| is ignored; null if none.
+    static std::shared_ptr<const IgnoreRules> LoadRulesFor(const std::string& root, const std::string& path);
+
+    // Register the workspace IPC methods
+    static void RegisterCommands();
+
+private:
+    struct Scan;
+
+    WorkspaceIndex();
+    ~WorkspaceIndex();
+    WorkspaceIndex(const WorkspaceIndex&);
+    WorkspaceIndex& operator=(const WorkspaceIndex&);
+
+    void StartQueuedScan();
+    void StartScan(const std::set<std::string>& directories, const std::set<std::string>& refreshed, bool reset);
+    void ScanDirectory(std::shared_ptr<Scan> scan, std::string path, std::shared_ptr<const IgnoreRules> rules,
+                       bool recursive);
+    void FinishDirectory(const std::shared_ptr<Scan>& scan);
+    void FinishScan(const std::shared_ptr<Scan>& scan);
+    void PublishDiff(const WorkspaceTree& tree, const TreeDiff& diff, uint64_t generation, bool reset);
+
+    static bool HandleOpen(const std::string& message, int browser_id, const CancelToken& token,
+                           std::string& output, std::string& error);
+    static bool HandleChildren(const std::string& message, int browser_id, const CancelToken& token,
+                               std::string& output, std::string& error);
+
+    mutable std::mutex mutex_;
+    std::string root_;
+    std::shared_ptr<const WorkspaceTree> tree_;
+    uint64_t generation_;
+    std::shared_ptr<Scan> scan_;                // Running scan, if any
+    std::set<std::string> queued_;              // Paths to rescan once the running scan is done
+    std::set<std::string> queued_refresh_;      // Paths to refresh once the running scan is done
+    std::vector<TreeCallback> callbacks_;
+};
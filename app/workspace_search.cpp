@@ -0,0 +1,379 @@
+#include "workspace_search.hpp"
+#include "file_reader.hpp"
+#include "logger.hpp"
+#include "trigram_index.hpp"
+#include "workspace_index.hpp"
+#include "internal/eventbus.hpp"
+#include "internal/simpleipc.hpp"
+#include <algorithm>
+#include <cstring>
+
+struct WorkspaceSearch::Search {
+    uint64_t id;
+    int browser_id;                     // Receiver of the events
+    std::string root;
+    std::shared_ptr<const WorkspaceTree> tree;
+    std::shared_ptr<const SearchPattern> pattern;
+    CancelToken token;
+    std::atomic<size_t> pending;        // Batches not finished, plus one until all are submitted
+    std::atomic<size_t> searched;       // Files read, binaries excluded
+    std::atomic<size_t> matches;        // May overshoot kMaxResults by the workers racing for the last slots
+    std::atomic<uint64_t> bytes;
+    std::atomic<bool> truncated;
+    bool indexed;                       // Only the trigram index's candidates are searched
+    std::chrono::steady_clock::time_point started;
+};
+
+namespace {
+    const char kSearchTopic[] = "workspace.search";
+
+    inline bool IsContinuationByte(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    // {"path", "line", "column", "text", "textOffset"}, the text cut to an
+    // excerpt around the match on whole UTF-8 characters
+    std::string ResultJson(const std::string& path, size_t line, const char* line_begin, const char* line_end,
+                           const char* match) {
+        if (line_end > line_begin && line_end[-1] == '\r') {
+            --line_end;
+        }
+        const char* text = line_begin;
+        const char* text_end = line_end;
+        if (static_cast<size_t>(line_end - line_begin) > WorkspaceSearch::kMaxExcerptBytes) {
+            text = std::max(line_begin, match - static_cast<ptrdiff_t>(WorkspaceSearch::kMaxExcerptBytes / 4));
+            text_end = std::min(line_end, text + WorkspaceSearch::kMaxExcerptBytes);
+            while (text > line_begin && IsContinuationByte(*text)) {
+                --text;
+            }
+            while (text_end < line_end && IsContinuationByte(*text_end)) {
+                --text_end;
+            }
+        }
+        return "{\"path\": \"" + SimpleIPC::EscapeJson(path) + "\", \"line\": " + std::to_string(line) +
+               ", \"column\": " + std::to_string(match - line_begin) + ", \"text\": \"" +
+               SimpleIPC::EscapeJson(std::string_view(text, text_end - text)) + "\", \"textOffset\": " +
+               std::to_string(text - line_begin) + "}";
+    }
+}
+
+WorkspaceSearch::WorkspaceSearch()
+    : next_id_(0) {
+}
+
+WorkspaceSearch::~WorkspaceSearch() {
+}
+
+WorkspaceSearch& WorkspaceSearch::GetInstance() {
+    static WorkspaceSearch instance;
+    return instance;
+}
+
+bool WorkspaceSearch::Start(const std::string& query, bool regex, bool ignore_case, int browser_id, uint64_t& id,
+                            size_t& files, std::string& error) {
+    std::shared_ptr<const SearchPattern> pattern = SearchPattern::Compile(query, regex, ignore_case, error);
+    if (!pattern) {
+        return false;
+    }
+    WorkspaceIndex& index = WorkspaceIndex::GetInstance();
+    std::shared_ptr<const WorkspaceTree> tree = index.GetTree();
+    std::string root = index.GetRoot();
+    if (!tree || root.empty()) {
+        error = "No workspace open";
+        return false;
+    }
+
+    // Only the files the trigram index cannot rule out, when it is up to date
+    std::vector<uint32_t> nodes;
+    std::vector<std::string> candidates;
+    bool indexed = TrigramIndex::GetInstance().Query(tree, *pattern, candidates);
+    if (indexed) {
+        nodes.reserve(candidates.size());
+        for (const std::string& candidate : candidates) {
+            nodes.push_back(tree->Find(candidate));
+        }
+        std::sort(nodes.begin(), nodes.end());
+    } else {
+        nodes.resize(tree->GetNodeCount());
+        for (uint32_t node = 0; node < nodes.size(); ++node) {
+            nodes[node] = node;
+        }
+    }
+
+    // Batches of neighbouring files (siblings are contiguous in the tree), cut
+    // by size so one huge file does not hold up a whole batch of small ones
+    std::vector<std::vector<uint32_t>> batches(1);
+    size_t batch_bytes = 0;
+    files = 0;
+    for (uint32_t node : nodes) {
+        if (node == WorkspaceTree::kNotFound ||
+            (tree->GetFlags(node) & (WorkspaceTree::FLAG_DIRECTORY | WorkspaceTree::FLAG_SYMLINK))) {
+            continue;
+        }
+        if (batch_bytes >= kBatchBytes || batches.back().size() >= kMaxBatchFiles) {
+            batches.emplace_back();
+            batch_bytes = 0;
+        }
+        batches.back().push_back(node);
+        batch_bytes += tree->GetSize(node);
+        ++files;
+    }
+    if (batches.back().empty()) {
+        batches.pop_back();
+    }
+
+    std::shared_ptr<Search> search = std::make_shared<Search>();
+    search->browser_id = browser_id;
+    search->root = root;
+    search->tree = tree;
+    search->pattern = pattern;
+    search->pending.store(batches.size() + 1);
+    search->searched.store(0);
+    search->matches.store(0);
+    search->bytes.store(0);
+    search->truncated.store(false);
+    search->indexed = indexed;
+    search->started = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_) {
+            current_->token.Cancel();
+        }
+        search->id = ++next_id_;
+        current_ = search;
+    }
+    id = search->id;
+
+    for (std::vector<uint32_t>& batch : batches) {
+        if (!WorkerPool::GetInstance().Submit([this, search, batch]() { SearchFiles(search, batch); })) {
+            FinishBatch(search);
+        }
+    }
+    FinishBatch(search);
+    return true;
+}
+
+bool WorkspaceSearch::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!current_) {
+        return false;
+    }
+    current_->token.Cancel();
+    current_ = nullptr;
+    return true;
+}
+
+WorkspaceSearch::TextReader::TextReader()
+    : buffer_(nullptr), offset_(0), filled_(0), consumed_(0), at_end_(true) {
+}
+
+WorkspaceSearch::TextReader::~TextReader() {
+    // A minified file must not pin a buffer its size to the worker
+    if (buffer_ && buffer_->size() > kChunkBytes) {
+        buffer_->resize(kChunkBytes);
+        buffer_->shrink_to_fit();
+    }
+}
+
+bool WorkspaceSearch::TextReader::Open(const std::string& path, std::vector<char>& buffer) {
+    buffer_ = &buffer;
+    offset_ = 0;
+    filled_ = 0;
+    consumed_ = 0;
+    at_end_ = true;
+    if (!file_.Open(path) || file_.GetSize() == 0 || file_.GetSize() > kMaxFileBytes) {
+        return false;
+    }
+    if (buffer.size() < kChunkBytes) {
+        buffer.resize(kChunkBytes);
+    }
+    // The probe first, so binaries cost one small read
+    size_t probe = file_.GetSize() < kBinaryProbeBytes ? static_cast<size_t>(file_.GetSize()) : kBinaryProbeBytes;
+    if (!file_.Read(0, buffer.data(), probe, filled_) || std::memchr(buffer.data(), '\0', filled_)) {
+        return false;
+    }
+    offset_ = filled_;
+    at_end_ = filled_ < probe || offset_ >= file_.GetSize();
+    return filled_ > 0;
+}
+
+bool WorkspaceSearch::TextReader::Next(const char*& data, size_t& size) {
+    std::vector<char>& buffer = *buffer_;
+    if (consumed_ > 0) {
+        std::memmove(buffer.data(), buffer.data() + consumed_, filled_ - consumed_);
+        filled_ -= consumed_;
+        consumed_ = 0;
+    }
+    for (;;) {
+        if (!at_end_ && filled_ < buffer.size()) {
+            uint64_t left = file_.GetSize() - offset_;
+            size_t wanted = buffer.size() - filled_;
+            if (left < wanted) {
+                wanted = static_cast<size_t>(left);
+            }
+            size_t read = 0;
+            if (!file_.Read(offset_, buffer.data() + filled_, wanted, read)) {
+                return false;
+            }
+            offset_ += read;
+            filled_ += read;
+            at_end_ = read < wanted || offset_ >= file_.GetSize();
+        }
+        if (filled_ == 0) {
+            return false;
+        }
+        data = buffer.data();
+        if (at_end_) {
+            size = filled_;
+            consumed_ = filled_;
+            return true;
+        }
+        // Up to the last line break; the rest starts the next chunk
+        size_t cut = filled_;
+        while (cut > 0 && buffer[cut - 1] != '\n') {
+            --cut;
+        }
+        if (cut > 0) {
+            size = cut;
+            consumed_ = cut;
+            return true;
+        }
+        // A single line fills the buffer
+        buffer.resize(buffer.size() * 2);
+    }
+}
+
+// Worker thread
+void WorkspaceSearch::SearchFiles(std::shared_ptr<Search> search, std::vector<uint32_t> files) {
+    // Reused by every batch this worker runs (see TextReader)
+    thread_local std::vector<char> buffer;
+    const SearchPattern& pattern = *search->pattern;
+    std::string results;
+    size_t result_count = 0;
+    auto flush = [&search, &results, &result_count]() {
+        if (result_count > 0) {
+            SimpleIPC::EventBus::GetInstance().Publish(search->browser_id, kSearchTopic,
+                "{\"id\": " + std::to_string(search->id) + ", \"results\": [" + results + "]}");
+            results.clear();
+            result_count = 0;
+        }
+    };
+
+    bool stop = false;
+    for (uint32_t node : files) {
+        if (stop || search->token.IsCancelled() || search->truncated.load(std::memory_order_relaxed)) {
+            break;
+        }
+        std::string path = search->tree->GetPath(node);
+        TextReader reader;
+        if (!reader.Open(search->root + "/" + path, buffer)) {
+            continue;
+        }
+        search->searched.fetch_add(1, std::memory_order_relaxed);
+
+        // Lines are counted lazily, only up to each match and the end of each chunk
+        size_t line = 1;
+        const char* data;
+        size_t size;
+        while (!stop && reader.Next(data, size)) {
+            const char* end = data + size;
+            search->bytes.fetch_add(size, std::memory_order_relaxed);
+            const char* counted = data;
+            const char* cursor = data;
+            const char* line_begin;
+            const char* line_end;
+            const char* match;
+            while (cursor < end && pattern.FindLine(cursor, end, line_begin, line_end, match)) {
+                if (search->matches.fetch_add(1, std::memory_order_relaxed) >= kMaxResults) {
+                    search->truncated.store(true);
+                    stop = true;
+                    break;
+                }
+                line += std::count(counted, line_begin, '\n');
+                counted = line_begin;
+                results += (result_count == 0 ? "" : ",") + ResultJson(path, line, line_begin, line_end, match);
+                if (++result_count == kResultsPerEvent) {
+                    flush();
+                    if (search->token.IsCancelled()) {
+                        stop = true;
+                        break;
+                    }
+                }
+                cursor = line_end + 1;
+            }
+            line += std::count(counted, end, '\n');
+        }
+    }
+    if (!search->token.IsCancelled()) {
+        flush();
+    }
+    FinishBatch(search);
+}
+
+void WorkspaceSearch::FinishBatch(const std::shared_ptr<Search>& search) {
+    if (search->pending.fetch_sub(1) != 1) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_ == search) {
+            current_ = nullptr;
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - search->started);
+    size_t matches = std::min(search->matches.load(), kMaxResults);
+    bool cancelled = search->token.IsCancelled();
+    SimpleIPC::EventBus::GetInstance().Publish(search->browser_id, kSearchTopic,
+        "{\"id\": " + std::to_string(search->id) + ", \"done\": true, \"cancelled\": " + (cancelled ? "true" : "false") +
+        ", \"truncated\": " + (search->truncated.load() ? "true" : "false") +
+        ", \"indexed\": " + (search->indexed ? "true" : "false") +
+        ", \"searched\": " + std::to_string(search->searched.load()) + ", \"matches\": " + std::to_string(matches) +
+        ", \"bytes\": " + std::to_string(search->bytes.load()) + ", \"elapsedMs\": " + std::to_string(elapsed.count()) + "}");
+    Logger::LogVerbose("WorkspaceSearch: #" + std::to_string(search->id) + (cancelled ? " cancelled after " : " searched ") +
+                       std::to_string(search->searched.load()) + " files (" +
+                       std::to_string(search->bytes.load() / (1024 * 1024)) + " MB) in " +
+                       std::to_string(elapsed.count()) + " ms, " + std::to_string(matches) + " matching lines" +
+                       (search->indexed ? " (indexed)" : ""));
+}
+
+bool WorkspaceSearch::HandleSearch(const std::string& message, int browser_id, const CancelToken& token,
+                                   std::string& output, std::string& error) {
+    size_t colon = message.find(':');
+    if (colon == std::string::npos) {
+        error = "Expected <flags>:<query>";
+        return false;
+    }
+    bool regex = false;
+    bool ignore_case = false;
+    for (char flag : message.substr(0, colon)) {
+        if (flag == 'r') {
+            regex = true;
+        } else if (flag == 'i') {
+            ignore_case = true;
+        } else {
+            error = std::string("Unknown search flag: ") + flag;
+            return false;
+        }
+    }
+
+    uint64_t id = 0;
+    size_t files = 0;
+    if (!GetInstance().Start(message.substr(colon + 1), regex, ignore_case, browser_id, id, files, error)) {
+        return false;
+    }
+    output = "{\"id\": " + std::to_string(id) + ", \"files\": " + std::to_string(files) + "}";
+    return true;
+}
+
+bool WorkspaceSearch::HandleCancel(const std::string& message, int browser_id, const CancelToken& token,
+                                   std::string& output, std::string& error) {
+    output = std::string("{\"cancelled\": ") + (GetInstance().Cancel() ? "true" : "false") + "}";
+    return true;
+}
+
+void WorkspaceSearch::RegisterCommands() {
+    SimpleIPC::IPCHandler& ipc = SimpleIPC::IPCHandler::GetInstance();
+    ipc.RegisterAsyncHandler("search", HandleSearch);
+    ipc.RegisterAsyncHandler("searchCancel", HandleCancel);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "file_reader.hpp"
+#include "search_pattern.hpp"
+#include "workspace_tree.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Find in files over the open workspace.
+//
+// The files of the current WorkspaceIndex tree are split into batches of about
+// kBatchBytes and searched on the worker pool, so the IPC call itself returns
+// at once. Files are read in chunks of whole lines into a buffer per worker
+// with positioned reads (see TextReader), so one truncated meanwhile only reads
+// short and a huge file never needs a buffer its size; ones with a NUL byte
+// among their first kBinaryProbeBytes are skipped as binary (the heuristic git
+// uses) without reading further, and ones over kMaxFileBytes are not read at
+// all. When the TrigramIndex is up to date with the
+// tree, only its candidates are read ("indexed" in the summary). Matching
+// lines stream to the page that started the search as they are found:
+//
+//   search         "<flags>:<query>"    -> {"id", "files"}; flags: r = regex, i = ignore case
+//   searchCancel                        -> {"cancelled"}
+//   topic "workspace.search"            -> {"id", "results": [{"path", "line", "column", "text", "textOffset"}]}
+//                                          {"id", "done": true, "cancelled", "truncated", "indexed",
+//                                           "searched", "matches", "bytes", "elapsedMs"}
+//
+// Lines and columns count from 1 and 0; columns are byte offsets. Long lines
+// are cut to an excerpt around the match, starting textOffset bytes in.
+// Starting a search cancels the previous one; a search stops by itself after
+// kMaxResults matching lines.
+class WorkspaceSearch {
+public:
+    static constexpr size_t kMaxResults = 10000;
+    static constexpr size_t kBatchBytes = 2 * 1024 * 1024;
+    static constexpr size_t kMaxBatchFiles = 256;
+    static constexpr size_t kResultsPerEvent = 200;
+    static constexpr size_t kMaxExcerptBytes = 240;
+    static constexpr size_t kBinaryProbeBytes = 8192;
+    static constexpr size_t kChunkBytes = 1024 * 1024;
+    static constexpr uint64_t kMaxFileBytes = 64 * 1024 * 1024;
+
+    // Worker thread. Reads a text file in chunks of whole lines, about
+    // kChunkBytes each, into a buffer the caller keeps across files. The
+    // partial line at the end of a read is carried over into the next chunk;
+    // a line longer than the buffer grows it, and that growth is released
+    // again when the reader goes away. Reads stop at the size the file had
+    // when it was opened.
+    class TextReader {
+    public:
+        TextReader();
+        ~TextReader();
+
+        // False if |path| cannot be read, is empty or larger than
+        // kMaxFileBytes, and for binaries, after reading no more than the probe
+        bool Open(const std::string& path, std::vector<char>& buffer);
+
+        // The next lines, the last one possibly without its newline at the
+        // end of the file. False once the file is done or on a read error.
+        bool Next(const char*& data, size_t& size);
+
+    private:
+        TextReader(const TextReader&);
+        TextReader& operator=(const TextReader&);
+
+        FileReader file_;
+        std::vector<char>* buffer_;
+        uint64_t offset_;           // In the file, of the next read
+        size_t filled_;             // Bytes of the buffer holding file data
+        size_t consumed_;           // Of those, handed out by Next already
+        bool at_end_;
+    };
+
+    // Singleton access
+    static WorkspaceSearch& GetInstance();
+
+    // Any thread. Start searching the workspace for |query|, replacing the
+    // running search; its events go to |browser_id| only, tagged with |id|.
+    // |files| is the number of candidates.
+    bool Start(const std::string& query, bool regex, bool ignore_case, int browser_id, uint64_t& id,
+               size_t& files, std::string& error);
+
+    // Any thread. False if no search was running.
+    bool Cancel();
+
+    // Register search and searchCancel as async IPC methods
+    static void RegisterCommands();
+
+private:
+    struct Search;
+
+    WorkspaceSearch();
+    ~WorkspaceSearch();
+    WorkspaceSearch(const WorkspaceSearch&);
+    WorkspaceSearch& operator=(const WorkspaceSearch&);
+
+    void SearchFiles(std::shared_ptr<Search> search, std::vector<uint32_t> files);
+    void FinishBatch(const std::shared_ptr<Search>& search);
+
+    static bool HandleSearch(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error);
+    static bool HandleCancel(const std::string& message, int browser_id, const CancelToken& token,
+                             std::string& output, std::string& error);
+
+    std::mutex mutex_;
+    std::shared_ptr<Search> current_;
+    uint64_t next_id_;
+};
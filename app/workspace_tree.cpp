@@ -0,0 +1,224 @@
+#include "workspace_tree.hpp"
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+WorkspaceTree::WorkspaceTree()
+    : file_count_(0) {
+    AddNode(std::string_view(), kNotFound, FLAG_DIRECTORY, 0, 0);
+}
+
+uint32_t WorkspaceTree::AddNode(std::string_view name, uint32_t parent, uint8_t flags, uint64_t size, int64_t modified) {
+    uint32_t node = static_cast<uint32_t>(parent_.size());
+    name_offset_.push_back(static_cast<uint32_t>(names_.size()));
+    name_length_.push_back(static_cast<uint16_t>(name.size()));
+    names_.append(name.data(), name.size());
+    parent_.push_back(parent);
+    first_child_.push_back(0);
+    child_count_.push_back(0);
+    flags_.push_back(flags);
+    size_.push_back(size);
+    modified_.push_back(modified);
+    if (!(flags & FLAG_DIRECTORY)) {
+        ++file_count_;
+    }
+    return node;
+}
+
+std::shared_ptr<WorkspaceTree> WorkspaceTree::Build(const WorkspaceTree& old_tree,
+                                                    const std::set<std::string>& rescanned,
+                                                    const std::set<std::string>& refreshed,
+                                                    std::vector<DirectoryListing>& listings) {
+    std::shared_ptr<WorkspaceTree> tree = std::make_shared<WorkspaceTree>();
+    tree->names_.reserve(old_tree.names_.size());
+
+    std::unordered_map<std::string_view, DirectoryListing*> by_path;
+    by_path.reserve(listings.size());
+    for (DirectoryListing& listing : listings) {
+        by_path[listing.path] = &listing;
+    }
+
+    // Name -> offset in the new tree; keys view the listings or the old tree,
+    // both of which outlive the build
+    std::unordered_map<std::string_view, uint32_t> interned;
+    interned.reserve(old_tree.GetNodeCount() / 4 + 64);
+    auto add_child = [&tree, &interned](std::string_view name, uint32_t parent, uint8_t flags,
+                                        uint64_t size, int64_t modified) {
+        uint32_t node = static_cast<uint32_t>(tree->parent_.size());
+        auto it = interned.find(name);
+        if (it == interned.end()) {
+            it = interned.emplace(name, static_cast<uint32_t>(tree->names_.size())).first;
+            tree->names_.append(name.data(), name.size());
+        }
+        tree->name_offset_.push_back(it->second);
+        tree->name_length_.push_back(static_cast<uint16_t>(name.size()));
+        tree->parent_.push_back(parent);
+        tree->first_child_.push_back(0);
+        tree->child_count_.push_back(0);
+        tree->flags_.push_back(flags);
+        tree->size_.push_back(size);
+        tree->modified_.push_back(modified);
+        if (!(flags & FLAG_DIRECTORY)) {
+            ++tree->file_count_;
+        }
+        return node;
+    };
+
+    struct Pending {
+        uint32_t node;
+        uint32_t old_node;      // kNotFound inside a rescanned subtree
+        std::string path;
+        bool rescanned;
+    };
+
+    // Breadth first, so the children of each directory end up contiguous
+    std::deque<Pending> queue;
+    queue.push_back({ kRoot, kRoot, std::string(), rescanned.count(std::string()) > 0 });
+    while (!queue.empty()) {
+        Pending current = std::move(queue.front());
+        queue.pop_front();
+        uint32_t first = static_cast<uint32_t>(tree->parent_.size());
+        std::string prefix = current.path.empty() ? std::string() : current.path + "/";
+
+        auto listing = by_path.end();
+        if (current.rescanned || refreshed.count(current.path)) {
+            listing = by_path.find(current.path);
+        }
+        if (listing != by_path.end()) {
+            std::vector<DirectoryListing::Entry>& entries = listing->second->entries;
+            std::sort(entries.begin(), entries.end(),
+                [](const DirectoryListing::Entry& a, const DirectoryListing::Entry& b) { return a.name < b.name; });
+        }
+
+        if (current.rescanned) {
+            if (listing != by_path.end()) {
+                for (const DirectoryListing::Entry& entry : listing->second->entries) {
+                    uint32_t child = add_child(entry.name, current.node, entry.flags, entry.size, entry.modified);
+                    if (entry.flags & FLAG_DIRECTORY) {
+                        queue.push_back({ child, kNotFound, prefix + entry.name, true });
+                    }
+                }
+            }
+        } else if (listing != by_path.end()) {
+            for (const DirectoryListing::Entry& entry : listing->second->entries) {
+                uint32_t child = add_child(entry.name, current.node, entry.flags, entry.size, entry.modified);
+                if (entry.flags & FLAG_DIRECTORY) {
+                    std::string path = prefix + entry.name;
+                    uint32_t old_child = current.old_node == kNotFound ? kNotFound : old_tree.FindChild(current.old_node, entry.name);
+                    if (old_child != kNotFound && old_tree.IsDirectory(old_child)) {
+                        bool is_rescanned = rescanned.count(path) > 0;
+                        queue.push_back({ child, old_child, std::move(path), is_rescanned });
+                    } else {
+                        // New directory, read in full by the scan
+                        queue.push_back({ child, kNotFound, std::move(path), true });
+                    }
+                }
+            }
+        } else if (current.old_node != kNotFound) {
+            uint32_t begin = old_tree.first_child_[current.old_node];
+            uint32_t end = begin + old_tree.child_count_[current.old_node];
+            for (uint32_t old_child = begin; old_child < end; ++old_child) {
+                std::string_view name = old_tree.GetName(old_child);
+                uint32_t child = add_child(name, current.node, old_tree.flags_[old_child],
+                                           old_tree.size_[old_child], old_tree.modified_[old_child]);
+                if (old_tree.IsDirectory(old_child)) {
+                    std::string path = prefix + std::string(name);
+                    bool is_rescanned = rescanned.count(path) > 0;
+                    queue.push_back({ child, old_child, std::move(path), is_rescanned });
+                }
+            }
+        }
+
+        tree->first_child_[current.node] = first;
+        tree->child_count_[current.node] = static_cast<uint32_t>(tree->parent_.size()) - first;
+    }
+    return tree;
+}
+
+size_t WorkspaceTree::GetMemoryBytes() const {
+    return sizeof(*this) + names_.capacity() +
+           name_offset_.capacity() * sizeof(uint32_t) + name_length_.capacity() * sizeof(uint16_t) +
+           parent_.capacity() * sizeof(uint32_t) + first_child_.capacity() * sizeof(uint32_t) +
+           child_count_.capacity() * sizeof(uint32_t) + flags_.capacity() * sizeof(uint8_t) +
+           size_.capacity() * sizeof(uint64_t) + modified_.capacity() * sizeof(int64_t);
+}
+
+std::string WorkspaceTree::GetPath(uint32_t node) const {
+    std::vector<uint32_t> chain;
+    for (; node != kRoot && node != kNotFound; node = parent_[node]) {
+        chain.push_back(node);
+    }
+    std::string path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!path.empty()) {
+            path += '/';
+        }
+        path.append(GetName(*it));
+    }
+    return path;
+}
+
+uint32_t WorkspaceTree::FindChild(uint32_t directory, std::string_view name) const {
+    uint32_t low = first_child_[directory];
+    uint32_t high = low + child_count_[directory];
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int order = GetName(middle).compare(name);
+        if (order == 0) {
+            return middle;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return kNotFound;
+}
+
+uint32_t WorkspaceTree::Find(std::string_view path) const {
+    uint32_t node = kRoot;
+    while (!path.empty() && node != kNotFound) {
+        size_t slash = path.find('/');
+        std::string_view name = path.substr(0, slash);
+        path = slash == std::string_view::npos ? std::string_view() : path.substr(slash + 1);
+        if (name.empty()) {
+            continue;
+        }
+        node = IsDirectory(node) ? FindChild(node, name) : kNotFound;
+    }
+    return node;
+}
+
+// Children of both directories are sorted by name, so one merge pass pairs them up
+void DiffTrees(const WorkspaceTree& old_tree, uint32_t old_directory,
+               const WorkspaceTree& new_tree, uint32_t new_directory, TreeDiff& diff, bool recursive) {
+    uint32_t old_child = old_tree.GetFirstChild(old_directory);
+    uint32_t old_end = old_child + old_tree.GetChildCount(old_directory);
+    uint32_t new_child = new_tree.GetFirstChild(new_directory);
+    uint32_t new_end = new_child + new_tree.GetChildCount(new_directory);
+
+    while (old_child < old_end || new_child < new_end) {
+        int order = old_child == old_end ? 1 : new_child == new_end ? -1 :
+                    old_tree.GetName(old_child).compare(new_tree.GetName(new_child));
+        if (order < 0) {
+            diff.removed.push_back(old_tree.GetPath(old_child++));
+        } else if (order > 0) {
+            diff.added.push_back(new_child++);
+        } else {
+            if (old_tree.IsDirectory(old_child) != new_tree.IsDirectory(new_child)) {
+                diff.removed.push_back(old_tree.GetPath(old_child));
+                diff.added.push_back(new_child);
+            } else if (new_tree.IsDirectory(new_child)) {
+                if (recursive) {
+                    DiffTrees(old_tree, old_child, new_tree, new_child, diff);
+                }
+            } else if (old_tree.GetSize(old_child) != new_tree.GetSize(new_child) ||
+                       old_tree.GetModified(old_child) != new_tree.GetModified(new_child)) {
+                diff.changed.push_back(new_child);
+            }
+            ++old_child;
+            ++new_child;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One directory as read from disk, before it becomes part of a tree
+struct DirectoryListing {
+    struct Entry {
+        std::string name;
+        uint8_t flags;          // WorkspaceTree::Flags
+        uint64_t size;
+        int64_t modified;       // Change detection only; platform-specific epoch
+    };
+
+    std::string path;           // Relative to the workspace root, "" for the root
+    std::vector<Entry> entries;
+};
+
+// Immutable snapshot of the workspace file tree.
+//
+// Nodes are indices into parallel arrays (struct of arrays), laid out breadth
+// first so the children of a directory are contiguous and sorted by name: a
+// directory listing is one range, a lookup one binary search per component.
+// Names are interned per tree, so the thousands of "index.ts" share one copy.
+// Snapshots are shared between threads through shared_ptr and never change;
+// a rescan builds a new one.
+class WorkspaceTree {
+public:
+    enum Flags : uint8_t {
+        FLAG_DIRECTORY = 1,
+        FLAG_SYMLINK = 2
+    };
+
+    static const uint32_t kRoot = 0;
+    static const uint32_t kNotFound = 0xFFFFFFFFu;
+
+    // Tree holding only the root directory
+    WorkspaceTree();
+
+    // New tree: |old_tree| with the subtrees at |rescanned| (relative directory
+    // paths, none below another) replaced by |listings|, which must cover each
+    // rescanned directory and everything below it that was read. Directories
+    // in |refreshed| take only their own entries from |listings|; subdirectories
+    // they already had keep their old contents, new ones come from |listings|.
+    static std::shared_ptr<WorkspaceTree> Build(const WorkspaceTree& old_tree,
+                                                const std::set<std::string>& rescanned,
+                                                const std::set<std::string>& refreshed,
+                                                std::vector<DirectoryListing>& listings);
+
+    size_t GetNodeCount() const { return parent_.size(); }
+    size_t GetFileCount() const { return file_count_; }
+    size_t GetDirectoryCount() const { return parent_.size() - file_count_; }
+    size_t GetMemoryBytes() const;
+
+    std::string_view GetName(uint32_t node) const {
+        return std::string_view(names_.data() + name_offset_[node], name_length_[node]);
+    }
+    uint32_t GetParent(uint32_t node) const { return parent_[node]; }
+    uint32_t GetFirstChild(uint32_t node) const { return first_child_[node]; }
+    uint32_t GetChildCount(uint32_t node) const { return child_count_[node]; }
+    bool IsDirectory(uint32_t node) const { return (flags_[node] & FLAG_DIRECTORY) != 0; }
+    uint8_t GetFlags(uint32_t node) const { return flags_[node]; }
+    uint64_t GetSize(uint32_t node) const { return size_[node]; }
+    int64_t GetModified(uint32_t node) const { return modified_[node]; }
+
+    // Relative path with '/' separators, "" for the root
+    std::string GetPath(uint32_t node) const;
+
+    uint32_t FindChild(uint32_t directory, std::string_view name) const;
+    uint32_t Find(std::string_view path) const;
+
+private:
+    uint32_t AddNode(std::string_view name, uint32_t parent, uint8_t flags, uint64_t size, int64_t modified);
+
+    std::string names_;                     // Interned names, back to back
+    std::vector<uint32_t> name_offset_;
+    std::vector<uint16_t> name_length_;
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> first_child_;
+    std::vector<uint32_t> child_count_;
+    std::vector<uint8_t> flags_;
+    std::vector<uint64_t> size_;
+    std::vector<int64_t> modified_;
+    size_t file_count_;
+};
+
+// Difference between two trees below one directory. Added directories are
+// reported without their contents; a client lists them when it needs them.
+struct TreeDiff {
+    std::vector<uint32_t> added;            // Nodes of the new tree
+    std::vector<uint32_t> changed;          // Nodes of the new tree (size or time)
+    std::vector<std::string> removed;       // Paths
+
+    size_t GetSize() const { return added.size() + changed.size() + removed.size(); }
+};
+
+// |recursive| false compares the direct children only
+void DiffTrees(const WorkspaceTree& old_tree, uint32_t old_directory,
+               const WorkspaceTree& new_tree, uint32_t new_directory, TreeDiff& diff,
+               bool recursive = true);
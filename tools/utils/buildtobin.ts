@@ -1,90 +1,305 @@
 #!/usr/bin/env bun
 
-import { readFileSync, writeFileSync, existsSync, mkdirSync, statSync } from 'fs';
-import { join, dirname } from 'path';
+import { readFileSync, writeFileSync, existsSync, mkdirSync, statSync, readdirSync } from 'fs';
+import { join, dirname, relative, sep, extname } from 'path';
 import { fileURLToPath } from 'url';
+import { brotliCompressSync, constants as zlibConstants } from 'zlib';
+import { createHash } from 'crypto';
 
 // Get current directory equivalent to Python's __file__
 const __filename = fileURLToPath(import.meta.url);
 const __dirname = dirname(__filename);
 
+interface Asset {
+    path: string;        // URL path served under miko://app, e.g. "/assets/index.js"
+    data: Uint8Array;    // Bytes as stored in the binary (possibly compressed)
+    originalSize: number;
+    encoding: Encoding;
+    etag: string;        // Strong ETag derived from the uncompressed content
+}
+
+// Must match WebAppEncoding in the generated webapp.hpp
+enum Encoding {
+    Identity = 0,
+    Brotli = 1
+}
+
+// Formats that are already compressed gain nothing from another pass
+const PRECOMPRESSED_EXTENSIONS = new Set([
+    '.png', '.jpg', '.jpeg', '.gif', '.webp', '.ico', '.woff', '.woff2', '.gz', '.br', '.zip'
+]);
+
+// Only keep the compressed form when it saves at least this fraction
+const MIN_COMPRESSION_SAVING = 0.1;
+
+// V8 explicit compile hint: compile every function eagerly (and off the main
+// thread while streaming) instead of lazily on first call during startup
+const EAGER_COMPILE_HINT = '//# allFunctionsCalledOnLoad\n';
+
 function readBinaryFile(filePath: string): Uint8Array {
    // """Read binary file and return as Uint8Array"""
     return new Uint8Array(readFileSync(filePath));
 }
 
+function collectAssets(distDir: string): Asset[] {
+    // """Walk webapp/dist and return every file as an asset keyed by URL path"""
+    const assets: Asset[] = [];
+    const walk = (dir: string) => {
+        for (const entry of readdirSync(dir, { withFileTypes: true })) {
+            const fullPath = join(dir, entry.name);
+            if (entry.isDirectory()) {
+                walk(fullPath);
+            } else if (entry.isFile()) {
+                const urlPath = '/' + relative(distDir, fullPath).split(sep).join('/');
+                const data = readBinaryFile(fullPath);
+                assets.push({
+                    path: urlPath,
+                    data,
+                    originalSize: data.length,
+                    encoding: Encoding.Identity,
+                    etag: contentEtag(data)
+                });
+            }
+        }
+    };
+    walk(distDir);
+    assets.sort((a, b) => a.path.localeCompare(b.path));
+    return assets;
+}
+
+function contentEtag(data: Uint8Array): string {
+    // """Strong ETag: truncated SHA-256 of the uncompressed bytes"""
+    return '"' + createHash('sha256').update(data).digest('hex').slice(0, 16) + '"';
+}
+
+function entryScripts(indexHtml: string): Set<string> {
+    // """URL paths of the module scripts index.html loads directly"""
+    const scripts = new Set<string>();
+    const pattern = /<script\b[^>]*\bsrc="([^"]+\.js)"[^>]*>/g;
+    for (const match of indexHtml.matchAll(pattern)) {
+        scripts.add(match[1].startsWith('/') ? match[1] : '/' + match[1].replace(/^\.\//, ''));
+    }
+    return scripts;
+}
+
+function addCompileHints(assets: Asset[]): Asset[] {
+    // """Mark the entry chunks for eager compilation; lazy chunks stay lazy"""
+    const index = assets.find(asset => asset.path === '/index.html');
+    if (!index) {
+        return assets;
+    }
+    const entries = entryScripts(new TextDecoder().decode(index.data));
+    const hint = new TextEncoder().encode(EAGER_COMPILE_HINT);
+
+    return assets.map(asset => {
+        if (!entries.has(asset.path)) {
+            return asset;
+        }
+        // The magic comment only takes effect as the very first line
+        const data = new Uint8Array(hint.length + asset.data.length);
+        data.set(hint, 0);
+        data.set(asset.data, hint.length);
+        return { ...asset, data, originalSize: data.length, etag: contentEtag(data) };
+    });
+}
+
+function bundleHash(assets: Asset[]): string {
+    // """Identity of the whole bundle, derived from every path and content hash"""
+    const hash = createHash('sha256');
+    assets.forEach(asset => hash.update(asset.path + '\0' + asset.etag + '\0'));
+    return hash.digest('hex').slice(0, 16);
+}
+
+function compressAsset(asset: Asset): Asset {
+    // """Brotli-compress an asset when it is worth it; the app decodes it while streaming"""
+    if (PRECOMPRESSED_EXTENSIONS.has(extname(asset.path).toLowerCase()) || asset.data.length === 0) {
+        return asset;
+    }
+
+    const compressed = new Uint8Array(brotliCompressSync(asset.data, {
+        params: {
+            [zlibConstants.BROTLI_PARAM_QUALITY]: zlibConstants.BROTLI_MAX_QUALITY,
+            [zlibConstants.BROTLI_PARAM_SIZE_HINT]: asset.data.length,
+            // 1 MB window bounds the decoder ring buffer per in-flight request
+            [zlibConstants.BROTLI_PARAM_LGWIN]: 20
+        }
+    }));
+
+    if (compressed.length > asset.data.length * (1 - MIN_COMPRESSION_SAVING)) {
+        return asset;
+    }
+    return { ...asset, data: compressed, encoding: Encoding.Brotli };
+}
+
+// Seeded 32-bit FNV-1a, must match ResourceHash::Hash32 in app/resourcehash.hpp
+function hash32(key: string, seed: number): number {
+    const bytes = new TextEncoder().encode(key);
+    let hash = (0x811c9dc5 ^ seed) >>> 0;
+    for (const byte of bytes) {
+        hash ^= byte;
+        hash = Math.imul(hash, 0x01000193) >>> 0;
+    }
+    return hash;
+}
+
+function buildPerfectHash(keys: string[]): { seeds: number[], slots: number[] } {
+    // """Hash-and-displace: find a per-bucket seed so every key lands in its own slot"""
+    const count = keys.length;
+    const seeds = new Array<number>(count).fill(0);
+    const slots = new Array<number>(count).fill(-1);
+
+    const buckets: number[][] = Array.from({ length: count }, () => []);
+    keys.forEach((key, index) => buckets[hash32(key, 0) % count].push(index));
+
+    // Place the largest buckets first while most slots are still free
+    const order = buckets
+        .map((members, bucket) => ({ members, bucket }))
+        .filter(entry => entry.members.length > 0)
+        .sort((a, b) => b.members.length - a.members.length);
+
+    for (const { members, bucket } of order) {
+        for (let seed = 1; ; seed++) {
+            const candidate = members.map(index => hash32(keys[index], seed) % count);
+            const distinct = new Set(candidate).size === candidate.length;
+            if (distinct && candidate.every(slot => slots[slot] === -1)) {
+                candidate.forEach((slot, i) => slots[slot] = members[i]);
+                seeds[bucket] = seed;
+                break;
+            }
+            if (seed > 1_000_000) {
+                throw new Error(`Could not build perfect hash for bucket ${bucket}`);
+            }
+        }
+    }
+
+    return { seeds, slots };
+}
+
 function bytesToCppArray(data: Uint8Array, variableName: string): string {
    // """Convert binary data to C++ byte array format"""
     const bytes = Array.from(data).map(byte => `0x${byte.toString(16).padStart(2, '0')}`);
     const chunks: string[] = [];
-    
+
     // Split into lines of 16 bytes each for readability
     for (let i = 0; i < bytes.length; i += 16) {
         const chunk = bytes.slice(i, i + 16).join(', ');
         chunks.push(`    ${chunk}`);
     }
-    
-    return `const unsigned char ${variableName}[] = {\n${chunks.join(',\n')}\n};\nconst unsigned int ${variableName}_size = ${data.length};`;
+
+    // Keep empty files valid C++ (zero-length arrays are not allowed)
+    if (chunks.length === 0) {
+        chunks.push('    0x00');
+    }
+
+    return `static constexpr unsigned char ${variableName}[] = {\n${chunks.join(',\n')}\n};`;
+}
+
+function cppStringLiteral(value: string): string {
+    return '"' + value.replace(/\\/g, '\\\\').replace(/"/g, '\\"') + '"';
 }
 
 function generateHeaderFile(outputPath: string): void {
     //"""Generate webapp.hpp header file"""
     const headerContent = `#pragma once
+#include <cstddef>
 
-// Auto-generated binary resources from webapp/dist/index.html (single-file with inlined CSS/JS)
+// Auto-generated binary resources from webapp/dist (one entry per asset)
 // Do not edit this file manually
 
-// HTML resource functions (contains inlined CSS and JS)
-const char* GetWebAppHTML();
-unsigned int GetWebAppHTMLSize();
+// How an asset's bytes are stored in the binary
+enum WebAppEncoding {
+    WEBAPP_ENCODING_IDENTITY = 0,
+    WEBAPP_ENCODING_BROTLI = 1
+};
+
+// Embedded asset, addressed by its URL path under miko://app
+struct WebAppAsset {
+    const char* path;
+    const unsigned char* data;
+    unsigned int size;           // Stored (possibly compressed) size
+    unsigned int original_size;  // Size after decoding
+    WebAppEncoding encoding;
+    const char* etag;            // Quoted strong ETag (content hash)
+};
 
-// Placeholder functions for compatibility (not used with single-file build)
-const char* GetWebAppCSS();
-unsigned int GetWebAppCSSSize();
-const char* GetWebAppJS();
-unsigned int GetWebAppJSSize();
+// Look up an asset by URL path through the build-time perfect-hash table.
+// Returns nullptr when the path is not part of the bundle.
+const WebAppAsset* FindWebAppAsset(const char* path, size_t length);
+
+// All embedded assets, indexed by perfect-hash slot
+const WebAppAsset* GetWebAppAssets();
+unsigned int GetWebAppAssetCount();
+
+// Content hash of the whole bundle; changes whenever any asset changes
+const char* GetWebAppBundleHash();
 `;
-    
+
     writeFileSync(outputPath, headerContent, 'utf-8');
 }
 
-function generateCppFile(htmlData: Uint8Array, outputPath: string): void {
+function generateCppFile(assets: Asset[], hash: string, outputPath: string): void {
     //"""Generate webapp.cpp implementation file"""
-    const cppArray = bytesToCppArray(htmlData, 'webapp_html');
-    
+    const { seeds, slots } = buildPerfectHash(assets.map(asset => asset.path));
+
+    const arrays = assets.map((asset, index) =>
+        `// ${asset.path}\n${bytesToCppArray(asset.data, `webapp_asset_${index}`)}`);
+
+    const table = slots.map(index => {
+        const asset = assets[index];
+        const encoding = asset.encoding === Encoding.Brotli ? 'WEBAPP_ENCODING_BROTLI' : 'WEBAPP_ENCODING_IDENTITY';
+        return `    { ${cppStringLiteral(asset.path)}, webapp_asset_${index}, ${asset.data.length}u, ${asset.originalSize}u, ${encoding}, ${cppStringLiteral(asset.etag)} }`;
+    });
+
     const cppContent = `#include "webapp.hpp"
+#include "resourcehash.hpp"
+#include <cstdint>
+#include <cstring>
 
-// Auto-generated binary resources from webapp/dist/index.html (single-file with inlined CSS/JS)
+// Auto-generated binary resources from webapp/dist (one entry per asset)
 // Do not edit this file manually
 
-${cppArray}
+${arrays.join('\n\n')}
 
-const char* GetWebAppHTML() {
-    return reinterpret_cast<const char*>(webapp_html);
-}
+// Perfect-hash displacement seeds, one per bucket
+static constexpr uint32_t webapp_seeds[] = {
+    ${seeds.length > 0 ? seeds.map(seed => `${seed}u`).join(', ') : '0u'}
+};
 
-unsigned int GetWebAppHTMLSize() {
-    return webapp_html_size;
-}
+// Assets ordered by perfect-hash slot
+static constexpr WebAppAsset webapp_assets[] = {
+${table.join(',\n')}
+};
 
-// Placeholder implementations for compatibility (not used with single-file build)
-const char* GetWebAppCSS() {
-    return nullptr; // CSS is inlined in HTML
+static constexpr uint32_t webapp_asset_count = ${assets.length}u;
+
+const WebAppAsset* FindWebAppAsset(const char* path, size_t length) {
+    if (webapp_asset_count == 0) {
+        return nullptr;
+    }
+
+    const WebAppAsset& asset = webapp_assets[
+        ResourceHash::Slot(path, length, webapp_seeds, webapp_asset_count)];
+
+    // Unknown keys still hash to some slot, so verify the path
+    if (std::strlen(asset.path) != length || std::memcmp(asset.path, path, length) != 0) {
+        return nullptr;
+    }
+    return &asset;
 }
 
-unsigned int GetWebAppCSSSize() {
-    return 0; // CSS is inlined in HTML
+const WebAppAsset* GetWebAppAssets() {
+    return webapp_assets;
 }
 
-const char* GetWebAppJS() {
-    return nullptr; // JS is inlined in HTML
+unsigned int GetWebAppAssetCount() {
+    return webapp_asset_count;
 }
 
-unsigned int GetWebAppJSSize() {
-    return 0; // JS is inlined in HTML
+const char* GetWebAppBundleHash() {
+    return ${cppStringLiteral(hash)};
 }
 `;
-    
+
     writeFileSync(outputPath, cppContent, 'utf-8');
 }
 
@@ -92,48 +307,57 @@ function main(): void {
     // Get script directory
     const scriptDir = __dirname;
     const projectRoot = join(scriptDir, '..', '..');
-    
-    // Input file path
-    const htmlFile = join(projectRoot, 'webapp', 'dist', 'index.html');
-    
+
+    // Input directory (full Vite build output)
+    const distDir = join(projectRoot, 'webapp', 'dist');
+    const htmlFile = join(distDir, 'index.html');
+
     // Output file paths
     const appDir = join(projectRoot, 'app');
     const cppFile = join(appDir, 'webapp.cpp');
     const hppFile = join(appDir, 'webapp.hpp');
-    
+
     // Check if input file exists
     if (!existsSync(htmlFile)) {
         console.error(`Error: Input file not found: ${htmlFile}`);
         console.error("Please build the mikobench project first using 'bun run build'");
         process.exit(1);
     }
-    
+
     // Create app directory if it doesn't exist
     if (!existsSync(appDir)) {
         mkdirSync(appDir, { recursive: true });
     }
-    
-    console.log(`Reading HTML file: ${htmlFile}`);
-    const htmlData = readBinaryFile(htmlFile);
-    
+
+    console.log(`Reading assets from: ${distDir}`);
+    const assets = addCompileHints(collectAssets(distDir)).map(compressAsset);
+    const hash = bundleHash(assets);
+
     console.log(`Generating header file: ${hppFile}`);
     generateHeaderFile(hppFile);
-    
+
     console.log(`Generating implementation file: ${cppFile}`);
-    generateCppFile(htmlData, cppFile);
-    
+    generateCppFile(assets, hash, cppFile);
+
+    const totalBytes = assets.reduce((sum, asset) => sum + asset.data.length, 0);
+    const originalBytes = assets.reduce((sum, asset) => sum + asset.originalSize, 0);
+
     console.log('\nConversion completed successfully!');
     console.log('Generated files:');
     console.log(`  - ${hppFile} (${statSync(hppFile).size} bytes)`);
     console.log(`  - ${cppFile} (${statSync(cppFile).size} bytes)`);
-    console.log(`\nHTML data size: ${htmlData.length} bytes`);
-    
+    console.log(`\nBundle hash: ${hash}`);
+    console.log(`Embedded assets: ${assets.length} (${totalBytes} bytes stored, ${originalBytes} bytes uncompressed)`);
+    assets.forEach(asset => {
+        const encoding = asset.encoding === Encoding.Brotli ? `br from ${asset.originalSize}` : 'identity';
+        console.log(`  ${asset.path} (${asset.data.length} bytes, ${encoding})`);
+    });
+
     console.log('\nTo use in your C++ code:');
     console.log('  #include "webapp.hpp"');
-    console.log('  const char* html = GetWebAppHTML();');
-    console.log('  unsigned int size = GetWebAppHTMLSize();');
+    console.log('  const WebAppAsset* asset = FindWebAppAsset(path, length);');
 }
 
 if (import.meta.main) {
     main();
-}
\ No newline at end of file
+}
@@ -1,4 +1,4 @@
-import React from 'react';
+import React, { useEffect } from 'react';
 import TitleBar from './components/TitleBar';
 import HomePage from './pages/home';
 import { AppSidebar } from './components/sidebar';
@@ -23,6 +23,15 @@ const AppContent: React.FC = () => {
 };
 
 const App: React.FC = () => {
+  // Let the native side show the window as soon as the first render is committed
+  useEffect(() => {
+    window.cefQuery?.({
+      request: 'app_ready',
+      onSuccess: () => {},
+      onFailure: () => {}
+    });
+  }, []);
+
   return (
     <AppContent />
   );
@@ -1,19 +1,21 @@
 import { defineConfig } from 'vite'
 import react from '@vitejs/plugin-react'
 import tailwindcss from '@tailwindcss/vite'
-import { viteSingleFile } from 'vite-plugin-singlefile'
 import path from "path"
 
 export default defineConfig({
   plugins: [
     react(), 
-    tailwindcss(), 
-    viteSingleFile()
+    tailwindcss()
   ],
   resolve: {
     alias: {
       "@": path.resolve(__dirname, "./src"),
     },
   },
+  build: {
+    // Keep assets as separate files; buildtobin embeds each one individually
+    assetsInlineLimit: 0
+  },
   assetsInclude: ['**/*.svg']
 })